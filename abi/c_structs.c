@@ -17,6 +17,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include "c_structs.h"
 #include "liblattigo.h"
 
@@ -97,6 +98,171 @@ void free_galois_key(CGaloisKey* gk) {
     free(gk->key_switch_keys);
 }
 
+#define CONTIGUOUS_ALIGNMENT 64
+
+static size_t align_up(size_t size) {
+    return (size + CONTIGUOUS_ALIGNMENT - 1) / CONTIGUOUS_ALIGNMENT * CONTIGUOUS_ALIGNMENT;
+}
+
+// Point the n_component components of polynomial at consecutive slices of data
+static void view_polynomial(CPolynomial* polynomial, CComponent* components, int n_component, uint64_t* data, int n) {
+    polynomial->n_component = n_component;
+    polynomial->components = components;
+    for (int i = 0; i < n_component; i++) {
+        components[i].n = n;
+        components[i].data = data + (size_t)i * n;
+    }
+}
+
+void alloc_plaintext_contiguous(CPlaintext* pt, int level, int n) {
+    int n_component = level + 1;
+    size_t header = align_up(n_component * sizeof(CComponent));
+    size_t data_size = align_up((size_t)n_component * n * sizeof(uint64_t));
+    char* block = (char*)aligned_alloc(CONTIGUOUS_ALIGNMENT, header + data_size);
+    pt->level = level;
+    if (!block) {
+        pt->poly.n_component = 0;
+        pt->poly.components = NULL;
+        return;
+    }
+    view_polynomial(&pt->poly, (CComponent*)block, n_component, (uint64_t*)(block + header), n);
+}
+
+void alloc_ciphertext_contiguous(CCiphertext* ct, int degree, int level, int n) {
+    int n_poly = degree + 1;
+    int n_component = level + 1;
+    size_t polys_size = align_up(n_poly * sizeof(CPolynomial));
+    size_t header = polys_size + align_up((size_t)n_poly * n_component * sizeof(CComponent));
+    size_t data_size = align_up((size_t)n_poly * n_component * n * sizeof(uint64_t));
+    char* block = (char*)aligned_alloc(CONTIGUOUS_ALIGNMENT, header + data_size);
+    ct->degree = degree;
+    ct->level = level;
+    ct->polys = (CPolynomial*)block;
+    if (!block) {
+        return;
+    }
+    CComponent* components = (CComponent*)(block + polys_size);
+    uint64_t* data = (uint64_t*)(block + header);
+    for (int i = 0; i < n_poly; i++) {
+        view_polynomial(&ct->polys[i], components + (size_t)i * n_component, n_component,
+                        data + (size_t)i * n_component * n, n);
+    }
+}
+
+void free_plaintext_contiguous(CPlaintext* pt) {
+    free(pt->poly.components);
+}
+
+void free_ciphertext_contiguous(CCiphertext* ct) {
+    free(ct->polys);
+}
+
+// Whether the components of polynomial lie back to back from data on
+static int polynomial_is_contiguous(const CPolynomial* polynomial, const uint64_t* data) {
+    for (int i = 0; i < polynomial->n_component; i++) {
+        if (polynomial->components[i].data != data + (size_t)i * polynomial->components[0].n) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+uint64_t* plaintext_contiguous_data(const CPlaintext* pt) {
+    uint64_t* data = pt->poly.components[0].data;
+    return polynomial_is_contiguous(&pt->poly, data) ? data : NULL;
+}
+
+uint64_t* ciphertext_contiguous_data(const CCiphertext* ct) {
+    uint64_t* data = ct->polys[0].components[0].data;
+    size_t poly_size = (size_t)ct->polys[0].n_component * ct->polys[0].components[0].n;
+    for (int i = 0; i < ct->degree + 1; i++) {
+        if (!polynomial_is_contiguous(&ct->polys[i], data + i * poly_size)) {
+            return NULL;
+        }
+    }
+    return data;
+}
+
+void alloc_key_switch_key_contiguous(CKeySwitchKey* ksk, int n_public_key, int level, int n_component, int n) {
+    int n_poly = 2 * n_public_key;
+    size_t public_keys_size = align_up(n_public_key * sizeof(CPublicKey));
+    size_t polys_size = align_up(n_poly * sizeof(CPolynomial));
+    size_t header = public_keys_size + polys_size + align_up((size_t)n_poly * n_component * sizeof(CComponent));
+    size_t data_size = align_up((size_t)n_poly * n_component * n * sizeof(uint64_t));
+    char* block = (char*)aligned_alloc(CONTIGUOUS_ALIGNMENT, header + data_size);
+    ksk->public_keys = (CPublicKey*)block;
+    if (!block) {
+        ksk->n_public_key = 0;
+        return;
+    }
+    ksk->n_public_key = n_public_key;
+    CPolynomial* polys = (CPolynomial*)(block + public_keys_size);
+    CComponent* components = (CComponent*)(block + public_keys_size + polys_size);
+    uint64_t* data = (uint64_t*)(block + header);
+    for (int i = 0; i < n_public_key; i++) {
+        ksk->public_keys[i].level = level;
+        ksk->public_keys[i].degree = 1;
+        ksk->public_keys[i].polys = polys + 2 * i;
+    }
+    for (int i = 0; i < n_poly; i++) {
+        view_polynomial(&polys[i], components + (size_t)i * n_component, n_component,
+                        data + (size_t)i * n_component * n, n);
+    }
+}
+
+void free_key_switch_key_contiguous(CKeySwitchKey* ksk) {
+    free(ksk->public_keys);
+}
+
+void free_galois_key_contiguous(CGaloisKey* gk) {
+    for (int i = 0; i < gk->n_key_switch_key; i++) {
+        free_key_switch_key_contiguous(&gk->key_switch_keys[i]);
+    }
+    free(gk->galois_elements);
+    free(gk->key_switch_keys);
+}
+
+uint64_t* key_switch_key_contiguous_data(const CKeySwitchKey* ksk) {
+    uint64_t* data = ciphertext_contiguous_data(&ksk->public_keys[0]);
+    const CPolynomial* poly = &ksk->public_keys[0].polys[0];
+    size_t public_key_size = 2 * (size_t)poly->n_component * poly->components[0].n;
+    for (int i = 1; data && i < ksk->n_public_key; i++) {
+        if (ciphertext_contiguous_data(&ksk->public_keys[i]) != data + i * public_key_size) {
+            return NULL;
+        }
+    }
+    return data;
+}
+
+static void copy_polynomial(const CPolynomial* src, CPolynomial* dest) {
+    for (int i = 0; i < src->n_component; i++) {
+        memcpy(dest->components[i].data, src->components[i].data, src->components[i].n * sizeof(uint64_t));
+    }
+}
+
+void copy_plaintext(const CPlaintext* src, CPlaintext* dest) {
+    uint64_t* src_data = plaintext_contiguous_data(src);
+    uint64_t* dest_data = plaintext_contiguous_data(dest);
+    if (src_data && dest_data) {
+        memcpy(dest_data, src_data, (size_t)src->poly.n_component * src->poly.components[0].n * sizeof(uint64_t));
+    } else {
+        copy_polynomial(&src->poly, &dest->poly);
+    }
+}
+
+void copy_ciphertext(const CCiphertext* src, CCiphertext* dest) {
+    uint64_t* src_data = ciphertext_contiguous_data(src);
+    uint64_t* dest_data = ciphertext_contiguous_data(dest);
+    if (src_data && dest_data) {
+        size_t poly_size = (size_t)src->polys[0].n_component * src->polys[0].components[0].n;
+        memcpy(dest_data, src_data, (src->degree + 1) * poly_size * sizeof(uint64_t));
+    } else {
+        for (int i = 0; i < src->degree + 1; i++) {
+            copy_polynomial(&src->polys[i], &dest->polys[i]);
+        }
+    }
+}
+
 inline void import_bfv_ciphertext(uint64_t dest_handle, CCiphertext* c_ciphertext) {
     ImportBfvCiphertext(dest_handle, c_ciphertext);
 }
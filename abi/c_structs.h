@@ -29,6 +29,42 @@ void free_plaintext(CPlaintext* pt);
 
 void free_ciphertext(CCiphertext* ct);
 
+// Contiguous layout: one 64-byte-aligned block per object holds the polynomial and component structs, followed by the
+// coefficients of all components back to back, polynomial by polynomial, n words each. The pointer-per-component
+// fields are a view into the block, so the object is read and written as any other. Objects of this layout must be
+// freed with the matching free_*_contiguous function, and other objects never with it. If the block cannot be
+// allocated, the components of the plaintext (with n_component 0) or the polynomials of the ciphertext are NULL; the
+// object can still be freed.
+void alloc_plaintext_contiguous(CPlaintext* pt, int level, int n);
+
+void alloc_ciphertext_contiguous(CCiphertext* ct, int degree, int level, int n);
+
+void free_plaintext_contiguous(CPlaintext* pt);
+
+void free_ciphertext_contiguous(CCiphertext* ct);
+
+// First coefficient of the object if its components lie back to back as in the contiguous layout, NULL otherwise
+uint64_t* plaintext_contiguous_data(const CPlaintext* pt);
+
+uint64_t* ciphertext_contiguous_data(const CCiphertext* ct);
+
+// Key switch key of the contiguous layout: one block holds the public keys, each of degree 1 with n_component
+// components per polynomial (Q part, then P part), and the coefficients of all of them back to back, public key by
+// public key. If the block cannot be allocated, public_keys is NULL and n_public_key 0. A Galois key whose key switch
+// keys are all of this layout is freed with free_galois_key_contiguous.
+void alloc_key_switch_key_contiguous(CKeySwitchKey* ksk, int n_public_key, int level, int n_component, int n);
+
+void free_key_switch_key_contiguous(CKeySwitchKey* ksk);
+
+void free_galois_key_contiguous(CGaloisKey* gk);
+
+uint64_t* key_switch_key_contiguous_data(const CKeySwitchKey* ksk);
+
+// Copy the coefficients of src into dest of the same degree, level and n; one memcpy if both are contiguous
+void copy_plaintext(const CPlaintext* src, CPlaintext* dest);
+
+void copy_ciphertext(const CCiphertext* src, CCiphertext* dest);
+
 void alloc_relin_key(CRelinKey* rlk, int n_public_key, int level, int n);
 
 void set_galois_key_steps(CGaloisKey* glk, uint64_t* galois_elements, int n_galois_elements);
@@ -21,6 +21,7 @@
 
 #include "cxx_fhe_task.h"
 #include "nlohmann/json.hpp"
+#include <algorithm>
 #include <map>
 
 namespace lattisense {
@@ -86,28 +87,6 @@ inline void check_with_sig(const CxxVectorArgument& cxx_arg,
     }
 }
 
-/**
- * @brief Check if context keys conform to signature requirements
- */
-inline void check_context_for_key_signatures(const FheContext& context, const nlohmann::json& key_signature) {
-    RelinKey rlk = context.extract_relin_key();
-    fhe_ops_lib::KeySwitchKey ksk = rlk.extract_key_switch_key();
-    int rlk_level_sig = key_signature["rlk"].get<int>();
-    if (rlk_level_sig > ksk.get_level()) {
-        throw std::runtime_error("Level of relin key is smaller than the expected level.");
-    }
-
-    GaloisKey glk = context.extract_galois_key();
-    for (auto& item : key_signature["glk"].items()) {
-        uint64_t gal_el = stoul(item.key());
-        int glk_level_sig = item.value().get<int>();
-        fhe_ops_lib::KeySwitchKey ksk = glk.extract_key_switch_key(gal_el);
-        if (glk_level_sig > ksk.get_level()) {
-            throw std::runtime_error("Level of Galois key is smaller than the expected level.");
-        }
-    }
-}
-
 /**
  * @brief Check if FHE context parameters match JSON configuration
  *
@@ -211,9 +190,10 @@ inline void check_parameter(FheContext* context, const nlohmann::json& param_jso
 /**
  * @brief Check that the context, arguments, and key signatures all conform to the task signature.
  *
+ * The context keys are checked against the key signature when the task acquires them from PublicKeyStore.
+ *
  * Verifies that:
  * - The context type matches the expected algorithm (BFV or CKKS)
- * - The context keys satisfy the key-level requirements in the task signature
  * - Each element of cxx_args matches the expected id, type, shape, and level from the signature
  *
  * @param context       Pointer to the FHE context object
@@ -239,11 +219,20 @@ inline int check_signatures(FheContext* context,
         throw std::runtime_error("Unknown algorithm type");
     }
 
-    check_context_for_key_signatures(*context, task_sig_json["key"]);
-
+    // cxx_args is either the offline arguments alone (offline loading phase), or the online inputs, offline inputs
+    // and online outputs of a run that takes both, in the order of the task's mega_ag inputs
     const auto& offline = task_sig_json["offline"];
-    auto data_sig_json = offline.empty() ? task_sig_json["online"].get<std::vector<nlohmann::json>>() :
-                                           offline.get<std::vector<nlohmann::json>>();
+    auto data_sig_json = task_sig_json["online"].get<std::vector<nlohmann::json>>();
+    if (!offline.empty()) {
+        if (cxx_args.size() == offline.size()) {
+            data_sig_json = offline.get<std::vector<nlohmann::json>>();
+        } else {
+            auto first_out = std::stable_partition(data_sig_json.begin(), data_sig_json.end(), [](const auto& sig) {
+                return sig["phase"].template get<std::string>() == "in";
+            });
+            data_sig_json.insert(first_out, offline.begin(), offline.end());
+        }
+    }
 
     int n_in_args = 0;
 
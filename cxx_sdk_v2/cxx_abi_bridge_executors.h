@@ -77,6 +77,7 @@ using namespace fhe_ops_lib;
  * @note This executor runs in CPU thread pool (custom nodes)
  * @note Input: std::shared_ptr<fhe_ops_lib::Handle> from available_data
  * @note Output: std::shared_ptr<CCiphertext/CPlaintext/etc> stored in std::any
+ * @note Exported public keys are shared through ExportedKeyCache and must not be modified
  */
 inline ExecutorFunc
 create_abi_export_executor(Algo algorithm, bool heterogeneous_mode = true, int mf_nbits = 64, int key_mf_nbits = 64) {
@@ -180,12 +181,15 @@ create_abi_export_executor(Algo algorithm, bool heterogeneous_mode = true, int m
                         break;
                     RelinKey* rlk = static_cast<RelinKey*>(input_ptr.get());
 
-                    CRelinKey* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
-                    export_bfv_relin_key(param.get(), rlk->get(), level, key_mf_nbits, c_rlk);
-                    output = std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
-                        free_relin_key(p);
-                        free(p);
-                    });
+                    output = ExportedKeyCache::get<CRelinKey>(
+                        {rlk->get(), ExportedKeyCache::Kind::RELIN_KEY, level, -1, key_mf_nbits, 0}, [&]() {
+                            CRelinKey* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
+                            export_bfv_relin_key(param.get(), rlk->get(), level, key_mf_nbits, c_rlk);
+                            return std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
+                                free_relin_key(p);
+                                free(p);
+                            });
+                        });
                     break;
                 }
 
@@ -198,14 +202,18 @@ create_abi_export_executor(Algo algorithm, bool heterogeneous_mode = true, int m
 
                     GaloisKey* glk = static_cast<GaloisKey*>(input_ptr.get());
 
-                    CGaloisKey* c_glk = (CGaloisKey*)malloc(sizeof(CGaloisKey));
-                    set_galois_key_steps(c_glk, &galois_element, 1);
-
-                    export_bfv_galois_key(param.get(), glk->get(), level, key_mf_nbits, c_glk);
-                    output = std::shared_ptr<CGaloisKey>(c_glk, [](CGaloisKey* p) {
-                        free_galois_key(p);
-                        free(p);
-                    });
+                    output = ExportedKeyCache::get<CGaloisKey>(
+                        {glk->get(), ExportedKeyCache::Kind::GALOIS_KEY, level, -1, key_mf_nbits, galois_element},
+                        [&]() {
+                            CGaloisKey* c_glk = (CGaloisKey*)malloc(sizeof(CGaloisKey));
+                            set_galois_key_steps(c_glk, &galois_element, 1);
+
+                            export_bfv_galois_key(param.get(), glk->get(), level, key_mf_nbits, c_glk);
+                            return std::shared_ptr<CGaloisKey>(c_glk, [](CGaloisKey* p) {
+                                free_galois_key(p);
+                                free(p);
+                            });
+                        });
                     break;
                 }
 
@@ -327,12 +335,15 @@ create_abi_export_executor(Algo algorithm, bool heterogeneous_mode = true, int m
                         break;
                     RelinKey* rlk = static_cast<RelinKey*>(input_ptr.get());
 
-                    CRelinKey* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
-                    export_ckks_relin_key(param.get(), rlk->get(), level, key_mf_nbits, c_rlk);
-                    output = std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
-                        free_relin_key(p);
-                        free(p);
-                    });
+                    output = ExportedKeyCache::get<CRelinKey>(
+                        {rlk->get(), ExportedKeyCache::Kind::RELIN_KEY, level, -1, key_mf_nbits, 0}, [&]() {
+                            CRelinKey* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
+                            export_ckks_relin_key(param.get(), rlk->get(), level, key_mf_nbits, c_rlk);
+                            return std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
+                                free_relin_key(p);
+                                free(p);
+                            });
+                        });
                     break;
                 }
 
@@ -344,14 +355,18 @@ create_abi_export_executor(Algo algorithm, bool heterogeneous_mode = true, int m
 
                     GaloisKey* glk = static_cast<GaloisKey*>(input_ptr.get());
 
-                    CGaloisKey* c_glk = (CGaloisKey*)malloc(sizeof(CGaloisKey));
-                    set_galois_key_steps(c_glk, &galois_element, 1);
-
-                    export_ckks_galois_key(param.get(), glk->get(), level, key_mf_nbits, c_glk);
-                    output = std::shared_ptr<CGaloisKey>(c_glk, [](CGaloisKey* p) {
-                        free_galois_key(p);
-                        free(p);
-                    });
+                    output = ExportedKeyCache::get<CGaloisKey>(
+                        {glk->get(), ExportedKeyCache::Kind::GALOIS_KEY, level, -1, key_mf_nbits, galois_element},
+                        [&]() {
+                            CGaloisKey* c_glk = (CGaloisKey*)malloc(sizeof(CGaloisKey));
+                            set_galois_key_steps(c_glk, &galois_element, 1);
+
+                            export_ckks_galois_key(param.get(), glk->get(), level, key_mf_nbits, c_glk);
+                            return std::shared_ptr<CGaloisKey>(c_glk, [](CGaloisKey* p) {
+                                free_galois_key(p);
+                                free(p);
+                            });
+                        });
                     break;
                 }
 
@@ -360,12 +375,15 @@ create_abi_export_executor(Algo algorithm, bool heterogeneous_mode = true, int m
                         break;
                     KeySwitchKey* swk = static_cast<KeySwitchKey*>(input_ptr.get());
 
-                    CKeySwitchKey* c_swk = (CKeySwitchKey*)malloc(sizeof(CKeySwitchKey));
-                    export_ckks_switching_key(param.get(), swk->get(), level, sp_level, key_mf_nbits, c_swk);
-                    output = std::shared_ptr<CKeySwitchKey>(c_swk, [](CKeySwitchKey* p) {
-                        free_relin_key(p);  // CKeySwitchKey is typedef of CRelinKey
-                        free(p);
-                    });
+                    output = ExportedKeyCache::get<CKeySwitchKey>(
+                        {swk->get(), ExportedKeyCache::Kind::SWITCH_KEY, level, sp_level, key_mf_nbits, 0}, [&]() {
+                            CKeySwitchKey* c_swk = (CKeySwitchKey*)malloc(sizeof(CKeySwitchKey));
+                            export_ckks_switching_key(param.get(), swk->get(), level, sp_level, key_mf_nbits, c_swk);
+                            return std::shared_ptr<CKeySwitchKey>(c_swk, [](CKeySwitchKey* p) {
+                                free_relin_key(p);  // CKeySwitchKey is typedef of CRelinKey
+                                free(p);
+                            });
+                        });
                     break;
                 }
 
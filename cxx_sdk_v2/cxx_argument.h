@@ -21,6 +21,13 @@
 
 #include <vector>
 #include <string>
+#include <climits>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <typeindex>
 #include <unordered_map>
 #include <stdexcept>
@@ -159,10 +166,108 @@ inline void export_cxx_arguments(const std::vector<CxxVectorArgument>& cxx_args,
 }
 
 /**
- * @brief Per-instance storage for extracted public keys.
+ * @brief Process-wide cache of the public keys that heterogeneous tasks export to ABI C structs.
  *
- * Owned by FheTask so that key lifetime is tied to the FheTask instance,
- * avoiding the thread-safety and multi-instance hazards of static locals.
+ * Exports are keyed by the key handle, the kind of key, its level and special-prime level, the Montgomery bits and the
+ * Galois element, and reused by every later run and task. Only the keys of live PublicKeyStorage entries are cached;
+ * their exports are dropped with the entry, i.e. when the context keys change and no task holds the old keys any more.
+ * Different keys are exported concurrently, and a key asked for by several threads at once is exported once.
+ */
+class ExportedKeyCache {
+public:
+    enum class Kind { RELIN_KEY, GALOIS_KEY, SWITCH_KEY };
+
+    using Id = std::tuple<uint64_t, Kind, int, int, int, uint64_t>;  // handle, kind, level, sp_level, mf_nbits, element
+
+    /**
+     * @brief The export of `id`, running `export_key` on first use. Keys not held by a PublicKeyStorage entry are
+     * exported on every call.
+     */
+    template <typename T>
+    static std::shared_ptr<T> get(const Id& id, const std::function<std::shared_ptr<T>()>& export_key) {
+        Cache& cache = instance();
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            if (cache.handles.count(std::get<0>(id))) {
+                std::shared_ptr<Entry>& slot = cache.entries[id];
+                if (!slot) {
+                    slot = std::make_shared<Entry>();
+                }
+                entry = slot;
+            }
+        }
+        if (!entry) {
+            return export_key();
+        }
+        // Held only by the threads waiting for this key; if the export throws, the next caller retries it
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (!entry->value) {
+            entry->value = export_key();
+        }
+        return std::static_pointer_cast<T>(entry->value);
+    }
+
+    // Start caching the exports of these key handles
+    static void add_handles(const std::vector<uint64_t>& handles) {
+        Cache& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for (uint64_t handle : handles) {
+            cache.handles[handle]++;
+        }
+    }
+
+    // Drop the exports of these key handles once no entry holds them
+    static void remove_handles(const std::vector<uint64_t>& handles) {
+        Cache& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        for (uint64_t handle : handles) {
+            auto it = cache.handles.find(handle);
+            if (it == cache.handles.end() || --it->second > 0) {
+                continue;
+            }
+            cache.handles.erase(it);
+            Id first{handle, Kind::RELIN_KEY, INT_MIN, INT_MIN, INT_MIN, 0};
+            Id last{handle + 1, Kind::RELIN_KEY, INT_MIN, INT_MIN, INT_MIN, 0};
+            cache.entries.erase(cache.entries.lower_bound(first), cache.entries.lower_bound(last));
+        }
+    }
+
+    // Number of exported keys in the cache
+    static size_t size() {
+        Cache& cache = instance();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        size_t n = 0;
+        for (const auto& [id, entry] : cache.entries) {
+            std::lock_guard<std::mutex> entry_lock(entry->mutex);
+            n += entry->value != nullptr;
+        }
+        return n;
+    }
+
+private:
+    struct Entry {
+        std::mutex mutex;
+        std::shared_ptr<void> value;
+    };
+
+    struct Cache {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, int> handles;  // Handles of live PublicKeyStorage entries, with their count
+        std::map<Id, std::shared_ptr<Entry>> entries;
+    };
+
+    static Cache& instance() {
+        static Cache cache;
+        return cache;
+    }
+};
+
+/**
+ * @brief Public keys extracted from a context for a key signature.
+ *
+ * Shared by all tasks and runs through PublicKeyStore and never modified once built, so that the Handle* pointers
+ * handed to the MegaAG graph stay valid for as long as a task holds the entry.
  */
 struct PublicKeyStorage {
     RelinKey saved_rlk;
@@ -173,12 +278,160 @@ struct PublicKeyStorage {
     GaloisKey* glk_handle = nullptr;
     KeySwitchKey* swk_dts_handle = nullptr;
     KeySwitchKey* swk_std_handle = nullptr;
+
+    PublicKeyStorage() = default;
+    PublicKeyStorage(const PublicKeyStorage&) = delete;
+    PublicKeyStorage& operator=(const PublicKeyStorage&) = delete;
+
+    ~PublicKeyStorage() {
+        ExportedKeyCache::remove_handles(key_handles());
+    }
+
+    // Handles of the extracted keys
+    std::vector<uint64_t> key_handles() const {
+        std::vector<uint64_t> handles;
+        for (const Handle* key : std::initializer_list<const Handle*>{rlk_handle, glk_handle, swk_dts_handle,
+                                                                       swk_std_handle}) {
+            if (key) {
+                handles.push_back(key->get());
+            }
+        }
+        return handles;
+    }
+};
+
+/**
+ * @brief Process-wide, reference-counted store of the public keys used by tasks.
+ *
+ * Entries are keyed by the context, its key version and the key signature of the task. The keys of an entry are
+ * extracted and their levels checked against the signature once, then shared by every task and run that asks for the
+ * same entry, until the context keys change (see FheContext::get_key_version()). An entry lives as long as a task
+ * holds it. Different entries are extracted concurrently, and an entry asked for by several threads at once is
+ * extracted once.
+ */
+class PublicKeyStore {
+public:
+    /**
+     * @brief Get the keys of `context` required by `key_signature`, extracting them on first use.
+     * @throws std::runtime_error if a key is missing from the context or its level is below the signature
+     */
+    static std::shared_ptr<const PublicKeyStorage> acquire(FheContext* context, const nlohmann::json& key_signature) {
+        Store& store = instance();
+        auto id = std::make_tuple(context->get(), context->get_key_version(), key_signature.dump());
+        std::promise<std::shared_ptr<const PublicKeyStorage>> promise;
+        std::shared_future<std::shared_ptr<const PublicKeyStorage>> pending;
+        {
+            std::lock_guard<std::mutex> lock(store.mutex);
+            for (auto it = store.entries.begin(); it != store.entries.end();) {
+                bool idle = !it->second.pending.valid() && it->second.keys.expired();
+                it = idle ? store.entries.erase(it) : std::next(it);
+            }
+            auto it = store.entries.find(id);
+            if (it == store.entries.end()) {
+                store.entries[id].pending = promise.get_future().share();
+            } else if (auto keys = it->second.keys.lock()) {
+                return keys;
+            } else {
+                pending = it->second.pending;
+            }
+        }
+        if (pending.valid()) {
+            // Another thread is extracting the keys of this entry
+            return pending.get();
+        }
+        // Extract outside the store lock, so that other entries are not held up; a failed extraction is dropped
+        // (and rethrown to the threads waiting for it) so that the next caller retries it
+        std::shared_ptr<const PublicKeyStorage> keys;
+        try {
+            keys = extract(context, key_signature);
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(store.mutex);
+                store.entries.erase(id);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(store.mutex);
+            Entry& entry = store.entries[id];
+            entry.keys = keys;
+            entry.pending = {};
+        }
+        promise.set_value(keys);
+        return keys;
+    }
+
+    // Number of entries held by tasks
+    static size_t size() {
+        Store& store = instance();
+        std::lock_guard<std::mutex> lock(store.mutex);
+        size_t n = 0;
+        for (const auto& entry : store.entries) {
+            n += !entry.second.keys.expired();
+        }
+        return n;
+    }
+
+private:
+    struct Entry {
+        std::weak_ptr<const PublicKeyStorage> keys;
+        // Valid while the keys are being extracted
+        std::shared_future<std::shared_ptr<const PublicKeyStorage>> pending;
+    };
+
+    struct Store {
+        std::mutex mutex;
+        std::map<std::tuple<uint64_t, uint64_t, std::string>, Entry> entries;
+    };
+
+    static Store& instance() {
+        static Store store;
+        return store;
+    }
+
+    static std::shared_ptr<PublicKeyStorage> extract(FheContext* context, const nlohmann::json& key_signature) {
+        auto keys = std::make_shared<PublicKeyStorage>();
+        if (key_signature["rlk"].get<int>() >= 0) {
+            keys->saved_rlk = context->extract_relin_key();
+            if (key_signature["rlk"].get<int>() > keys->saved_rlk.extract_key_switch_key().get_level()) {
+                throw std::runtime_error("Level of relin key is smaller than the expected level.");
+            }
+            keys->rlk_handle = &keys->saved_rlk;
+        }
+        if (!key_signature["glk"].empty()) {
+            keys->saved_glk = context->extract_galois_key();
+            for (auto& item : key_signature["glk"].items()) {
+                uint64_t gal_el = stoul(item.key());
+                if (item.value().get<int>() > keys->saved_glk.extract_key_switch_key(gal_el).get_level()) {
+                    throw std::runtime_error("Level of Galois key is smaller than the expected level.");
+                }
+            }
+            keys->glk_handle = &keys->saved_glk;
+        }
+        if (key_signature.contains("ckks_btp_swk")) {
+            auto& swk_sig = key_signature["ckks_btp_swk"];
+            CkksBtpContext* btp_context = dynamic_cast<CkksBtpContext*>(context);
+            if (btp_context == nullptr) {
+                throw std::runtime_error("Context is not CkksBtpContext but ckks_btp_swk is required");
+            }
+            if (swk_sig.contains("swk_dts")) {
+                keys->saved_swk_dts = btp_context->extract_swk_dts();
+                keys->swk_dts_handle = &keys->saved_swk_dts;
+            }
+            if (swk_sig.contains("swk_std")) {
+                keys->saved_swk_std = btp_context->extract_swk_std();
+                keys->swk_std_handle = &keys->saved_swk_std;
+            }
+        }
+        ExportedKeyCache::add_handles(keys->key_handles());
+        return keys;
+    }
 };
 
 inline void export_public_key_arguments(nlohmann::json& key_signature,
                                         std::vector<CArgument>& input_args,
-                                        FheContext* context,
-                                        PublicKeyStorage& keys) {
+                                        const PublicKeyStorage& keys) {
     if (key_signature["rlk"].get<int>() >= 0) {
         CArgument rlk_arg;
         int rlk_level = key_signature["rlk"].get<int>();
@@ -188,8 +441,6 @@ inline void export_public_key_arguments(nlohmann::json& key_signature,
         rlk_arg.level = rlk_level;
 
         // Use Handle* pointers; ABI conversion is performed by the EXPORT_TO_ABI node in the MegaAG graph
-        keys.saved_rlk = context->extract_relin_key();
-        keys.rlk_handle = &keys.saved_rlk;
         rlk_arg.data = (void*)&keys.rlk_handle;
 
         input_args.push_back(rlk_arg);
@@ -208,18 +459,12 @@ inline void export_public_key_arguments(nlohmann::json& key_signature,
         glk_arg.level = glk_level;
 
         // Use Handle* pointers; ABI conversion is performed by the EXPORT_TO_ABI node in the MegaAG graph
-        keys.saved_glk = context->extract_galois_key();
-        keys.glk_handle = &keys.saved_glk;
         glk_arg.data = (void*)&keys.glk_handle;
 
         input_args.push_back(glk_arg);
     }
     if (key_signature.contains("ckks_btp_swk")) {
         auto& swk_sig = key_signature["ckks_btp_swk"];
-        CkksBtpContext* btp_context = dynamic_cast<CkksBtpContext*>(context);
-        if (btp_context == nullptr) {
-            throw std::runtime_error("Context is not CkksBtpContext but ckks_btp_swk is required");
-        }
 
         if (swk_sig.contains("swk_dts")) {
             CArgument swk_dts_arg;
@@ -232,8 +477,6 @@ inline void export_public_key_arguments(nlohmann::json& key_signature,
             swk_dts_arg.level = level;
 
             // Use Handle* pointers; ABI conversion is performed by the EXPORT_TO_ABI node in the MegaAG graph
-            keys.saved_swk_dts = btp_context->extract_swk_dts();
-            keys.swk_dts_handle = &keys.saved_swk_dts;
             swk_dts_arg.data = (void*)&keys.swk_dts_handle;
 
             input_args.push_back(swk_dts_arg);
@@ -250,8 +493,6 @@ inline void export_public_key_arguments(nlohmann::json& key_signature,
             swk_std_arg.level = level;
 
             // Use Handle* pointers; ABI conversion is performed by the EXPORT_TO_ABI node in the MegaAG graph
-            keys.saved_swk_std = btp_context->extract_swk_std();
-            keys.swk_std_handle = &keys.saved_swk_std;
             swk_std_arg.data = (void*)&keys.swk_std_handle;
 
             input_args.push_back(swk_std_arg);
@@ -19,6 +19,10 @@
 #ifndef CXX_FHE_TASK_H
 #define CXX_FHE_TASK_H
 
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
 #include <unordered_map>
 #include <vector>
 #include "nlohmann/json.hpp"
@@ -42,6 +46,129 @@ using namespace fhe_ops_lib;
 /// @note Called from worker threads. Throttled to at most once per 100ms internally.
 using ProgressCallback = std::function<void(int completed, int total)>;
 
+/// Output-ready callback for streaming results out of a running task.
+/// @param output_id Id of the output argument.
+/// @param item_index Position of the written item among the flattened items of the argument.
+/// @note Called from worker threads, possibly concurrently.
+using OutputReadyCallback = std::function<void(const std::string& output_id, uint64_t item_index)>;
+
+/// Thrown when a task run is cancelled or passes its deadline.
+class TaskCancelledError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Handle of a task run started by FheTaskCpu::run_async().
+ *
+ * Destroying the handle waits for the run to finish, since the run writes to the caller's output arguments.
+ */
+class FheTaskRun {
+public:
+    FheTaskRun() = default;
+
+    /**
+     * @brief Request cancellation. The run dispatches no further compute nodes, waits for the running ones and
+     * releases its intermediate data; get() then throws TaskCancelledError. Can be called from any thread.
+     */
+    void cancel();
+
+    /**
+     * @brief Wait for the run to finish, at most `timeout`.
+     * @return true if the run has finished
+     */
+    bool wait_for(std::chrono::milliseconds timeout) const;
+
+    /**
+     * @brief Wait for the run to finish and get its result. Can be called once.
+     * @return Task execution time in nanoseconds
+     * @throws TaskCancelledError if the run was cancelled or passed its deadline
+     * @throws The first error thrown by a compute node, or any other error of run()
+     */
+    uint64_t get();
+
+private:
+    friend class FheTaskCpu;
+
+    std::shared_ptr<cpu_run_control_st> _control;
+    std::future<uint64_t> _future;
+};
+
+/// Options of one tenant of a CpuRuntime.
+struct CpuTenantOptions {
+    uint32_t weight = 1;               ///< Share of the pool relative to the other tenants with active runs, at least 1
+    int32_t priority = 0;              ///< Priority of the tenant's jobs waiting in the pool, higher runs first
+    uint32_t max_concurrent_runs = 0;  ///< Runs admitted at once, further runs wait; 0 for no limit
+};
+
+/**
+ * @brief Worker pool shared by the runs of several CPU tasks, so that concurrent runs do not each start a pool of
+ * their own and oversubscribe the machine.
+ *
+ * Each task attached with FheTaskCpu::set_runtime() runs as a tenant. While the pool is saturated, its workers are
+ * divided among the tenants with active runs in proportion to their weights, and each run dispatches its ready nodes
+ * in critical-path order within its share. Copies share the same pool, which lives until the last copy and the last
+ * task attached to it are gone.
+ */
+class CpuRuntime {
+public:
+    /**
+     * @param num_threads Number of worker threads; 0 (the default) for min(32, hardware threads)
+     */
+    explicit CpuRuntime(uint32_t num_threads = 0);
+
+    /**
+     * @brief Configure a tenant. Tenants are created on first use with the default options.
+     */
+    void set_tenant(const std::string& tenant, const CpuTenantOptions& options);
+
+    /**
+     * @brief Metrics of a tenant since it was first used: runs completed, failed and in progress, runs waiting for
+     * admission, pool jobs run with their total wall time, and the total admission wait.
+     */
+    cpu_tenant_stats_t get_tenant_stats(const std::string& tenant) const;
+
+    /**
+     * @brief Admit runs only while the intermediate data of the admitted runs fit in `budget_bytes`; further runs
+     * wait in arrival order. Each run reserves the peak estimated from its graph (levels, degrees, fan-out and
+     * schedule order), scaled by how the peaks of the task's past runs compared with the estimate, or its actual
+     * peak so far if larger. A run larger than the budget is admitted once it is alone.
+     * @param budget_bytes Budget; UINT64_MAX (the default) for none
+     */
+    void set_memory_budget(uint64_t budget_bytes);
+
+    /**
+     * @brief Intermediate bytes currently reserved by the admitted runs.
+     */
+    uint64_t reserved_bytes() const;
+
+private:
+    friend class FheTaskCpu;
+
+    std::shared_ptr<cpu_runtime_st> _handle;
+};
+
+/**
+ * @brief Connection of one process (rank) of distributed task runs to the other ranks on the same host, over Unix
+ * domain sockets in a directory they share. Peers are connected on first use, waiting up to 30 s for them to start.
+ * Copies share the same connection, which lives until the last copy and the last task attached to it are gone.
+ */
+class UnixSocketTransport {
+public:
+    /**
+     * @param dir Directory of the socket files, created if missing; empty for /tmp
+     * @param rank Rank of this process, in [0, n_ranks)
+     * @param n_ranks Number of processes
+     * @throws std::runtime_error if the socket of this rank cannot be created
+     */
+    UnixSocketTransport(const std::string& dir, uint32_t rank, uint32_t n_ranks);
+
+private:
+    friend class FheTaskCpu;
+
+    std::shared_ptr<cpu_transport_st> _handle;
+};
+
 class FheTask {
 public:
     FheTask() = default;
@@ -101,7 +228,7 @@ protected:
 
     std::vector<CArgument> input_args;
     std::vector<CArgument> output_args;
-    PublicKeyStorage _key_storage;
+    std::shared_ptr<const PublicKeyStorage> _key_storage;  // Entry of PublicKeyStore used by the last run
 
     void new_args(int n_in_args, int n_out_args);
     void free_args();
@@ -114,19 +241,187 @@ protected:
     virtual void bind_abi_executors() = 0;
 };
 
+/**
+ * @brief Engine that runs the compute nodes of a CPU task
+ */
+enum class CpuBackend {
+    LATTIGO,  // Lattigo through cgo; supports every operation
+    NATIVE,   // Native vectorized kernels (AVX2 / AVX-512 / IFMA, chosen at run time) on the exported ABI structs;
+              // supports add, sub and negate, and for CKKS also mult without relinearization, rescale, drop_level
+              // and ct-pt multiply-accumulate. Produces the same words as LATTIGO.
+};
+
 class FheTaskCpu : public FheTask {
 public:
     using FheTask::FheTask;
 
-    FheTaskCpu(const std::string& project_path);
+    /**
+     * @param project_path Path of the compiled task
+     * @param backend Engine of the compute nodes
+     * @throws std::runtime_error with CpuBackend::NATIVE if the task has an operation the native kernels do not
+     * support
+     */
+    FheTaskCpu(const std::string& project_path, CpuBackend backend = CpuBackend::LATTIGO);
     ~FheTaskCpu();
 
     void bind_custom_executors(const std::unordered_map<std::string, ExecutorFunc>& custom_executors) override;
+
+    /**
+     * @brief Coalesce cheap compute nodes (add, sub, negate, mult without relinearization, drop_level) that become
+     * ready together and share op type and output level, running up to `max_coalesce` of them in one thread-pool job.
+     * This saves scheduling overhead on graphs with many small operations.
+     * @param max_coalesce Maximum group size; 1 (the default) disables coalescing
+     */
+    void set_max_coalesce(uint64_t max_coalesce);
+
+    /**
+     * @brief Fuse linear chains: when a compute node is the sole consumer of another node's result, e.g. mult →
+     * relinearize → rescale, run it right after its producer in the same thread-pool job and pass the result on
+     * directly instead of publishing it to the scheduler. On by default.
+     * @param enable Whether to fuse chains
+     */
+    void set_chain_fusion(bool enable);
+
+    /**
+     * @brief Compute only some of the outputs: later runs execute just the compute nodes that the listed output
+     * arguments depend on, and progress is reported over those nodes. The other output arguments must still be passed
+     * to run() but are left untouched.
+     * @param output_ids Ids of the output arguments to compute; empty (the default) computes all of them
+     * @throws std::invalid_argument at run time if an id is not an output argument of the task
+     */
+    void set_requested_outputs(const std::vector<std::string>& output_ids);
+
+    /**
+     * @brief Run the compute nodes that produce output arguments ahead of all other ready nodes, so that outputs
+     * finish as early as their dependencies allow instead of waiting behind the longest paths of the graph. Off by
+     * default.
+     * @param enable Whether to prioritize output-producing nodes
+     */
+    void set_output_priority(bool enable);
+
+    /**
+     * @brief Call `callback` as soon as each item of an output argument has been written during run(), so that the
+     * caller can decrypt, serialize or send it while the rest of the graph is still running. The item must not be
+     * modified until run() returns, and run() returns only after every call has returned. An exception thrown by the
+     * callback stops the run and is rethrown by run().
+     * @param callback Callback; an empty function (the default) disables it
+     */
+    void set_output_ready_callback(OutputReadyCallback callback);
+
+    /**
+     * @brief Sample process RSS and the live intermediate data held by the runner every `interval_ms` milliseconds
+     * during each run. The sampled peaks are reported by
+     * get_stats(), and the samples can be written to a CSV file for tools/plot_mem.py.
+     * @param interval_ms Sampling interval; 0 (the default) disables the monitor
+     * @param csv_path CSV file rewritten on each run; empty for none
+     */
+    void set_mem_monitor(uint32_t interval_ms, const std::string& csv_path = "");
+
+    /**
+     * @brief Run the task on the worker pool of a shared runtime as the given tenant, instead of starting a pool for
+     * each run. A run waits for admission if the tenant is at its concurrency limit; get_stats() reports the wait.
+     * @param runtime Shared runtime; nullptr (the default) for a pool of the task's own
+     * @param tenant Tenant of the task's runs
+     */
+    void set_runtime(const CpuRuntime* runtime, const std::string& tenant = "default");
+
+    /**
+     * @brief Out-of-core execution: while the live intermediate bytes of a run exceed `threshold_bytes`, serialize
+     * the intermediate ciphertexts whose consumers are furthest from running to a scratch file, and read them back
+     * ahead of their consumers. Trades disk I/O for memory on graphs whose intermediates do not fit in RAM;
+     * get_stats() reports the bytes spilled and read back.
+     * @param threshold_bytes Live intermediate bytes above which data are spilled; UINT64_MAX (the default) disables
+     * spilling
+     * @param dir Directory of the scratch file, which is removed with the process; empty for /tmp. It must be on a
+     * disk: spilling to a tmpfs, as /tmp often is, frees no memory
+     */
+    void set_spill(uint64_t threshold_bytes, const std::string& dir = "");
+
+    /**
+     * @brief Checkpoint and resume: every `interval_ms` milliseconds, save the compute nodes completed by the run and
+     * the intermediate data they left in `dir`, writing only the data not saved by an earlier checkpoint. A later run
+     * with the same graph and input ciphertexts, e.g. in a new process after a crash, resumes from the checkpoint and
+     * skips the completed nodes. A run with plaintext or custom inputs is not checkpointed, as their content cannot
+     * be checked on resume. The checkpoint is removed when a run finishes; get_stats() reports the nodes resumed and
+     * the checkpoint bytes written.
+     * @param dir Checkpoint directory, created if missing; empty disables checkpoints (the default)
+     * @param interval_ms Time between checkpoints; 0 only resumes from an existing checkpoint
+     */
+    void set_checkpoint(const std::string& dir, uint32_t interval_ms = 60000);
+
+    /**
+     * @brief Distributed runs: run the task as one rank of several processes connected by `transport`. The compute
+     * nodes are partitioned among the ranks, balancing their work weighted by level and keeping the ciphertext bytes
+     * sent between ranks small; each rank runs its part and sends the ciphertexts the others read. Every rank must
+     * run the same task with the same input arguments, in the same sequence of runs; the output arguments are written
+     * on rank 0 only. Distributed runs do not use constant folding, incremental mode or checkpoints, and a run fails
+     * on every rank if one rank fails. get_stats() reports the nodes left to other ranks and the bytes exchanged.
+     * @param transport Connection to the other ranks; nullptr (the default) runs the task alone
+     */
+    void set_transport(const UnixSocketTransport* transport);
+
+    /**
+     * @brief Fold the constant part of the task: compute nodes (add, sub, negate, mult without relinearization,
+     * rescale, drop_level, ct-pt multiply-accumulate) whose inputs all derive from offline inputs run once, and their
+     * results are reused by later runs instead of being recomputed. The cache is dropped when any offline argument is
+     * a different object or has been assigned a new value since it was filled. On by default.
+     * @param enable Whether to fold; disabling also drops the cached results
+     */
+    void set_constant_folding(bool enable);
+
+    /**
+     * @brief Incremental re-execution: keep the intermediate results of each run, and in the next run re-execute only
+     * the compute nodes downstream of the input arguments that changed, i.e. are a different object or have been
+     * assigned a new value. Results that do not fit in the memory budget are not kept and are recomputed when needed.
+     * Custom operators are assumed to be deterministic. get_stats() reports the nodes run and reused.
+     * @param enable Whether to run incrementally; off by default
+     * @param memory_budget_bytes Maximum estimated bytes of kept results
+     */
+    void set_incremental(bool enable, uint64_t memory_budget_bytes = UINT64_MAX);
+
+    /**
+     * @brief Drop the cached constant and incremental results, so that the next run recomputes them. Needed only if
+     * an input is modified in place without being assigned a new value.
+     */
+    void invalidate_constant_cache();
+
+    /**
+     * @brief Statistics of the last run: wall time, exact peak of live intermediate bytes, the sampled peak of RSS
+     * if the memory monitor is on, the number of compute nodes run and skipped by constant folding or
+     * incremental reuse, the bytes kept for incremental runs, the bytes spilled to disk and read back, the
+     * checkpoints written and nodes resumed, and the nodes left to other ranks and bytes exchanged with them.
+     */
+    cpu_task_stats_t get_stats() const;
+
+    /**
+     * @brief Run the task and wait for it to finish.
+     * @throws The first error thrown by a compute node; the run stops dispatching nodes after an error
+     */
     uint64_t
     run(FheContext* context, const std::vector<CxxVectorArgument>& cxx_args, ProgressCallback progress_cb = nullptr);
 
+    /**
+     * @brief Start the task on a separate thread and return at once. The returned handle waits for the result, and
+     * cancels the run. Only one run of a task may be in flight at a time, and `context` and the arguments must stay
+     * valid until the run has finished.
+     * @param timeout Time after which the run is cancelled; zero (the default) for no deadline
+     * @return Handle of the run
+     */
+    FheTaskRun run_async(FheContext* context,
+                         const std::vector<CxxVectorArgument>& cxx_args,
+                         ProgressCallback progress_cb = nullptr,
+                         std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
 protected:
     void bind_abi_executors() override;
+
+    uint64_t run_controlled(FheContext* context,
+                            const std::vector<CxxVectorArgument>& cxx_args,
+                            ProgressCallback progress_cb,
+                            cpu_run_control control);
+
+    OutputReadyCallback _output_ready_cb;
+    CpuBackend _backend = CpuBackend::LATTIGO;
 };
 
 class FheTaskGpu : public FheTask {
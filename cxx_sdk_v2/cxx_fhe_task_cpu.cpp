@@ -20,6 +20,7 @@
 #include <unordered_map>
 #include <vector>
 #include <chrono>
+#include <future>
 
 #include "cxx_fhe_task.h"
 #include "cxx_abi_bridge_executors.h"
@@ -30,15 +31,22 @@ extern "C" {
 
 namespace lattisense {
 
-FheTaskCpu::FheTaskCpu(const std::string& project_path) : FheTask{project_path} {
-    task_handle = create_fhe_cpu_task(project_path.c_str());
+FheTaskCpu::FheTaskCpu(const std::string& project_path, CpuBackend backend)
+    : FheTask{project_path}, _backend{backend} {
+    if (backend == CpuBackend::NATIVE) {
+        task_handle = create_fhe_cpu_native_task(project_path.c_str());
+    } else {
+        task_handle = create_fhe_cpu_task(project_path.c_str());
+    }
 
     bind_abi_executors();
 }
 
 void FheTaskCpu::bind_abi_executors() {
-    ExecutorFunc abi_export = create_abi_export_executor(_algo, false);
-    ExecutorFunc abi_import = create_abi_import_executor(_algo, false);
+    // The native kernels work on the C structs, so their task exports and imports as the heterogeneous ones do
+    bool heterogeneous = _backend == CpuBackend::NATIVE;
+    ExecutorFunc abi_export = create_abi_export_executor(_algo, heterogeneous);
+    ExecutorFunc abi_import = create_abi_import_executor(_algo, heterogeneous);
     bind_cpu_task_abi_bridge_executors(task_handle, reinterpret_cast<void*>(&abi_export),
                                        reinterpret_cast<void*>(&abi_import));
 }
@@ -59,8 +67,98 @@ void FheTaskCpu::bind_custom_executors(const std::unordered_map<std::string, Exe
     bind_cpu_task_custom_executors(task_handle, custom_types.data(), executor_ptrs.data(), custom_types.size());
 }
 
+void FheTaskCpu::set_max_coalesce(uint64_t max_coalesce) {
+    set_cpu_task_max_coalesce(task_handle, max_coalesce);
+}
+
+void FheTaskCpu::set_chain_fusion(bool enable) {
+    set_cpu_task_chain_fusion(task_handle, enable);
+}
+
+void FheTaskCpu::set_requested_outputs(const std::vector<std::string>& output_ids) {
+    std::vector<const char*> ids;
+    for (const auto& id : output_ids) {
+        ids.push_back(id.c_str());
+    }
+    set_cpu_task_requested_outputs(task_handle, ids.data(), ids.size());
+}
+
+void FheTaskCpu::set_output_priority(bool enable) {
+    set_cpu_task_output_priority(task_handle, enable);
+}
+
+void FheTaskCpu::set_output_ready_callback(OutputReadyCallback callback) {
+    _output_ready_cb = std::move(callback);
+    if (!_output_ready_cb) {
+        set_cpu_task_output_ready_callback(task_handle, nullptr, nullptr);
+        return;
+    }
+    output_ready_callback_t c_cb = [](const char* output_id, uint64_t item_index, void* ud) {
+        (*static_cast<OutputReadyCallback*>(ud))(output_id, item_index);
+    };
+    set_cpu_task_output_ready_callback(task_handle, c_cb, &_output_ready_cb);
+}
+
+void FheTaskCpu::set_mem_monitor(uint32_t interval_ms, const std::string& csv_path) {
+    set_cpu_task_mem_monitor(task_handle, interval_ms, csv_path.c_str());
+}
+
+void FheTaskCpu::set_runtime(const CpuRuntime* runtime, const std::string& tenant) {
+    set_cpu_task_runtime(task_handle, runtime ? runtime->_handle.get() : nullptr, tenant.c_str());
+}
+
+void FheTaskCpu::set_spill(uint64_t threshold_bytes, const std::string& dir) {
+    set_cpu_task_spill(task_handle, threshold_bytes, dir.c_str());
+}
+
+void FheTaskCpu::set_checkpoint(const std::string& dir, uint32_t interval_ms) {
+    set_cpu_task_checkpoint(task_handle, dir.c_str(), interval_ms);
+}
+
+void FheTaskCpu::set_transport(const UnixSocketTransport* transport) {
+    set_cpu_task_transport(task_handle, transport ? transport->_handle.get() : nullptr);
+}
+
+void FheTaskCpu::set_constant_folding(bool enable) {
+    set_cpu_task_constant_folding(task_handle, enable);
+}
+
+void FheTaskCpu::set_incremental(bool enable, uint64_t memory_budget_bytes) {
+    set_cpu_task_incremental(task_handle, enable, memory_budget_bytes);
+}
+
+void FheTaskCpu::invalidate_constant_cache() {
+    invalidate_cpu_task_constant_cache(task_handle);
+}
+
+cpu_task_stats_t FheTaskCpu::get_stats() const {
+    cpu_task_stats_t stats;
+    get_cpu_task_stats(task_handle, &stats);
+    return stats;
+}
+
 uint64_t
 FheTaskCpu::run(FheContext* context, const std::vector<CxxVectorArgument>& cxx_args, ProgressCallback progress_cb) {
+    return run_controlled(context, cxx_args, progress_cb, nullptr);
+}
+
+FheTaskRun FheTaskCpu::run_async(FheContext* context,
+                                 const std::vector<CxxVectorArgument>& cxx_args,
+                                 ProgressCallback progress_cb,
+                                 std::chrono::milliseconds timeout) {
+    FheTaskRun run;
+    uint64_t timeout_ms = timeout.count() > 0 ? timeout.count() : 0;
+    run._control = std::shared_ptr<cpu_run_control_st>(create_cpu_run_control(timeout_ms), release_cpu_run_control);
+    run._future = std::async(std::launch::async, [this, context, cxx_args, progress_cb, control = run._control]() {
+        return run_controlled(context, cxx_args, progress_cb, control.get());
+    });
+    return run;
+}
+
+uint64_t FheTaskCpu::run_controlled(FheContext* context,
+                                    const std::vector<CxxVectorArgument>& cxx_args,
+                                    ProgressCallback progress_cb,
+                                    cpu_run_control control) {
     auto start = std::chrono::high_resolution_clock::now();
 
     int n_in_args = 0, n_out_args = 0;
@@ -75,7 +173,8 @@ FheTaskCpu::run(FheContext* context, const std::vector<CxxVectorArgument>& cxx_a
 
     export_cxx_arguments(cxx_args, input_args, output_args);
 
-    export_public_key_arguments(key_signature, input_args, context, _key_storage);
+    _key_storage = PublicKeyStore::acquire(context, key_signature);
+    export_public_key_arguments(key_signature, input_args, *_key_storage);
 
     // Wrap std::function into C callback
     progress_callback_t c_cb = nullptr;
@@ -88,9 +187,12 @@ FheTaskCpu::run(FheContext* context, const std::vector<CxxVectorArgument>& cxx_a
         c_ud = &progress_cb;
     }
 
-    int ret = run_fhe_cpu_task(task_handle, input_args.data(), input_args.size(), output_args.data(),
-                               output_args.size(), c_cb, c_ud);
+    int ret = run_fhe_cpu_task_controlled(task_handle, input_args.data(), input_args.size(), output_args.data(),
+                                          output_args.size(), c_cb, c_ud, control);
 
+    if (ret == CPU_RUN_CANCELLED) {
+        throw TaskCancelledError("CPU task run was cancelled");
+    }
     if (ret != 0) {
         throw std::runtime_error("Failed to run CPU project");
     }
@@ -104,4 +206,43 @@ FheTaskCpu::run(FheContext* context, const std::vector<CxxVectorArgument>& cxx_a
     return duration.count();
 }
 
+CpuRuntime::CpuRuntime(uint32_t num_threads)
+    : _handle(create_cpu_runtime(num_threads), release_cpu_runtime) {}
+
+void CpuRuntime::set_tenant(const std::string& tenant, const CpuTenantOptions& options) {
+    set_cpu_runtime_tenant(_handle.get(), tenant.c_str(), options.weight, options.priority,
+                           options.max_concurrent_runs);
+}
+
+cpu_tenant_stats_t CpuRuntime::get_tenant_stats(const std::string& tenant) const {
+    cpu_tenant_stats_t stats;
+    get_cpu_runtime_tenant_stats(_handle.get(), tenant.c_str(), &stats);
+    return stats;
+}
+
+void CpuRuntime::set_memory_budget(uint64_t budget_bytes) {
+    set_cpu_runtime_memory_budget(_handle.get(), budget_bytes);
+}
+
+uint64_t CpuRuntime::reserved_bytes() const {
+    return get_cpu_runtime_reserved_bytes(_handle.get());
+}
+
+UnixSocketTransport::UnixSocketTransport(const std::string& dir, uint32_t rank, uint32_t n_ranks)
+    : _handle(create_unix_socket_transport(dir.c_str(), rank, n_ranks), release_cpu_transport) {}
+
+void FheTaskRun::cancel() {
+    if (_control) {
+        cancel_cpu_run(_control.get());
+    }
+}
+
+bool FheTaskRun::wait_for(std::chrono::milliseconds timeout) const {
+    return _future.wait_for(timeout) == std::future_status::ready;
+}
+
+uint64_t FheTaskRun::get() {
+    return _future.get();
+}
+
 }  // namespace lattisense
@@ -86,7 +86,8 @@ uint64_t FheTaskGpu::run(FheContext* context,
     // Export cxx arguments to Handle (same as CPU wrapper)
     export_cxx_arguments(cxx_args, input_args, output_args);
 
-    export_public_key_arguments(key_signature, input_args, context, _key_storage);
+    _key_storage = PublicKeyStore::acquire(context, key_signature);
+    export_public_key_arguments(key_signature, input_args, *_key_storage);
 
     // Wrap std::function into C callback
     progress_callback_t c_cb = nullptr;
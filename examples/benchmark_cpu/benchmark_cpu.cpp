@@ -18,10 +18,17 @@
 
 #include <cxx_sdk_v2/cxx_fhe_task.h>
 #include <fhe_ops_lib/fhe_lib_v2.h>
+#include <fhe_ops_lib/utils.h>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
 
+extern "C" {
+#include <abi/c_structs.h>
+}
+
 using namespace lattisense;
 
 void benchmark_bfv_mult_relin() {
@@ -33,14 +40,15 @@ void benchmark_bfv_mult_relin() {
     BfvParameter param = BfvParameter::create_parameter(n, t);
     BfvContext ctx = BfvContext::create_random_context(param);
 
-    std::vector<BfvCiphertext> xs, ys, zs;
+    std::vector<std::vector<uint64_t>> x_mgs, y_mgs;
+    std::vector<BfvCiphertext> zs;
     for (int i = 0; i < n_op; i++) {
-        std::vector<uint64_t> x_mg = {uint64_t(i + 2)};
-        std::vector<uint64_t> y_mg = {uint64_t(i + 3)};
-        xs.push_back(ctx.encrypt_asymmetric(ctx.encode(x_mg, level)));
-        ys.push_back(ctx.encrypt_asymmetric(ctx.encode(y_mg, level)));
+        x_mgs.push_back({uint64_t(i + 2)});
+        y_mgs.push_back({uint64_t(i + 3)});
         zs.push_back(ctx.new_ciphertext(level));
     }
+    std::vector<BfvCiphertext> xs = ctx.encrypt_asymmetric_batch(ctx.encode_batch(x_mgs, level));
+    std::vector<BfvCiphertext> ys = ctx.encrypt_asymmetric_batch(ctx.encode_batch(y_mgs, level));
 
     FheTaskCpu task("bfv_mult_relin");
     std::vector<CxxVectorArgument> args = {{"xs", &xs}, {"ys", &ys}, {"zs", &zs}};
@@ -60,14 +68,15 @@ void benchmark_ckks_mult_relin() {
     CkksParameter param = CkksParameter::create_parameter(n);
     CkksContext ctx = CkksContext::create_random_context(param);
 
-    std::vector<CkksCiphertext> xs, ys, zs;
+    std::vector<std::vector<double>> x_mgs, y_mgs;
+    std::vector<CkksCiphertext> zs;
     for (int i = 0; i < n_op; i++) {
-        std::vector<double> x_mg = {double(i + 2)};
-        std::vector<double> y_mg = {double(i + 3)};
-        xs.push_back(ctx.encrypt_asymmetric(ctx.encode(x_mg, level, scale)));
-        ys.push_back(ctx.encrypt_asymmetric(ctx.encode(y_mg, level, scale)));
+        x_mgs.push_back({double(i + 2)});
+        y_mgs.push_back({double(i + 3)});
         zs.push_back(ctx.new_ciphertext(level, scale * scale));
     }
+    std::vector<CkksCiphertext> xs = ctx.encrypt_asymmetric_batch(ctx.encode_batch(x_mgs, level, scale));
+    std::vector<CkksCiphertext> ys = ctx.encrypt_asymmetric_batch(ctx.encode_batch(y_mgs, level, scale));
 
     FheTaskCpu task("ckks_mult_relin");
     std::vector<CxxVectorArgument> args = {{"xs", &xs}, {"ys", &ys}, {"zs", &zs}};
@@ -88,14 +97,14 @@ void benchmark_bfv_rotate_col() {
     BfvContext ctx = BfvContext::create_random_context(param);
     ctx.gen_rotation_keys();
 
-    std::vector<BfvCiphertext> xs, ys;
+    std::vector<std::vector<uint64_t>> x_mgs(n_op, std::vector<uint64_t>(n / 2));
+    std::vector<BfvCiphertext> ys;
     for (int i = 0; i < n_op; i++) {
-        std::vector<uint64_t> x_mg(n / 2);
         for (uint64_t j = 0; j < n / 2; j++)
-            x_mg[j] = i + j;
-        xs.push_back(ctx.encrypt_asymmetric(ctx.encode(x_mg, level)));
+            x_mgs[i][j] = i + j;
         ys.push_back(ctx.new_ciphertext(level));
     }
+    std::vector<BfvCiphertext> xs = ctx.encrypt_asymmetric_batch(ctx.encode_batch(x_mgs, level));
 
     FheTaskCpu task("bfv_rotate_col");
     std::vector<CxxVectorArgument> args = {{"xs", &xs}, {"ys", &ys}};
@@ -106,11 +115,200 @@ void benchmark_bfv_rotate_col() {
     printf("BFV rotate_col: %d ops, %.2f ms, %.1f ops/sec\n", n_op, time_ns / 1.0e6, n_op / (time_ns / 1.0e9));
 }
 
+// Dense matrix-vector product with n_diag diagonals, once as a single BSGS linear_transform node and once
+// hand-rolled as rotate + mult + add nodes. Both tasks evaluate the same product.
+void benchmark_ckks_linear_transform(bool unrolled) {
+    const int n_op = 16;
+    const int n_diag = 64;
+    const int n1 = 8;
+    const uint64_t n = 16384;
+    const double scale = pow(2, 40);
+    const int level = 3;
+
+    CkksParameter param = CkksParameter::create_parameter(n);
+    CkksContext ctx = CkksContext::create_random_context(param);
+    int n_slot = n / 2;
+
+    std::vector<int32_t> steps;
+    if (unrolled) {
+        for (int k = 1; k < n_diag; k++)
+            steps.push_back(k);
+    } else {
+        for (int i = 1; i < n1; i++)
+            steps.push_back(i);
+        for (int g = n1; g < n_diag; g += n1)
+            steps.push_back(g);
+    }
+    ctx.gen_rotation_keys_for_rotations(steps);
+
+    std::vector<CkksCiphertext> xs, ys;
+    std::vector<std::vector<CkksPlaintextMul>> ds(n_op);
+    for (int i = 0; i < n_op; i++) {
+        xs.push_back(ctx.encrypt_asymmetric(ctx.encode(fhe_ops_lib::rand_double_values(n_slot), level, scale)));
+        for (int k = 0; k < n_diag; k++) {
+            std::vector<double> diag = fhe_ops_lib::rand_double_values(n_slot);
+            int giant = unrolled ? 0 : k - k % n1;
+            ds[i].push_back(ctx.encode_mul(fhe_ops_lib::vec_rotate(diag, -giant), level, scale));
+        }
+        ys.push_back(ctx.new_ciphertext(level, scale * scale));
+    }
+
+    FheTaskCpu task(unrolled ? "ckks_linear_transform_unrolled" : "ckks_linear_transform");
+    std::vector<CxxVectorArgument> args = {{"xs", &xs}, {"ds", &ds}, {"ys", &ys}};
+    uint64_t time_ns = task.run(&ctx, args, [](int done, int total) {
+        printf("[Progress] %d/%d (%.0f%%)\n", done, total, 100.0 * done / total);
+    });
+
+    printf("CKKS linear_transform (%s): %d ops x %d diagonals, %.2f ms, %.1f ops/sec\n",
+           unrolled ? "unrolled" : "bsgs", n_op, n_diag, time_ns / 1.0e6, n_op / (time_ns / 1.0e9));
+}
+
+// Per-node scheduling overhead: chains of 64 negations at level 0, where each node does little work, run with and
+// without chain fusion.
+void benchmark_ckks_chain_fusion() {
+    const int n_op = 256;
+    const int chain_len = 64;
+    const uint64_t n = 16384;
+    const double scale = pow(2, 40);
+    const int level = 0;
+
+    CkksParameter param = CkksParameter::create_parameter(n);
+    CkksContext ctx = CkksContext::create_random_context(param);
+
+    std::vector<std::vector<double>> x_mgs;
+    for (int i = 0; i < n_op; i++)
+        x_mgs.push_back({double(i + 2)});
+    std::vector<CkksCiphertext> xs = ctx.encrypt_asymmetric_batch(ctx.encode_batch(x_mgs, level, scale));
+
+    FheTaskCpu task("ckks_neg_chain");
+    for (bool fuse : {false, true}) {
+        std::vector<CkksCiphertext> ys;
+        for (int i = 0; i < n_op; i++)
+            ys.push_back(ctx.new_ciphertext(level, scale));
+
+        task.set_chain_fusion(fuse);
+        std::vector<CxxVectorArgument> args = {{"xs", &xs}, {"ys", &ys}};
+        uint64_t time_ns = task.run(&ctx, args);
+        uint64_t n_nodes = task.get_stats().n_computes_run;
+        printf("CKKS neg chain, fusion %s: %d chains of %d, %.2f ms, %.2f us/node\n", fuse ? "on" : "off", n_op,
+               chain_len, time_ns / 1.0e6, time_ns / 1.0e3 / n_nodes);
+    }
+}
+
+// Per-node dispatch overhead: one chain of 4096 negations at level 0, fused into a single job, against the same
+// negations called directly on the context. The difference per node is what the runner adds to each operation.
+void benchmark_ckks_dispatch_overhead() {
+    const int chain_len = 4096;
+    const uint64_t n = 16384;
+    const double scale = pow(2, 40);
+    const int level = 0;
+
+    CkksParameter param = CkksParameter::create_parameter(n);
+    CkksContext ctx = CkksContext::create_random_context(param);
+
+    CkksCiphertext x = ctx.encrypt_asymmetric(ctx.encode(std::vector<double>{2.0}, level, scale));
+    CkksCiphertext y = ctx.new_ciphertext(level, scale);
+
+    FheTaskCpu task("ckks_neg_dispatch");
+    task.set_chain_fusion(true);
+    std::vector<CxxVectorArgument> args = {{"x", &x}, {"y", &y}};
+    uint64_t task_ns = task.run(&ctx, args);
+    uint64_t n_nodes = task.get_stats().n_computes_run;
+
+    auto start = std::chrono::steady_clock::now();
+    CkksCiphertext z = ctx.negate(x);
+    for (int i = 1; i < chain_len; i++)
+        z = ctx.negate(z);
+    uint64_t direct_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    double task_us = task_ns / 1.0e3 / n_nodes;
+    double direct_us = direct_ns / 1.0e3 / chain_len;
+    printf("CKKS neg dispatch: %d nodes, task %.2f us/node, direct %.2f us/op, overhead %.2f us/node\n", chain_len,
+           task_us, direct_us, task_us - direct_us);
+}
+
+// ABI ciphertext layouts: allocating and freeing 256 ciphertexts, copying them into one another, and copying them
+// into a flat staging buffer in device order (what a GPU export does), once with a malloc per component and once
+// with the contiguous layout, where each of these is a single call per ciphertext.
+void benchmark_abi_layout() {
+    const int n_ct = 256;
+    const int n = 16384;
+    const int degree = 1;
+    const int level = 3;
+    const size_t ct_words = (size_t)(degree + 1) * (level + 1) * n;
+
+    auto elapsed_ms = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::vector<uint64_t> staging(ct_words);
+
+    for (bool contiguous : {false, true}) {
+        std::vector<CCiphertext> xs(n_ct), ys(n_ct);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_ct; i++) {
+            if (contiguous) {
+                alloc_ciphertext_contiguous(&xs[i], degree, level, n);
+                alloc_ciphertext_contiguous(&ys[i], degree, level, n);
+            } else {
+                alloc_ciphertext(&xs[i], degree, level, n);
+                alloc_ciphertext(&ys[i], degree, level, n);
+            }
+        }
+        double alloc_ms = elapsed_ms(start);
+        // Touch every page before the copies are timed
+        for (int i = 0; i < n_ct; i++)
+            for (int p = 0; p <= degree; p++)
+                for (int j = 0; j <= level; j++) {
+                    std::fill_n(xs[i].polys[p].components[j].data, n, uint64_t(p + j));
+                    std::fill_n(ys[i].polys[p].components[j].data, n, uint64_t(0));
+                }
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_ct; i++)
+            copy_ciphertext(&xs[i], &ys[i]);
+        double copy_ms = elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const auto& x : xs) {
+            if (const uint64_t* data = ciphertext_contiguous_data(&x)) {
+                memcpy(staging.data(), data, ct_words * sizeof(uint64_t));
+                continue;
+            }
+            for (int p = 0; p <= degree; p++)
+                for (int j = 0; j <= level; j++)
+                    memcpy(&staging[((size_t)p * (level + 1) + j) * n], x.polys[p].components[j].data,
+                           n * sizeof(uint64_t));
+        }
+        double export_ms = elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_ct; i++) {
+            if (contiguous) {
+                free_ciphertext_contiguous(&xs[i]);
+                free_ciphertext_contiguous(&ys[i]);
+            } else {
+                free_ciphertext(&xs[i]);
+                free_ciphertext(&ys[i]);
+            }
+        }
+        double free_ms = elapsed_ms(start);
+
+        printf("ABI layout %s: %d ciphertexts, alloc %.2f ms, copy %.2f ms, export %.2f ms, free %.2f ms\n",
+               contiguous ? "contiguous" : "per-component", n_ct, alloc_ms, copy_ms, export_ms, free_ms);
+    }
+}
+
 int main(int argc, char* argv[]) {
-    const char* help = "Usage: benchmark_cpu <0|1|2|all>\n"
+    const char* help = "Usage: benchmark_cpu <0|1|2|3|4|5|6|7|all>\n"
                        "  0: BFV mult_relin\n"
                        "  1: CKKS mult_relin\n"
                        "  2: BFV rotate_col\n"
+                       "  3: CKKS linear_transform (BSGS)\n"
+                       "  4: CKKS linear_transform (unrolled)\n"
+                       "  5: CKKS chain fusion\n"
+                       "  6: CKKS per-node dispatch overhead\n"
+                       "  7: ABI ciphertext layouts\n"
                        "  all: Run all benchmarks\n";
 
     if (argc != 2) {
@@ -124,10 +322,25 @@ int main(int argc, char* argv[]) {
         benchmark_ckks_mult_relin();
     } else if (strcmp(argv[1], "2") == 0) {
         benchmark_bfv_rotate_col();
+    } else if (strcmp(argv[1], "3") == 0) {
+        benchmark_ckks_linear_transform(false);
+    } else if (strcmp(argv[1], "4") == 0) {
+        benchmark_ckks_linear_transform(true);
+    } else if (strcmp(argv[1], "5") == 0) {
+        benchmark_ckks_chain_fusion();
+    } else if (strcmp(argv[1], "6") == 0) {
+        benchmark_ckks_dispatch_overhead();
+    } else if (strcmp(argv[1], "7") == 0) {
+        benchmark_abi_layout();
     } else if (strcmp(argv[1], "all") == 0) {
         benchmark_bfv_mult_relin();
         benchmark_ckks_mult_relin();
         benchmark_bfv_rotate_col();
+        benchmark_ckks_linear_transform(false);
+        benchmark_ckks_linear_transform(true);
+        benchmark_ckks_chain_fusion();
+        benchmark_ckks_dispatch_overhead();
+        benchmark_abi_layout();
     } else {
         printf("%s", help);
     }
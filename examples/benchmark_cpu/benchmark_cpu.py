@@ -75,7 +75,101 @@ def bfv_rotate_col():
     )
 
 
+def ckks_linear_transform():
+    param = CkksParam.create_default_param(n=16384)
+    set_fhe_param(param)
+
+    n_op = 16
+    n_diag = 64
+    level = 3
+    xs = [CkksCiphertextNode(f'x_{i}', level) for i in range(n_op)]
+    ds = [[CkksPlaintextMulNode(f'd_{i}_{k}', level) for k in range(n_diag)] for i in range(n_op)]
+    ys = [linear_transform(xs[i], {k: ds[i][k] for k in range(n_diag)}, output_id=f'y_{i}') for i in range(n_op)]
+
+    mag = process_custom_task(
+        input_args=[Argument('xs', xs), Argument('ds', ds)],
+        output_args=[Argument('ys', ys)],
+        output_instruction_path='ckks_linear_transform',
+        fpga_acc=False,
+    )
+    print(f'ckks_linear_transform: {len(mag["compute"])} compute nodes')
+
+
+def ckks_linear_transform_unrolled():
+    param = CkksParam.create_default_param(n=16384)
+    set_fhe_param(param)
+
+    n_op = 16
+    n_diag = 64
+    level = 3
+    xs = [CkksCiphertextNode(f'x_{i}', level) for i in range(n_op)]
+    ds = [[CkksPlaintextMulNode(f'd_{i}_{k}', level) for k in range(n_diag)] for i in range(n_op)]
+    ys = []
+    for i in range(n_op):
+        rotated = [xs[i]] + advanced_rotate_cols(xs[i], list(range(1, n_diag)))
+        acc = mult(rotated[0], ds[i][0])
+        for k in range(1, n_diag):
+            acc = add(acc, mult(rotated[k], ds[i][k]), output_id=f'y_{i}' if k == n_diag - 1 else None)
+        ys.append(acc)
+
+    mag = process_custom_task(
+        input_args=[Argument('xs', xs), Argument('ds', ds)],
+        output_args=[Argument('ys', ys)],
+        output_instruction_path='ckks_linear_transform_unrolled',
+        fpga_acc=False,
+    )
+    print(f'ckks_linear_transform_unrolled: {len(mag["compute"])} compute nodes')
+
+
+def ckks_neg_chain():
+    param = Param.create_ckks_default_param(n=16384)
+    set_fhe_param(param)
+
+    n_op = 256
+    chain_len = 64
+    level = 0
+    xs = [CkksCiphertextNode(f'x_{i}', level) for i in range(n_op)]
+    ys = []
+    for i in range(n_op):
+        y = xs[i]
+        for k in range(chain_len):
+            y = neg(y, output_id=f'y_{i}' if k == chain_len - 1 else None)
+        ys.append(y)
+
+    mag = process_custom_task(
+        input_args=[Argument('xs', xs)],
+        output_args=[Argument('ys', ys)],
+        output_instruction_path='ckks_neg_chain',
+        fpga_acc=False,
+    )
+    print(f'ckks_neg_chain: {len(mag["compute"])} compute nodes')
+
+
+def ckks_neg_dispatch():
+    param = Param.create_ckks_default_param(n=16384)
+    set_fhe_param(param)
+
+    chain_len = 4096
+    level = 0
+    x = CkksCiphertextNode('x', level)
+    y = x
+    for k in range(chain_len):
+        y = neg(y, output_id='y' if k == chain_len - 1 else None)
+
+    mag = process_custom_task(
+        input_args=[Argument('x', x)],
+        output_args=[Argument('y', y)],
+        output_instruction_path='ckks_neg_dispatch',
+        fpga_acc=False,
+    )
+    print(f'ckks_neg_dispatch: {len(mag["compute"])} compute nodes')
+
+
 if __name__ == '__main__':
     bfv_mult_relin()
     ckks_mult_relin()
     bfv_rotate_col()
+    ckks_linear_transform()
+    ckks_linear_transform_unrolled()
+    ckks_neg_chain()
+    ckks_neg_dispatch()
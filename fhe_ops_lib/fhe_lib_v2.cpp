@@ -18,8 +18,13 @@
 
 #include <stdio.h>
 #include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include "fhe_lib_v2.h"
 
 using namespace std::placeholders;
@@ -52,12 +57,66 @@ template <typename T> std::vector<T> export_raw_data(std::function<uint64_t(T**,
     return data_vector;
 }
 
+uint64_t FheContext::next_key_version() {
+    static std::atomic<uint64_t> last_key_version{0};
+    return ++last_key_version;
+}
+
 void FheContext::resize_copies(int n) {
     if (_copies.size() < n) {
         _copies.resize(n);
     }
 }
 
+// Call f(context, i) for every i in [0, n). Items are handed out to up to n_threads workers, each holding its own
+// shallow copy of ctx; the first exception thrown by a worker stops the batch and is rethrown to the caller.
+template <typename TContext, typename F> void parallel_for_copies(TContext& ctx, size_t n, int n_threads, F f) {
+    if (n_threads <= 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    n_threads = static_cast<int>(std::min<size_t>(n_threads, n));
+    if (n_threads <= 1) {
+        for (size_t i = 0; i < n; i++) {
+            f(ctx, i);
+        }
+        return;
+    }
+
+    // Copies are created up front: get_copy() is not safe to call concurrently while it allocates.
+    ctx.resize_copies(n_threads);
+    std::vector<TContext*> copies(n_threads);
+    for (int w = 0; w < n_threads; w++) {
+        copies[w] = &ctx.get_copy(w);
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads);
+    for (int w = 0; w < n_threads; w++) {
+        workers.emplace_back([&, w] {
+            try {
+                for (size_t i = next++; i < n; i = next++) {
+                    f(*copies[w], i);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = n;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
 KeySwitchKey RelinKey::extract_key_switch_key() const {
     return KeySwitchKey(ExtractKeySwitchKeyFromRelinKey(this->get()));
 }
@@ -88,10 +147,12 @@ BfvContext BfvContext::create_random_context(const BfvParameter& param, int leve
 
 void BfvContext::gen_rotation_keys(int level) {
     GenBfvContextRotationKeys(this->get(), level);
+    keys_changed();
 }
 
 void BfvContext::gen_rotation_keys_for_rotations(const std::vector<int32_t>& rots, bool include_swap_rows, int level) {
     GenBfvContextRotationKeysForRotations(this->get(), (int32_t*)rots.data(), rots.size(), include_swap_rows, level);
+    keys_changed();
 }
 
 BfvContext BfvContext::create_empty_context(const BfvParameter& param) {
@@ -104,6 +165,7 @@ BfvContext BfvContext::make_public_context(bool include_pk, bool include_rlk, bo
 
 void BfvContext::generate_public_keys(int level) {
     GenerateBfvContextPublicKeys(this->get(), level);
+    keys_changed();
 }
 
 BfvContext BfvContext::shallow_copy_context() const {
@@ -154,10 +216,12 @@ void BfvContext::set_context_public_key(const PublicKey& pk) {
 
 void BfvContext::set_context_relin_key(const RelinKey& rlk) {
     SetBfvContextRelinKey(this->get(), rlk.get());
+    keys_changed();
 }
 
 void BfvContext::set_context_galois_key(const GaloisKey& gk) {
     SetBfvContextGaloisKey(this->get(), gk.get());
+    keys_changed();
 }
 
 BfvPlaintext BfvContext::encode(const std::vector<uint64_t>& x_mg, int level) {
@@ -531,12 +595,47 @@ BfvCiphertext BfvContext::rotate_rows(const BfvCiphertext& x_ct) {
 //     return std::move(bit_lts[log_t_len][0]);
 // }
 
+std::vector<BfvPlaintext> BfvContext::encode_batch(gsl::span<const std::vector<uint64_t>> x_mgs, int level, int n_threads) {
+    std::vector<BfvPlaintext> result(x_mgs.size());
+    parallel_for_copies<BfvContext>(*this, x_mgs.size(), n_threads,
+                                    [&](BfvContext& ctx, size_t i) { result[i] = ctx.encode(x_mgs[i], level); });
+    return result;
+}
+
+std::vector<BfvCiphertext> BfvContext::encrypt_asymmetric_batch(gsl::span<const BfvPlaintext> x_pts, int n_threads) {
+    std::vector<BfvCiphertext> result(x_pts.size());
+    parallel_for_copies<BfvContext>(*this, x_pts.size(), n_threads,
+                                    [&](BfvContext& ctx, size_t i) { result[i] = ctx.encrypt_asymmetric(x_pts[i]); });
+    return result;
+}
+
+std::vector<BfvCiphertext> BfvContext::encrypt_symmetric_batch(gsl::span<const BfvPlaintext> x_pts, int n_threads) {
+    std::vector<BfvCiphertext> result(x_pts.size());
+    parallel_for_copies<BfvContext>(*this, x_pts.size(), n_threads,
+                                    [&](BfvContext& ctx, size_t i) { result[i] = ctx.encrypt_symmetric(x_pts[i]); });
+    return result;
+}
+
+std::vector<BfvPlaintext> BfvContext::decrypt_batch(gsl::span<const BfvCiphertext> x_cts, int n_threads) {
+    std::vector<BfvPlaintext> result(x_cts.size());
+    parallel_for_copies<BfvContext>(*this, x_cts.size(), n_threads,
+                                    [&](BfvContext& ctx, size_t i) { result[i] = ctx.decrypt(x_cts[i]); });
+    return result;
+}
+
+std::vector<std::vector<uint64_t>> BfvContext::decode_batch(gsl::span<const BfvPlaintext> x_pts, int n_threads) {
+    std::vector<std::vector<uint64_t>> result(x_pts.size());
+    parallel_for_copies<BfvContext>(*this, x_pts.size(), n_threads,
+                                    [&](BfvContext& ctx, size_t i) { result[i] = ctx.decode(x_pts[i]); });
+    return result;
+}
+
 BfvContext& BfvContext::get_copy(int index) {
     if (index >= _copies.size()) {
         throw std::out_of_range(
             "BfvContext::get_copy() index out of range. Call FheContext::resize_copies() to alloc more copies.");
     }
-    if (!_copies[index]->get()) {
+    if (!_copies[index]) {
         _copies[index] = std::make_unique<BfvContext>(this->shallow_copy_context());
     }
     return dynamic_cast<BfvContext&>(*_copies[index]);
@@ -684,10 +783,12 @@ CkksContext CkksContext::create_random_context_with_seed(const CkksParameter& pa
 
 void CkksContext::gen_rotation_keys(int level) {
     GenCkksContextRotationKeys(this->get(), level);
+    keys_changed();
 }
 
 void CkksContext::gen_rotation_keys_for_rotations(const std::vector<int32_t>& rots, bool include_swap_rows, int level) {
     GenCkksContextRotationKeysForRotations(this->get(), (int32_t*)rots.data(), rots.size(), include_swap_rows, level);
+    keys_changed();
 }
 
 CkksContext CkksContext::make_public_context(bool include_pk, bool include_rlk, bool include_gk) const {
@@ -749,10 +850,12 @@ void CkksContext::set_context_public_key(const PublicKey& pk) {
 
 void CkksContext::set_context_relin_key(const RelinKey& rlk) {
     SetCkksContextRelinKey(this->get(), rlk.get());
+    keys_changed();
 }
 
 void CkksContext::set_context_galois_key(const GaloisKey& gk) {
     SetCkksContextGaloisKey(this->get(), gk.get());
+    keys_changed();
 }
 
 Bytes CkksContext::serialize() const {
@@ -882,6 +985,42 @@ CkksPlaintext CkksContext::decrypt(const CkksCiphertext3& x_ct) {
     return CkksPlaintext(std::move(plaintext_handle_id));
 }
 
+std::vector<CkksPlaintext>
+CkksContext::encode_batch(gsl::span<const std::vector<double>> x_mgs, int level, double scale, int n_threads) {
+    std::vector<CkksPlaintext> result(x_mgs.size());
+    parallel_for_copies<CkksContext>(*this, x_mgs.size(), n_threads,
+                                     [&](CkksContext& ctx, size_t i) { result[i] = ctx.encode(x_mgs[i], level, scale); });
+    return result;
+}
+
+std::vector<CkksCiphertext> CkksContext::encrypt_asymmetric_batch(gsl::span<const CkksPlaintext> x_pts, int n_threads) {
+    std::vector<CkksCiphertext> result(x_pts.size());
+    parallel_for_copies<CkksContext>(*this, x_pts.size(), n_threads,
+                                     [&](CkksContext& ctx, size_t i) { result[i] = ctx.encrypt_asymmetric(x_pts[i]); });
+    return result;
+}
+
+std::vector<CkksCiphertext> CkksContext::encrypt_symmetric_batch(gsl::span<const CkksPlaintext> x_pts, int n_threads) {
+    std::vector<CkksCiphertext> result(x_pts.size());
+    parallel_for_copies<CkksContext>(*this, x_pts.size(), n_threads,
+                                     [&](CkksContext& ctx, size_t i) { result[i] = ctx.encrypt_symmetric(x_pts[i]); });
+    return result;
+}
+
+std::vector<CkksPlaintext> CkksContext::decrypt_batch(gsl::span<const CkksCiphertext> x_cts, int n_threads) {
+    std::vector<CkksPlaintext> result(x_cts.size());
+    parallel_for_copies<CkksContext>(*this, x_cts.size(), n_threads,
+                                     [&](CkksContext& ctx, size_t i) { result[i] = ctx.decrypt(x_cts[i]); });
+    return result;
+}
+
+std::vector<std::vector<double>> CkksContext::decode_batch(gsl::span<const CkksPlaintext> x_pts, int n_threads) {
+    std::vector<std::vector<double>> result(x_pts.size());
+    parallel_for_copies<CkksContext>(*this, x_pts.size(), n_threads,
+                                     [&](CkksContext& ctx, size_t i) { result[i] = ctx.decode(x_pts[i]); });
+    return result;
+}
+
 // CkksBtpContext
 CkksBtpContext CkksBtpContext::create_random_context(const CkksBtpParameter& param) {
     return CkksBtpContext(CreateRandomCkksBtpContext(param.get()));
@@ -893,10 +1032,12 @@ CkksBtpContext CkksBtpContext::create_empty_context(const CkksBtpParameter& para
 
 void CkksBtpContext::gen_rotation_keys() {
     GenCkksBtpContextRotationKeys(this->get());
+    keys_changed();
 }
 
 void CkksBtpContext::gen_rotation_keys_for_rotations(const std::vector<int32_t>& rots, bool include_swap_rows) {
     GenCkksBtpContextRotationKeysForRotations(this->get(), (int32_t*)rots.data(), rots.size(), include_swap_rows);
+    keys_changed();
 }
 
 // cppcheck-suppress duplInheritedMember
@@ -1090,19 +1231,23 @@ KeySwitchKey CkksBtpContext::extract_swk_std() const {
 // cppcheck-suppress duplInheritedMember
 void CkksBtpContext::set_context_relin_key(const RelinKey& rlk) {
     SetCkksBtpContextRelinKey(this->get(), rlk.get());
+    keys_changed();
 }
 
 // cppcheck-suppress duplInheritedMember
 void CkksBtpContext::set_context_galois_key(const GaloisKey& glk) {
     SetCkksBtpContextGaloisKey(this->get(), glk.get());
+    keys_changed();
 }
 
 void CkksBtpContext::set_context_switch_key_dts(const KeySwitchKey& swk) {
     SetCkksBtpContextSwitchkeyDts(this->get(), swk.get());
+    keys_changed();
 }
 
 void CkksBtpContext::set_context_switch_key_std(const KeySwitchKey& swk) {
     SetCkksBtpContextSwitchkeyStd(this->get(), swk.get());
+    keys_changed();
 }
 
 void CkksBtpContext::create_bootstrapper() {
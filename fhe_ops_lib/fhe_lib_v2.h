@@ -348,8 +348,26 @@ public:
 
     virtual const Parameter& get_parameter() = 0;
 
+    /**
+     * Version of the evaluation keys held by the context. Versions are unique within the process and a new one is
+     * taken whenever the context generates or is given evaluation keys, so that anything derived from the keys can
+     * tell whether it is stale.
+     * @return The key version.
+     */
+    uint64_t get_key_version() const {
+        return _key_version;
+    }
+
 protected:
+    static uint64_t next_key_version();
+
+    // Take a new key version; called by every method that changes the evaluation keys
+    void keys_changed() {
+        _key_version = next_key_version();
+    }
+
     std::vector<std::unique_ptr<FheContext>> _copies;
+    uint64_t _key_version = next_key_version();
 };
 
 /**
@@ -576,6 +594,50 @@ public:
      */
     BfvPlaintext decrypt(const BfvCiphertext3& x_ct);
 
+    /**
+     * Encode a batch of messages into BFV plaintexts. The batch is spread over `n_threads` worker threads, each using
+     * its own shallow copy of this context (see get_copy()), so it must not run concurrently with other users of the
+     * copies.
+     * @param x_mgs The input messages.
+     * @param level The level of the output plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The encoded plaintexts, in input order.
+     */
+    std::vector<BfvPlaintext>
+    encode_batch(gsl::span<const std::vector<uint64_t>> x_mgs, int level, int n_threads = 0);
+
+    /**
+     * Encrypt a batch of BFV plaintexts using the encryption public key, in parallel as in encode_batch().
+     * @param x_pts The input plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The encrypted ciphertexts, in input order.
+     */
+    std::vector<BfvCiphertext> encrypt_asymmetric_batch(gsl::span<const BfvPlaintext> x_pts, int n_threads = 0);
+
+    /**
+     * Encrypt a batch of BFV plaintexts using the secret key, in parallel as in encode_batch().
+     * @param x_pts The input plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The encrypted ciphertexts, in input order.
+     */
+    std::vector<BfvCiphertext> encrypt_symmetric_batch(gsl::span<const BfvPlaintext> x_pts, int n_threads = 0);
+
+    /**
+     * Decrypt a batch of BFV ciphertexts using the secret key, in parallel as in encode_batch().
+     * @param x_cts The input ciphertexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The decrypted plaintexts, in input order.
+     */
+    std::vector<BfvPlaintext> decrypt_batch(gsl::span<const BfvCiphertext> x_cts, int n_threads = 0);
+
+    /**
+     * Decode a batch of BFV plaintexts into message data, in parallel as in encode_batch().
+     * @param x_pts The input plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The decoded messages, in input order.
+     */
+    std::vector<std::vector<uint64_t>> decode_batch(gsl::span<const BfvPlaintext> x_pts, int n_threads = 0);
+
     /**
      * Convert a BFV plaintext to a BFV plaintext in ring-t form.
      * @param x_pt The input plaintext.
@@ -1041,6 +1103,51 @@ public:
      */
     CkksPlaintext decrypt(const CkksCiphertext3& x_ct);
 
+    /**
+     * Encode a batch of messages into CKKS plaintexts. The batch is spread over `n_threads` worker threads, each using
+     * its own shallow copy of this context (see get_copy()), so it must not run concurrently with other users of the
+     * copies.
+     * @param x_mgs The input messages.
+     * @param level The level of the output plaintexts.
+     * @param scale The scale of the output plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The encoded plaintexts, in input order.
+     */
+    std::vector<CkksPlaintext>
+    encode_batch(gsl::span<const std::vector<double>> x_mgs, int level, double scale, int n_threads = 0);
+
+    /**
+     * Encrypt a batch of CKKS plaintexts using the encryption public key, in parallel as in encode_batch().
+     * @param x_pts The input plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The encrypted ciphertexts, in input order.
+     */
+    std::vector<CkksCiphertext> encrypt_asymmetric_batch(gsl::span<const CkksPlaintext> x_pts, int n_threads = 0);
+
+    /**
+     * Encrypt a batch of CKKS plaintexts using the secret key, in parallel as in encode_batch().
+     * @param x_pts The input plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The encrypted ciphertexts, in input order.
+     */
+    std::vector<CkksCiphertext> encrypt_symmetric_batch(gsl::span<const CkksPlaintext> x_pts, int n_threads = 0);
+
+    /**
+     * Decrypt a batch of CKKS ciphertexts using the secret key, in parallel as in encode_batch().
+     * @param x_cts The input ciphertexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The decrypted plaintexts, in input order.
+     */
+    std::vector<CkksPlaintext> decrypt_batch(gsl::span<const CkksCiphertext> x_cts, int n_threads = 0);
+
+    /**
+     * Decode a batch of CKKS plaintexts into message data (real parts), in parallel as in encode_batch().
+     * @param x_pts The input plaintexts.
+     * @param n_threads Number of worker threads, 0 for the hardware concurrency.
+     * @return The decoded messages, in input order.
+     */
+    std::vector<std::vector<double>> decode_batch(gsl::span<const CkksPlaintext> x_pts, int n_threads = 0);
+
     CkksContext& get_copy(int index) override;
 
     CkksContext& get_extra_level_context();
@@ -19,7 +19,7 @@ import math
 import os
 import random
 import string
-from typing import List, Optional
+from typing import Callable, List, Optional
 
 import networkx as nx
 from enum import Enum
@@ -79,6 +79,8 @@ class OperationType(Enum):
     CmpacSum = 'cmpac_sum'
     CmpSum = 'cmp_sum'
     Bootstrap = 'bootstrap'
+    LinearTransform = 'linear_transform'
+    PolyEval = 'poly_eval'
     FpgaKernel = 'fpga_kernel'
 
 
@@ -154,6 +156,19 @@ def random_id():
     return asc
 
 
+# Maximum log2(QP) for a ternary secret, per ring degree and classical security level (HE standard).
+# The presets in parameter.json sit exactly at the 128-bit bound.
+HE_STANDARD_MAX_LOG_QP = {
+    4096: {128: 109, 192: 75, 256: 58},
+    8192: {128: 218, 192: 152, 256: 118},
+    16384: {128: 438, 192: 305, 256: 237},
+    32768: {128: 881, 192: 611, 256: 476},
+}
+
+# Bits of a CKKS scale consumed by encoding and rescaling noise, on top of the requested precision
+CKKS_NOISE_BITS = 10
+
+
 class Param:
     def __init__(self, algo: Algo, n: int = 8192):
         self.algo: Algo = algo
@@ -161,6 +176,8 @@ class Param:
         self.p: list[int] = []
         self.q: list[int] = []
         self.max_level: int = -1
+        # Constraints for automatic parameter selection; None for a fixed parameter
+        self.auto: dict | None = None
 
     def get_max_sp_level(self):
         return len(self.p) - 1
@@ -180,6 +197,11 @@ class Param:
 
         return algo_params[str(self.n)]
 
+    def _init_auto(self, security_level: int, **constraints) -> None:
+        if security_level not in HE_STANDARD_MAX_LOG_QP[self.n]:
+            raise ValueError(f'Unsupported security level {security_level}, expected one of 128, 192, 256.')
+        self.auto = {'security_level': security_level, **constraints}
+
 
 class BfvParam(Param):
     def __init__(self, n: int = 8192):
@@ -211,6 +233,18 @@ class BfvParam(Param):
         instance.max_level = len(q) - 1
         return instance
 
+    @classmethod
+    def create_auto_param(cls, security_level: int = 128):
+        """Create a BFV parameter that is chosen when the task is processed.
+
+        The graph is built against the largest preset; process_custom_task() then picks the smallest preset ring
+        and the shortest prefix of its modulus chain that fit the graph, see select_auto_param().
+        @param security_level: Classical security level in bits: 128, 192 or 256.
+        """
+        instance = cls.create_default_param(n=max(HE_STANDARD_MAX_LOG_QP))
+        instance._init_auto(security_level)
+        return instance
+
     @classmethod
     def create_fpga_param(cls, t: int = 0x1B4001):
         instance = cls(n=8192)
@@ -269,6 +303,22 @@ class CkksParam(Param):
         instance.max_level = len(q) - 1
         return instance
 
+    @classmethod
+    def create_auto_param(cls, precision: int = 20, slots: int = 0, security_level: int = 128):
+        """Create a CKKS parameter that is chosen when the task is processed.
+
+        The graph is built against the largest preset; process_custom_task() then picks the smallest preset ring
+        and the shortest prefix of its modulus chain that fit the graph, see select_auto_param().
+        @param precision: Required bits of precision; the scale must provide CKKS_NOISE_BITS more.
+        @param slots: Required number of slots, 0 for n / 2 of the chosen ring.
+        @param security_level: Classical security level in bits: 128, 192 or 256.
+        """
+        if cls is not CkksParam:
+            raise ValueError('Automatic parameter selection does not support bootstrapping parameters.')
+        instance = cls.create_default_param(n=max(HE_STANDARD_MAX_LOG_QP))
+        instance._init_auto(security_level, precision=precision, slots=slots)
+        return instance
+
     @classmethod
     def create_fpga_param(cls):
         instance = cls(n=8192)
@@ -870,6 +920,17 @@ class FheComputeNode(ComputeNode):
         elif isinstance(self, (CmpSumComputeNode, CmpacSumComputeNode)):
             d['sum_cnt'] = self.sum_cnt
             d['pt_type'] = self.pt_type.value if isinstance(self.pt_type, DataType) else self.pt_type
+        elif isinstance(self, LinearTransformComputeNode):
+            d['diag_indices'] = self.diag_indices
+            d['bsgs_n1'] = self.n1
+        elif isinstance(self, PolyEvalComputeNode):
+            if self.function is not None:
+                d['poly_func'] = self.function
+            else:
+                d['poly_coeffs'] = self.coeffs
+                d['poly_basis'] = self.basis
+            d['poly_interval'] = [self.left, self.right]
+            d['poly_degree'] = self.degree
         if self.compressed_block_info is not None:
             d['compressed_block_info'] = self.compressed_block_info
         return d
@@ -955,6 +1016,42 @@ class RotateRowUnitNode(FheComputeNode):
         self.lib = lib
 
 
+class LinearTransformComputeNode(FheComputeNode):
+    """
+    @class LinearTransformComputeNode
+    @brief Baby-step giant-step plaintext matrix-ciphertext vector product type.
+    """
+
+    def __init__(self, diag_indices: list[int], n1: int) -> None:
+        super().__init__(type=OperationType.LinearTransform)
+        self.diag_indices = diag_indices
+        self.n1 = n1
+
+
+class PolyEvalComputeNode(FheComputeNode):
+    """
+    @class PolyEvalComputeNode
+    @brief Polynomial evaluation over an approximation interval type.
+    """
+
+    def __init__(
+        self,
+        left: float,
+        right: float,
+        degree: int,
+        function: str | None = None,
+        coeffs: list[float] | None = None,
+        basis: str = 'monomial',
+    ) -> None:
+        super().__init__(type=OperationType.PolyEval)
+        self.left = left
+        self.right = right
+        self.degree = degree
+        self.function = function
+        self.coeffs = coeffs
+        self.basis = basis
+
+
 class FpgaKernelNode(FheComputeNode):
     """
     @class FpgaKernelComputeNode
@@ -1949,6 +2046,182 @@ def ct_pt_mult_accumulate_1(
     return partial_sum
 
 
+def _default_bsgs_n1(diag_indices: list[int]) -> int:
+    span = max(diag_indices) + 1
+    if span <= 2:
+        return 1
+    return 1 << math.ceil(math.log2(math.sqrt(span)))
+
+
+def linear_transform(
+    x: BfvCiphertextNode | CkksCiphertextNode,
+    diagonals: dict[int, BfvPlaintextMulNode | CkksPlaintextMulNode],
+    n1: int | None = None,
+    output_id: Optional[str] = None,
+) -> BfvCiphertextNode | CkksCiphertextNode:
+    """!Plaintext matrix - ciphertext vector product
+
+    Define a matrix-vector product y = M * x as a single compute step, evaluated with the baby-step giant-step
+    (BSGS) diagonal method: y = sum_j rot(sum_i rot(x, i) * diag'_{j*n1+i}, j*n1).
+    Baby-step rotations are hoisted, so the step needs only O(sqrt(d)) key switches for d diagonals,
+    instead of the O(d) rotate_cols + mult + add nodes of the unrolled form.
+
+    The diagonal with index k = j*n1 + i must be encoded pre-rotated by its giant step,
+    i.e. diag'_k = rot(diag_k, -j*n1), where diag_k[s] = M[s][(s + k) % slots].
+    @param x Input ciphertext.
+    @param diagonals Non-zero diagonals of M keyed by diagonal index (0 <= k < slots), encoded as pt_mul at x.level.
+    @param n1 Baby-step size. Defaults to the smallest power of two >= sqrt(max diagonal index + 1).
+    @param output_id Output node ID.
+    @return Result data node.
+    """
+    global g_dag, g_param
+    if g_param is None:
+        raise RuntimeError('Please call set_fhe_param() before using linear_transform.')
+    if x.type != DataType.Ciphertext or x.degree != 1:
+        raise ValueError(f'Unsupported input type "{x.type.value}" for linear_transform.')
+    if not diagonals:
+        raise ValueError('At least one diagonal is required for linear_transform.')
+
+    diag_indices = sorted(diagonals.keys())
+    if diag_indices[0] < 0:
+        raise ValueError('Diagonal indices of linear_transform must be non-negative.')
+    if len(set(id(d) for d in diagonals.values())) != len(diagonals):
+        raise ValueError('Each diagonal of linear_transform must be a distinct plaintext node.')
+    for k in diag_indices:
+        d = diagonals[k]
+        if not isinstance(d, (BfvPlaintextMulNode, CkksPlaintextMulNode)):
+            raise ValueError(f'Diagonal {k} of linear_transform must be a pt_mul node.')
+        if d.level != x.level:
+            raise ValueError(
+                f'Diagonal {k} of linear_transform is at level {d.level}, but the input is at level {x.level}.'
+            )
+
+    if n1 is None:
+        n1 = _default_bsgs_n1(diag_indices)
+    if n1 <= 0:
+        raise ValueError(f'Invalid baby-step size "{n1}" for linear_transform.')
+
+    op = LinearTransformComputeNode(diag_indices, n1)
+    g_dag.add_edge(x, op)
+    for k in diag_indices:
+        g_dag.add_edge(diagonals[k], op)
+
+    rot_steps = set()
+    for k in diag_indices:
+        rot_steps.add(k % n1)
+        rot_steps.add(k - k % n1)
+    rot_steps.discard(0)
+
+    global g_swk_node_dict
+    for step in sorted(rot_steps):
+        gal_elem = get_galois_element_for_column_rotation_by(step, g_param.n)
+        glk = f'glk_ntt_col_{gal_elem}'
+        if glk not in g_swk_node_dict:
+            g_swk_node_dict[glk] = GaloisKeyNode(id=glk, level=x.level)
+        elif x.level > g_swk_node_dict[glk].level:
+            g_swk_node_dict[glk].level = x.level
+        g_dag.add_edge(g_swk_node_dict[glk], op)
+
+    z = CiphertextNode()
+    if isinstance(x, BfvCiphertextNode):
+        z = BfvCiphertextNode(id=random_id() if output_id is None else output_id, level=x.level)
+    elif isinstance(x, CkksCiphertextNode):
+        z = CkksCiphertextNode(id=random_id() if output_id is None else output_id, level=x.level)
+    else:
+        raise ValueError()
+    z.is_ntt = x.is_ntt
+    g_dag.add_edge(op, z)
+    return z
+
+
+POLY_EVAL_FUNCTIONS = ('relu', 'sigmoid', 'tanh', 'exp', 'gelu', 'silu')
+
+
+def _poly_eval_depth(degree: int) -> int:
+    # One level for mapping the interval onto [-1, 1], then ceil(log2(degree + 1)) for the BSGS power tree
+    return 1 + degree.bit_length()
+
+
+def _chebyshev_coeffs(function: Callable[[float], float], left: float, right: float, degree: int) -> list[float]:
+    n = degree + 1
+    nodes = [math.cos(math.pi * (j + 0.5) / n) for j in range(n)]
+    values = [function(0.5 * (right - left) * t + 0.5 * (right + left)) for t in nodes]
+    coeffs = []
+    for k in range(n):
+        c = 2.0 / n * sum(v * math.cos(k * math.pi * (j + 0.5) / n) for j, v in enumerate(values))
+        coeffs.append(c / 2 if k == 0 else c)
+    return coeffs
+
+
+def poly_eval(
+    x: CkksCiphertextNode,
+    function: list[float] | str | Callable[[float], float],
+    interval: tuple[float, float] = (-1.0, 1.0),
+    degree: int | None = None,
+    output_id: Optional[str] = None,
+) -> CkksCiphertextNode:
+    """!Polynomial evaluation
+
+    Define the evaluation of p(x) as a single compute step, where p is either a given polynomial or the
+    Chebyshev interpolant of a function over the interval. The polynomial is evaluated with the baby-step
+    giant-step algorithm, which needs 1 + ceil(log2(degree + 1)) levels instead of the degree-many serial
+    mult/relin/rescale steps of the unrolled form.
+    @param x Input ciphertext. Its slot values must lie within the interval.
+    @param function One of:
+        - list of monomial coefficients, lowest order first: p(x) = sum_i function[i] * x^i;
+        - name of a built-in function, one of POLY_EVAL_FUNCTIONS;
+        - Python callable, which is interpolated here and shipped as Chebyshev coefficients.
+    @param interval Approximation interval (left, right).
+    @param degree Approximation degree. Must be given for functions, defaults to len(function) - 1 for coefficients.
+    @param output_id Output node ID.
+    @return Result data node, at level x.level - 1 - ceil(log2(degree + 1)).
+    """
+    global g_dag
+    if not isinstance(x, CkksCiphertextNode) or x.degree != 1:
+        raise ValueError(f'Unsupported input type "{x.type.value}" for poly_eval.')
+    left, right = float(interval[0]), float(interval[1])
+    if not left < right:
+        raise ValueError(f'Invalid interval "{interval}" for poly_eval.')
+
+    if isinstance(function, (list, tuple)):
+        if degree is not None and degree != len(function) - 1:
+            raise ValueError(f'Degree {degree} does not match the {len(function)} coefficients of poly_eval.')
+        degree = len(function) - 1
+        op = PolyEvalComputeNode(left, right, degree, coeffs=[float(c) for c in function])
+    elif degree is None:
+        raise ValueError('Degree is required when poly_eval approximates a function.')
+    elif isinstance(function, str):
+        if function not in POLY_EVAL_FUNCTIONS:
+            raise ValueError(f'Unsupported function "{function}" for poly_eval, expected one of {POLY_EVAL_FUNCTIONS}.')
+        op = PolyEvalComputeNode(left, right, degree, function=function)
+    elif callable(function):
+        coeffs = _chebyshev_coeffs(function, left, right, degree)
+        op = PolyEvalComputeNode(left, right, degree, coeffs=coeffs, basis='chebyshev')
+    else:
+        raise ValueError(f'Unsupported function type "{type(function).__name__}" for poly_eval.')
+    if degree < 1:
+        raise ValueError(f'Invalid degree "{degree}" for poly_eval.')
+
+    output_level = x.level - _poly_eval_depth(degree)
+    if output_level < 0:
+        raise ValueError(
+            f'poly_eval of degree {degree} needs {_poly_eval_depth(degree)} levels, but input level is {x.level}.'
+        )
+
+    rlk = 'rlk_ntt'
+    global g_swk_node_dict
+    if rlk not in g_swk_node_dict:
+        g_swk_node_dict[rlk] = RelinKeyNode(level=x.level)
+    elif x.level > g_swk_node_dict[rlk].level:
+        g_swk_node_dict[rlk].level = x.level
+    g_dag.add_edges_from([(x, op), (g_swk_node_dict[rlk], op)])
+
+    z = CkksCiphertextNode(id=random_id() if output_id is None else output_id, level=output_level)
+    z.is_ntt = x.is_ntt
+    g_dag.add_edge(op, z)
+    return z
+
+
 def bootstrap(x: CkksCiphertextNode, output_id: Optional[str] = None) -> CkksCiphertextNode:
     global g_dag, g_param
     if g_param is None:
@@ -2184,6 +2457,270 @@ def _build_fpga_kernels(
     return result
 
 
+def _flatten_data(x: list | DataNode) -> list[DataNode]:
+    if isinstance(x, list):
+        result: list[DataNode] = []
+        for a in x:
+            result += _flatten_data(a)
+        return result
+    return [x]
+
+
+def _is_simple_op(node, *types: OperationType) -> bool:
+    return type(node) is FheComputeNode and node.type in types
+
+
+def _producer(node: DataNode) -> ComputeNode | None:
+    preds = list(g_dag.predecessors(node))
+    return preds[0] if preds else None
+
+
+def _sole_consumer(node: DataNode, pinned: set) -> ComputeNode | None:
+    if node in pinned:
+        return None
+    succs = list(g_dag.successors(node))
+    return succs[0] if len(succs) == 1 else None
+
+
+def _replace_input(op: ComputeNode, old: DataNode, new: DataNode) -> None:
+    # Predecessor order is the operand order of the op, so re-add every edge to keep it.
+    preds = list(g_dag.predecessors(op))
+    for p in preds:
+        g_dag.remove_edge(p, op)
+    for p in preds:
+        g_dag.add_edge(new if p is old else p, op)
+
+
+def _ntt_count(level: int) -> int:
+    # A rescale at `level` runs one inverse NTT on the dropped modulus and one forward NTT per remaining modulus,
+    # for each of the two ciphertext polynomials.
+    return 2 * (level + 1)
+
+
+def _merge_duplicate_ops(pinned: set, op_type: OperationType) -> list[int]:
+    merged_levels = []
+    for x in list(g_dag.nodes()):
+        if x not in g_dag or not isinstance(x, DataNode):
+            continue
+        dups = [op for op in g_dag.successors(x) if _is_simple_op(op, op_type)]
+        if len(dups) < 2:
+            continue
+        # Keep the copy that produces a pinned node (at most one can be kept), the first one otherwise.
+        dups.sort(key=lambda op: next(g_dag.successors(op)) not in pinned)
+        keep = next(g_dag.successors(dups[0]))
+        for op in dups[1:]:
+            y = next(g_dag.successors(op))
+            if y in pinned:
+                continue
+            # Only add/sub accept the same node twice (as a single input edge).
+            if any(
+                g_dag.has_edge(keep, c) and not _is_simple_op(c, OperationType.Add, OperationType.Sub)
+                for c in g_dag.successors(y)
+            ):
+                continue
+            for consumer in list(g_dag.successors(y)):
+                _replace_input(consumer, y, keep)
+            g_dag.remove_nodes_from([op, y])
+            merged_levels.append(x.level)
+    return merged_levels
+
+
+def _sink_rescales(pinned: set) -> tuple[int, int]:
+    sunk, saved_ntts = 0, 0
+    for op in list(g_dag.nodes()):
+        if op not in g_dag or not _is_simple_op(op, OperationType.Add, OperationType.Sub):
+            continue
+        ins = list(g_dag.predecessors(op))
+        if len(ins) != 2 or not all(isinstance(r, CkksCiphertextNode) and _sole_consumer(r, pinned) is op for r in ins):
+            continue
+        rescales = [_producer(r) for r in ins]
+        if not all(_is_simple_op(rs, OperationType.Rescale) for rs in rescales):
+            continue
+        srcs = [next(g_dag.predecessors(rs)) for rs in rescales]
+        if srcs[0] is srcs[1] or not all(isinstance(s, CkksCiphertextNode) for s in srcs):
+            continue
+        if srcs[0].level != srcs[1].level or srcs[0].is_ntt != srcs[1].is_ntt:
+            continue
+
+        z = next(g_dag.successors(op))
+        g_dag.remove_nodes_from([op, *rescales, *ins])
+        new_op = FheComputeNode(op.type)
+        s = CkksCiphertextNode(id=random_id(), level=srcs[0].level)
+        s.is_ntt = srcs[0].is_ntt
+        new_rescale = FheComputeNode(OperationType.Rescale)
+        g_dag.add_edges_from([(srcs[0], new_op), (srcs[1], new_op), (new_op, s), (s, new_rescale), (new_rescale, z)])
+        sunk += 1
+        saved_ntts += _ntt_count(srcs[0].level)
+    return sunk, saved_ntts
+
+
+def _hoist_drop_levels(pinned: set) -> int:
+    hoisted = 0
+    for drop in list(g_dag.nodes()):
+        if drop not in g_dag or not _is_simple_op(drop, OperationType.DropLevel):
+            continue
+        z = next(g_dag.predecessors(drop))
+        op = _producer(z)
+        if _sole_consumer(z, pinned) is not drop or not _is_simple_op(
+            op, OperationType.Add, OperationType.Sub, OperationType.Neg
+        ):
+            continue
+        ins = list(g_dag.predecessors(op))
+        if not all(isinstance(x, CkksCiphertextNode) and x.level >= 1 for x in ins):
+            continue
+
+        dropped = []
+        for x in ins:
+            existing = [d for d in g_dag.successors(x) if _is_simple_op(d, OperationType.DropLevel)]
+            if existing:
+                dropped.append(next(g_dag.successors(existing[0])))
+                continue
+            x_drop = CkksCiphertextNode(id=random_id(), level=x.level - 1)
+            x_drop.is_ntt = x.is_ntt
+            d = FheComputeNode(OperationType.DropLevel)
+            g_dag.add_edges_from([(x, d), (d, x_drop)])
+            dropped.append(x_drop)
+
+        y = next(g_dag.successors(drop))
+        g_dag.remove_nodes_from([op, z, drop])
+        new_op = FheComputeNode(op.type)
+        g_dag.add_edges_from([(x, new_op) for x in dropped])
+        g_dag.add_edge(new_op, y)
+        hoisted += 1
+    return hoisted
+
+
+def lazy_rescale(output_args: list[Argument]) -> dict:
+    """!Lazy rescale rewrite
+
+    Rewrite the CKKS graph defined so far to use fewer rescales and cheaper additions. Applied until nothing changes:
+    - add(rescale(a), rescale(b)) and sub(rescale(a), rescale(b)) become rescale(add(a, b)) / rescale(sub(a, b))
+      when both rescaled values are used only by that addition;
+    - rescales (and drop_levels) applied to the same input are merged into one;
+    - drop_level after add/sub/neg is moved onto the operands, so the addition runs at the lower level.
+
+    Output data nodes keep their IDs and levels; intermediate nodes that feed more than one consumer are never
+    rewritten. Moving drop_level is exact; moving a rescale past an addition only changes the CKKS rounding error.
+    Call it after the graph is built and before process_custom_task().
+
+    @param output_args List of all output arguments for the custom task.
+    @return Rewrite report with the keys rescales_sunk, rescales_merged, drop_levels_merged, drop_levels_hoisted and
+        saved_ntts (estimated number of NTTs no longer executed).
+    """
+    if not isinstance(g_param, CkksParam):
+        raise RuntimeError('lazy_rescale() only applies to CKKS tasks; call set_fhe_param() with a CKKS parameter.')
+
+    pinned = set()
+    for arg in output_args:
+        pinned.update(_flatten_data(arg.data))
+
+    report = {'rescales_sunk': 0, 'rescales_merged': 0, 'drop_levels_merged': 0, 'drop_levels_hoisted': 0}
+    saved_ntts = 0
+    while True:
+        rescale_merged = _merge_duplicate_ops(pinned, OperationType.Rescale)
+        drop_merged = _merge_duplicate_ops(pinned, OperationType.DropLevel)
+        sunk, ntts = _sink_rescales(pinned)
+        hoisted = _hoist_drop_levels(pinned)
+        report['rescales_merged'] += len(rescale_merged)
+        report['drop_levels_merged'] += len(drop_merged)
+        report['rescales_sunk'] += sunk
+        report['drop_levels_hoisted'] += hoisted
+        saved_ntts += ntts + sum(_ntt_count(lv) for lv in rescale_merged)
+        if not (rescale_merged or drop_merged or sunk or hoisted):
+            break
+    report['saved_ntts'] = saved_ntts
+    return report
+
+
+def _graph_requirements() -> tuple[int, int]:
+    required_level = 0
+    max_rotation_step = 0
+    for node in g_dag.nodes():
+        if isinstance(node, FheDataNode):
+            required_level = max(required_level, node.level)
+        elif isinstance(node, RotateColUnitNode):
+            max_rotation_step = max(max_rotation_step, abs(node.step))
+        elif isinstance(node, LinearTransformComputeNode):
+            for k in node.diag_indices:
+                max_rotation_step = max(max_rotation_step, k % node.n1, k - k % node.n1)
+    return required_level, max_rotation_step
+
+
+def select_auto_param(param: Param) -> tuple[Param, dict]:
+    """!Automatic parameter selection
+
+    Resolve a parameter created by create_auto_param() against the current computation graph.
+    Preset rings are tried from the smallest up, and the first one is chosen that has enough levels for the
+    deepest node, enough slots and rotation range, and (CKKS) a scale that meets the precision target. Its
+    modulus chain is cut to the levels actually used, and the remaining log2(QP) is checked against the
+    HE standard bound for the requested security level.
+    @param param Automatic parameter.
+    @return The chosen parameter, and a summary of the choice that is stored in mega_ag.json.
+    """
+    required_level, max_rotation_step = _graph_requirements()
+    security_level = param.auto['security_level']
+    rejected = []
+    for n in sorted(HE_STANDARD_MAX_LOG_QP):
+        preset = type(param).create_default_param(n=n)
+        max_log_qp = HE_STANDARD_MAX_LOG_QP[n][security_level]
+        q = preset.q[: required_level + 1]
+        log_qp = sum(math.log2(x) for x in q + preset.p)
+        if preset.max_level < required_level:
+            rejected.append(f'n={n}: max level {preset.max_level} < required level {required_level}')
+        elif max_rotation_step >= n // 2:
+            rejected.append(f'n={n}: rotation step {max_rotation_step} >= {n // 2} columns')
+        elif isinstance(preset, CkksParam) and param.auto['slots'] > n // 2:
+            rejected.append(f'n={n}: {param.auto["slots"]} slots > {n // 2}')
+        elif isinstance(preset, CkksParam) and math.log2(preset.scale) < param.auto['precision'] + CKKS_NOISE_BITS:
+            rejected.append(
+                f'n={n}: scale 2^{math.log2(preset.scale):g} < 2^{param.auto["precision"] + CKKS_NOISE_BITS} '
+                f'for {param.auto["precision"]}-bit precision'
+            )
+        elif log_qp > max_log_qp:
+            rejected.append(f'n={n}: log QP {log_qp:.1f} > {max_log_qp} for {security_level}-bit security')
+        else:
+            if isinstance(preset, BfvParam):
+                chosen = BfvParam.create_custom_param(n, q, list(preset.p), preset.t)
+            else:
+                chosen = CkksParam.create_custom_param(n, q, list(preset.p), param.auto['slots'], preset.scale)
+            selection = {
+                'n': n,
+                'required_level': required_level,
+                'max_rotation_step': max_rotation_step,
+                'security_level': security_level,
+                'log_qp': round(log_qp, 1),
+                'max_log_qp': max_log_qp,
+                'rejected': rejected,
+                'reason': (
+                    f'n={n} is the smallest preset ring that fits the graph; modulus chain cut from '
+                    f'{len(preset.q)} to {len(q)} primes, log QP {log_qp:.1f} <= {max_log_qp} '
+                    f'for {security_level}-bit security'
+                ),
+            }
+            return chosen, selection
+    raise ValueError('No parameter satisfies the task: ' + '; '.join(rejected))
+
+
+def _rebase_switch_keys() -> None:
+    # Key nodes were created against the provisional ring of an automatic parameter. Galois elements reduce
+    # modulo 2n, since the order of the generator modulo 2n divides that modulo any larger power of two.
+    global g_swk_node_dict
+    rebased: dict[str, SwitchKeyNode] = {}
+    for key, node in g_swk_node_dict.items():
+        node.sp_level = g_param.get_max_sp_level()
+        if isinstance(node, GaloisKeyNode):
+            if 'col' in key:
+                node.galois_element = int(key.split('_')[-1]) % (2 * g_param.n)
+                key = f'glk_ntt_col_{node.galois_element}'
+                node.id = key
+            else:
+                node.galois_element = get_galois_element_for_row_rotation(g_param.n)
+        if key in rebased:
+            raise ValueError(f'Galois key "{key}" is ambiguous for n = {g_param.n}.')
+        rebased[key] = node
+    g_swk_node_dict = rebased
+
+
 def process_custom_task(
     input_args: list[Argument] | None = None,
     output_args: list[Argument] | None = None,
@@ -2258,6 +2795,12 @@ def process_custom_task(
     if g_param is None:
         raise RuntimeError('Please call set_fhe_param() before calling process_custom_task().')
 
+    auto_param, auto_selection = None, None
+    if g_param.auto is not None:
+        auto_param = g_param
+        g_param, auto_selection = select_auto_param(auto_param)
+        _rebase_switch_keys()
+
     used_id = []
 
     all_input_list, input_sigdata_list = process_data_args(input_args, 'in')
@@ -2327,6 +2870,8 @@ def process_custom_task(
         parameter['btp_stc_depth'] = g_param.stc_params.depth()
         parameter['btp_stc_bsgs_ratio'] = g_param.stc_params.bsgs_ratio
         parameter['btp_output_level'] = g_param.btp_output_level
+    if auto_selection is not None:
+        parameter['auto_selection'] = auto_selection
 
     mag['parameter'] = parameter
 
@@ -2437,6 +2982,8 @@ def process_custom_task(
 
     g_swk_node_dict.clear()
     g_dag.clear()
+    if auto_param is not None:
+        g_param = auto_param
     global data_node_count, compute_node_count, random_ids
     data_node_count = 0
     compute_node_count = 0
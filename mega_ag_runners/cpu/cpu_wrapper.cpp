@@ -25,37 +25,299 @@
 #include "../../fhe_ops_lib/fhe_lib_v2.h"
 #include "../../lib/thread_pool/BS_thread_pool.hpp"
 #include "../../lib/gsl/span"
-
-#ifdef LATTISENSE_DEV
-#    include "../cpu_mem_monitor.h"
-#endif
+#include "../cpu_mem_monitor.h"
+#include "../cpu_runtime.h"
+#include "../cpu_checkpoint.h"
+#include "../cpu_distributed.h"
 
 extern "C" {
 #include "../wrapper.h"
 }
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <any>
 #include <memory>
 #include <thread>
 
+// Cancellation request and deadline of one run of a CPU task (see create_cpu_run_control()).
+struct cpu_run_control_st {
+    std::atomic<bool> cancelled{false};
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+// Worker pool shared by CPU tasks (see create_cpu_runtime()). Tasks attached to it keep it alive.
+struct cpu_runtime_st {
+    std::shared_ptr<CpuRuntime> runtime;
+};
+
+// Connection of one rank of distributed runs to the others (see create_unix_socket_transport()). Tasks attached to it
+// keep it alive.
+struct cpu_transport_st {
+    std::shared_ptr<Transport> transport;
+};
+
 namespace cpu_wrapper {
 
 using namespace fhe_ops_lib;
 
+// Estimated peak of intermediate bytes of a task's runs, reserved by the memory-aware admission of CpuRuntime. The
+// graph estimate is scaled by a moving average of the ratio of the observed peak to it over past runs.
+struct MemoryEstimate {
+    size_t parallelism = 0;  // Thread count the graph estimate was made for, 0 if not made yet
+    uint64_t graph_bytes = 0;
+    double correction = 1.0;
+
+    uint64_t bytes(const MegaAG& mega_ag, size_t threads) {
+        if (parallelism != threads) {
+            graph_bytes = estimate_peak_live_bytes(mega_ag, threads);
+            parallelism = threads;
+        }
+        return static_cast<uint64_t>(graph_bytes * correction);
+    }
+
+    void observe(uint64_t peak_bytes) {
+        if (graph_bytes > 0) {
+            correction = 0.5 * correction + 0.5 * double(peak_bytes) / double(graph_bytes);
+        }
+    }
+};
+
+// Per-task run options of the CPU runner.
+struct CpuRunOptions {
+    size_t max_coalesce = 1;                            // see run_tasks()
+    bool fuse_chains = true;                            // see RunTasksOptions::fuse_chains
+    int mem_monitor_interval_ms = 0;                    // MemoryMonitor sampling interval, 0 disables the monitor
+    std::string mem_monitor_csv_path;                   // CSV written by the monitor, empty for none
+    std::vector<std::string> requested_outputs;         // Ids of the output arguments to compute, empty for all
+    bool prioritize_outputs = false;                    // see RunTasksOptions::prioritize_outputs
+    output_ready_callback_t output_ready_cb = nullptr;  // Called as each output item is written, nullptr for none
+    void* output_ready_user_data = nullptr;             // Passed to output_ready_cb
+    const cpu_run_control_st* control = nullptr;        // Cancellation and deadline of the run, nullptr for none
+    std::shared_ptr<CpuRuntime> runtime;                // Shared worker pool, nullptr for a pool of the run's own
+    std::string tenant;                                 // Tenant of the runs in the shared pool
+    MemoryEstimate* memory_estimate = nullptr;          // Peak estimate of the runs in the shared pool
+    uint64_t spill_threshold_bytes = UINT64_MAX;        // see RunTasksOptions::spill_threshold_bytes
+    std::string spill_dir;                              // Directory of the spill file, empty for /tmp
+    std::string checkpoint_dir;                         // Directory of the run checkpoint, empty for none
+    uint32_t checkpoint_interval_ms = 0;                // Time between checkpoints
+    std::shared_ptr<Transport> transport;               // Ranks of a distributed run, nullptr to run alone
+    const GraphPartition* partition = nullptr;          // Compute nodes of each rank, with transport
+    uint64_t distributed_run = 0;                       // Sequence number of the run among the task's distributed runs
+};
+
+// Identity of an input argument: its address and, for FHE data, its Go handle value. Passing another object, or
+// assigning a new value to the same Handle, changes the key.
+using InputKey = std::pair<const void*, uint64_t>;
+
+inline InputKey input_key(const MegaAG& mega_ag,
+                          const std::unordered_map<NodeIndex, std::any>& available_data,
+                          NodeIndex index) {
+    const void* ptr = std::any_cast<const std::shared_ptr<void>&>(available_data.at(index)).get();
+    if (!mega_ag.data.at(index).fhe_prop.has_value()) {
+        return {ptr, 0};
+    }
+    return {ptr, static_cast<const Handle*>(ptr)->get()};
+}
+
+inline bool is_key_type(DataType type) {
+    return type == DataType::TYPE_RELIN_KEY || type == DataType::TYPE_GALOIS_KEY || type == DataType::TYPE_SWITCH_KEY;
+}
+
+// Results of the constant computes (see MegaAG::mark_constant_computes()) kept across runs, with the keys of the
+// offline inputs they were computed from.
+struct ConstantCache {
+    std::vector<InputKey> key;
+    std::unordered_map<NodeIndex, std::any> frontier;  // Values of mega_ag.constant_frontier
+    bool valid = false;
+
+    void clear() {
+        key.clear();
+        frontier.clear();
+        valid = false;
+    }
+};
+
+// Value and estimated size of a datum kept across runs.
+using CachedValue = std::pair<std::any, uint64_t>;
+
+// Intermediate results of the last runs kept for incremental re-execution, within a byte budget, with the keys of the
+// inputs of the last run.
+struct IncrementalCache {
+    uint64_t budget_bytes = UINT64_MAX;
+    std::unordered_map<NodeIndex, InputKey> input_keys;
+    std::unordered_map<NodeIndex, CachedValue> values;
+    uint64_t bytes = 0;
+    bool valid = false;
+
+    void clear() {
+        input_keys.clear();
+        values.clear();
+        bytes = 0;
+        valid = false;
+    }
+
+    void erase(NodeIndex index) {
+        auto it = values.find(index);
+        if (it != values.end()) {
+            bytes -= it->second.second;
+            values.erase(it);
+        }
+    }
+
+    // Values that do not fit in the remaining budget are not kept; a later run recomputes them if needed
+    void store(NodeIndex index, const std::any& value, uint64_t size) {
+        erase(index);
+        if (size <= budget_bytes - bytes) {
+            values[index] = {value, size};
+            bytes += size;
+        }
+    }
+};
+
+// Output data nodes of the output arguments with the given ids.
+inline std::vector<NodeIndex> requested_output_data(const MegaAG& mega_ag,
+                                                    gsl::span<CArgument> output_args,
+                                                    const std::vector<std::string>& output_ids) {
+    std::vector<NodeIndex> data_indices;
+    std::unordered_set<std::string> remaining(output_ids.begin(), output_ids.end());
+    size_t output_idx = 0;
+    for (const CArgument& arg : output_args) {
+        bool requested = remaining.erase(arg.id) > 0;
+        for (int j = 0; j < arg.size; ++j, ++output_idx) {
+            if (requested) {
+                data_indices.push_back(mega_ag.outputs[output_idx]);
+            }
+        }
+    }
+    if (!remaining.empty()) {
+        throw std::invalid_argument("Requested output " + *remaining.begin() + " is not an output of the task");
+    }
+    return data_indices;
+}
+
+// Plan an incremental or resumed run. The dirty computes (downstream of the changed inputs, or not completed by the
+// interrupted run) must run, and so must the ABI imports that fill the output arguments and, transitively, the
+// producers of any datum they read that is not cached; all of them limited to the demanded computes if given. All
+// other computes are skipped, and the cached data they produced for the computes that run are preloaded into
+// available_data. Returns the skipped computes.
+inline std::unordered_set<NodeIndex> plan_incremental_run(const MegaAG& mega_ag,
+                                                          const std::unordered_map<NodeIndex, CachedValue>& cached,
+                                                          const std::unordered_set<NodeIndex>& dirty,
+                                                          const std::unordered_set<NodeIndex>* demanded,
+                                                          std::unordered_map<NodeIndex, std::any>& available_data) {
+    std::unordered_set<NodeIndex> must_run;
+    for (const auto& [index, node] : mega_ag.computes) {
+        bool is_import = node.fhe_prop.has_value() && node.fhe_prop->op_type == OperationType::IMPORT_FROM_ABI;
+        if ((dirty.count(index) || is_import) && (!demanded || demanded->count(index))) {
+            must_run.insert(index);
+        }
+    }
+
+    std::vector<NodeIndex> stack(must_run.begin(), must_run.end());
+    while (!stack.empty()) {
+        const ComputeNode& node = mega_ag.computes.at(stack.back());
+        stack.pop_back();
+        for (const DatumNode* input : node.input_nodes) {
+            if (input->predecessors.empty() || cached.count(input->index)) {
+                continue;
+            }
+            NodeIndex producer = input->predecessors[0]->index;
+            if (must_run.insert(producer).second) {
+                stack.push_back(producer);
+            }
+        }
+    }
+
+    std::unordered_set<NodeIndex> skipped;
+    for (const auto& [index, node] : mega_ag.computes) {
+        if (!must_run.count(index)) {
+            skipped.insert(index);
+            continue;
+        }
+        for (const DatumNode* input : node.input_nodes) {
+            if (!input->predecessors.empty() && !must_run.count(input->predecessors[0]->index)) {
+                available_data[input->index] = cached.at(input->index).first;
+            }
+        }
+    }
+    return skipped;
+}
+
+// Fingerprint of a run for its checkpoint: the graph and the content of the input ciphertexts. Keys are not part of
+// it: identical input ciphertexts imply the same secret key, and any evaluation keys of that key give the same
+// results. Empty if the run has other inputs (plaintexts, custom data), whose content cannot be serialized: such a
+// run cannot be told apart from a run on other inputs, so it is not checkpointed.
+template <typename TContext>
+std::optional<uint64_t> run_fingerprint(const MegaAG& mega_ag,
+                                        const std::unordered_map<NodeIndex, std::any>& available_data,
+                                        TContext& context) {
+    uint64_t hash = graph_fingerprint(mega_ag);
+    for (NodeIndex index : mega_ag.inputs) {
+        const DatumNode& datum = mega_ag.data.at(index);
+        if (is_key_type(datum.datum_type)) {
+            continue;
+        }
+        if (datum.datum_type != DataType::TYPE_CIPHERTEXT || datum.fhe_prop->degree != 1) {
+            return std::nullopt;
+        }
+        const void* ptr = std::any_cast<const std::shared_ptr<void>&>(available_data.at(index)).get();
+        Bytes bytes = static_cast<const CiphertextOf<TContext>*>(ptr)->serialize(context.get_parameter());
+        hash = fnv1a(bytes.data(), bytes.size(), hash);
+    }
+    return hash;
+}
+
+// Data that an ABI import copies into an output argument. The output arguments of an interrupted run are lost, so a
+// checkpoint keeps these data until the run finishes.
+inline std::unordered_set<NodeIndex> output_sources(const MegaAG& mega_ag) {
+    std::unordered_set<NodeIndex> sources;
+    for (const auto& [index, node] : mega_ag.computes) {
+        if (node.fhe_prop.has_value() && node.fhe_prop->op_type == OperationType::IMPORT_FROM_ABI &&
+            node.output_nodes[0]->is_output) {
+            sources.insert(node.input_nodes[0]->index);
+        }
+    }
+    return sources;
+}
+
 template <HEScheme SchemeType, typename TContext>
 void _run_mega_ag_impl(gsl::span<CArgument> input_args,
                        gsl::span<CArgument> output_args,
                        const MegaAG& mega_ag,
-                       ProgressCallback progress_cb = nullptr) {
+                       ProgressCallback progress_cb,
+                       const CpuRunOptions& options,
+                       ConstantCache* constant_cache,
+                       IncrementalCache* incremental_cache,
+                       cpu_task_stats_t& stats) {
+    // Counter of the intermediate bytes held by the run, also read by the shared runtime and the memory monitor
+    LiveDataCounter live_data;
+
+    // Wait for admission by the shared runtime before building the context
+    std::unique_ptr<CpuRuntime::Admission> admission;
+    uint64_t estimated_bytes = 0;
+    if (options.runtime) {
+        const std::atomic<bool>* cancelled = options.control ? &options.control->cancelled : nullptr;
+        auto deadline = options.control ? options.control->deadline : std::chrono::steady_clock::time_point::max();
+        if (options.memory_estimate) {
+            estimated_bytes = options.memory_estimate->bytes(mega_ag, options.runtime->pool().get_thread_count());
+        }
+        admission = std::make_unique<CpuRuntime::Admission>(*options.runtime, options.tenant, estimated_bytes,
+                                                            &live_data, cancelled, deadline);
+    }
+
     std::unique_ptr<TContext> context;
     init_context<SchemeType, TContext>(mega_ag.parameter, input_args, context);
 
     auto start = std::chrono::high_resolution_clock::now();
 
-    int num_threads = std::min(32, static_cast<int>(std::thread::hardware_concurrency()));
-    BS::priority_thread_pool pool(num_threads);
+    std::unique_ptr<BS::priority_thread_pool> own_pool;
+    if (!options.runtime) {
+        int num_threads = std::min(32, static_cast<int>(std::thread::hardware_concurrency()));
+        own_pool = std::make_unique<BS::priority_thread_pool>(num_threads);
+    }
+    BS::priority_thread_pool& pool = options.runtime ? options.runtime->pool() : *own_pool;
 
     // Extract input handles and build available_data map
     std::vector<void*> input_handles = extract_input_handles(input_args, false);
@@ -76,20 +338,342 @@ void _run_mega_ag_impl(gsl::span<CArgument> input_args,
         return {};
     };
 
-    // Run CPU tasks in thread pool
+    RunTasksOptions run_options;
+    run_options.max_coalesce = options.max_coalesce;
+    run_options.fuse_chains = options.fuse_chains;
+    run_options.prioritize_outputs = options.prioritize_outputs;
+    if (options.control) {
+        run_options.cancelled = &options.control->cancelled;
+        run_options.deadline = options.control->deadline;
+    }
+    if (admission) {
+        run_options.shared_pool = true;
+        run_options.pool_priority = admission->priority();
+        run_options.may_dispatch = [&admission](size_t in_flight) { return admission->may_dispatch(in_flight); };
+        run_options.on_job_finished = [&admission](std::chrono::nanoseconds busy) { admission->record_job(busy); };
+    }
+    std::unordered_set<NodeIndex> skip_computes;
+    run_options.skip_computes = &skip_computes;
+
+    // Report each output datum by the id of its argument and its position in the argument
+    std::unordered_map<NodeIndex, std::pair<const char*, uint64_t>> output_items;
+    if (options.output_ready_cb) {
+        size_t output_idx = 0;
+        for (const CArgument& arg : output_args) {
+            for (int j = 0; j < arg.size; ++j, ++output_idx) {
+                output_items[mega_ag.outputs[output_idx]] = {arg.id, uint64_t(j)};
+            }
+        }
+        run_options.on_output_ready = [&output_items, &options](const DatumNode& datum) {
+            auto it = output_items.find(datum.index);
+            if (it != output_items.end()) {
+                options.output_ready_cb(it->second.first, it->second.second, options.output_ready_user_data);
+            }
+        };
+    }
+
+    // Compute only the backward cone of the requested outputs
+    std::unordered_set<NodeIndex> demanded;
+    const std::unordered_set<NodeIndex>* demanded_computes = nullptr;
+    if (!options.requested_outputs.empty()) {
+        demanded =
+            mega_ag.computes_upstream_of(requested_output_data(mega_ag, output_args, options.requested_outputs));
+        demanded_computes = &demanded;
+        for (const auto& [index, node] : mega_ag.computes) {
+            if (!demanded.count(index)) {
+                skip_computes.insert(index);
+            }
+        }
+    }
+
+    // Resume from the checkpoint of an interrupted run of the same graph and inputs: the computes it completed are
+    // skipped and the data they left are preloaded
+    using Ciphertext = CiphertextOf<TContext>;
+    std::unique_ptr<CheckpointDir> checkpoint;
+    std::vector<NodeIndex> completed_before;
+    std::vector<NodeIndex> resumed_data;
+    std::optional<uint64_t> fingerprint;
+    if (!options.checkpoint_dir.empty()) {
+        fingerprint = run_fingerprint(mega_ag, available_data, *context);
+    }
+    if (fingerprint) {
+        checkpoint = std::make_unique<CheckpointDir>(options.checkpoint_dir, *fingerprint);
+        if (std::optional<CheckpointDir::State> state = checkpoint->load()) {
+            std::unordered_map<NodeIndex, CachedValue> saved;
+            for (NodeIndex index : state->data) {
+                saved[index] = {std::make_shared<Ciphertext>(Ciphertext::deserialize(checkpoint->read_datum(index))),
+                                0};
+            }
+            std::unordered_set<NodeIndex> dirty;
+            for (const auto& [index, node] : mega_ag.computes) {
+                if (!state->completed.count(index)) {
+                    dirty.insert(index);
+                }
+            }
+            skip_computes = plan_incremental_run(mega_ag, saved, dirty, demanded_computes, available_data);
+            for (NodeIndex index : skip_computes) {
+                if (state->completed.count(index)) {
+                    completed_before.push_back(index);
+                }
+            }
+            resumed_data = std::move(state->data);
+        }
+    }
+    const bool resumed = !completed_before.empty();
+
+    std::unordered_set<NodeIndex> frontier(mega_ag.constant_frontier.begin(), mega_ag.constant_frontier.end());
+    bool capture_constants = false;
+    const uint64_t n = mega_ag.parameter.value("n", uint64_t(0));
+    if (resumed) {
+        // The caches are not filled by a resumed run
+        if (incremental_cache) {
+            incremental_cache->clear();
+        }
+    } else if (incremental_cache) {
+        // Re-execute only what the changed inputs affect, reusing the cached results of the rest of the graph
+        std::unordered_map<NodeIndex, InputKey> keys;
+        std::vector<NodeIndex> changed_inputs;
+        for (NodeIndex index : mega_ag.inputs) {
+            if (is_key_type(mega_ag.data.at(index).datum_type)) {
+                continue;
+            }
+            keys[index] = input_key(mega_ag, available_data, index);
+            auto it = incremental_cache->input_keys.find(index);
+            if (it == incremental_cache->input_keys.end() || it->second != keys[index]) {
+                changed_inputs.push_back(index);
+            }
+        }
+        std::unordered_set<NodeIndex> dirty = mega_ag.computes_downstream_of(changed_inputs);
+        if (incremental_cache->valid) {
+            skip_computes =
+                plan_incremental_run(mega_ag, incremental_cache->values, dirty, demanded_computes, available_data);
+        } else {
+            incremental_cache->clear();
+        }
+
+        // The results of the computes that run replace their cached values, and those of dirty computes that are not
+        // run are stale
+        for (const auto& [index, node] : mega_ag.computes) {
+            if (dirty.count(index) || !skip_computes.count(index)) {
+                for (const DatumNode* output : node.output_nodes) {
+                    incremental_cache->erase(output->index);
+                }
+            }
+        }
+        incremental_cache->input_keys = std::move(keys);
+        incremental_cache->valid = true;
+        run_options.on_datum_stored = [incremental_cache, n](const DatumNode& datum, const std::any& value) {
+            if (!datum.is_output) {
+                incremental_cache->store(datum.index, value, estimate_datum_bytes(datum, n));
+            }
+        };
+    } else if (constant_cache) {
+        // Reuse the constant results of the previous run if the offline inputs are unchanged, otherwise recompute and
+        // capture them
+        std::vector<InputKey> key;
+        for (NodeIndex index : mega_ag.offline_inputs) {
+            key.push_back(input_key(mega_ag, available_data, index));
+        }
+        if (constant_cache->valid && constant_cache->key == key) {
+            for (const auto& [index, value] : constant_cache->frontier) {
+                available_data[index] = value;
+            }
+            for (const auto& [index, node] : mega_ag.computes) {
+                if (node.is_constant) {
+                    skip_computes.insert(index);
+                }
+            }
+        } else {
+            constant_cache->clear();
+            constant_cache->key = std::move(key);
+            capture_constants = true;
+            run_options.on_datum_stored = [constant_cache, &frontier](const DatumNode& datum, const std::any& value) {
+                if (frontier.count(datum.index)) {
+                    constant_cache->frontier[datum.index] = value;
+                }
+            };
+        }
+    }
+
+    // Run only this rank's part of a distributed run: the computes of the other ranks are skipped, the data they
+    // produce for this rank are received, and the data this rank produces for them are sent
+    std::unique_ptr<RemoteExchange<TContext>> exchange;
+    size_t n_computes_remote = 0;
+    if (options.transport) {
+        const uint32_t rank = options.transport->rank();
+        for (const auto& [index, node] : mega_ag.computes) {
+            if (!options.partition->runs_on(node, rank) && skip_computes.insert(index).second) {
+                n_computes_remote++;
+            }
+        }
+        exchange = std::make_unique<RemoteExchange<TContext>>(
+            mega_ag, *options.partition, *options.transport, options.distributed_run, *context,
+            [demanded_computes](const ComputeNode& node) {
+                return !demanded_computes || demanded_computes->count(node.index) != 0;
+            });
+        auto on_datum_stored = run_options.on_datum_stored;
+        run_options.on_datum_stored = [on_datum_stored, &exchange](const DatumNode& datum, const std::any& value) {
+            if (on_datum_stored) {
+                on_datum_stored(datum, value);
+            }
+            exchange->publish(datum, value);
+        };
+        run_options.take_remote_data = [&exchange]() { return exchange->take(); };
+    }
+
+    // Checkpoint the run at intervals on a thread of its own. The data that fill the outputs are kept in memory from
+    // when they are stored until a checkpoint holds them.
+    std::mutex retained_mutex;
+    std::unordered_map<NodeIndex, std::any> retained;
+    std::unique_ptr<CheckpointWriter> checkpoint_writer;
+    if (checkpoint && options.checkpoint_interval_ms > 0) {
+        auto& param = context->get_parameter();
+        checkpoint_writer = std::make_unique<CheckpointWriter>(
+            *checkpoint,
+            [&param](NodeIndex, const std::any& value) -> std::optional<std::vector<uint8_t>> {
+                if (value.type() == typeid(Bytes)) {
+                    return std::any_cast<const Bytes&>(value);
+                }
+                if (value.type() == typeid(std::shared_ptr<Ciphertext>)) {
+                    return std::any_cast<const std::shared_ptr<Ciphertext>&>(value)->serialize(param);
+                }
+                return std::nullopt;
+            },
+            completed_before);
+
+        std::unordered_set<NodeIndex> sources = output_sources(mega_ag);
+        for (NodeIndex index : resumed_data) {
+            if (sources.count(index)) {
+                retained[index];
+            }
+        }
+        auto on_datum_stored = run_options.on_datum_stored;
+        run_options.on_datum_stored = [on_datum_stored, sources, &retained_mutex, &retained](const DatumNode& datum,
+                                                                                           const std::any& value) {
+            if (on_datum_stored) {
+                on_datum_stored(datum, value);
+            }
+            if (sources.count(datum.index)) {
+                std::lock_guard<std::mutex> lock(retained_mutex);
+                retained[datum.index] = value;
+            }
+        };
+        run_options.checkpoint_interval = std::chrono::milliseconds(options.checkpoint_interval_ms);
+        run_options.checkpoint_has_datum = [&checkpoint](NodeIndex index) { return checkpoint->has_datum(index); };
+        run_options.on_checkpoint = [&](RunSnapshot&& snapshot) {
+            std::lock_guard<std::mutex> lock(retained_mutex);
+            for (auto& [index, value] : retained) {
+                std::any& entry = snapshot.data[index];
+                if (checkpoint->has_datum(index)) {
+                    value.reset();
+                } else if (!entry.has_value()) {
+                    entry = value;
+                }
+            }
+            checkpoint_writer->submit(std::move(snapshot));
+        };
+    }
+
+    // Spill idle intermediates to disk under memory pressure
+    SpillCounters spill_counters;
+    run_options.spill_threshold_bytes = options.spill_threshold_bytes;
+    run_options.spill_dir = options.spill_dir;
+    run_options.spill_counters = &spill_counters;
+
+    // Preloaded intermediates are purged like those the run produces, so they count as live from the start
+    for (const auto& [index, value] : available_data) {
+        const DatumNode& datum = mega_ag.data.at(index);
+        if (!datum.is_input && !datum.is_output && !is_input_alias(datum)) {
+            live_data.add(estimate_datum_bytes(datum, n));
+        }
+    }
+
+    // Sample RSS and live intermediate bytes while the tasks run
+    run_options.live_data = &live_data;
+    int monitor_interval_ms = options.mem_monitor_interval_ms;
+    std::string monitor_csv_path = options.mem_monitor_csv_path;
 #ifdef LATTISENSE_DEV
-    MemoryMonitor mem_monitor(100);  // sample every 100 ms
-    mem_monitor.start(MemoryMonitor::next_csv_path("mem_usage_cpu"));
+    if (monitor_interval_ms <= 0) {
+        monitor_interval_ms = 100;  // sample every 100 ms
+        monitor_csv_path = MemoryMonitor::next_csv_path("mem_usage_cpu");
+    }
 #endif
-    run_tasks(mega_ag, pool, context, available_data, get_other_args, nullptr, nullptr, progress_cb);
-#ifdef LATTISENSE_DEV
-    mem_monitor.stop();
+    std::unique_ptr<MemoryMonitor> mem_monitor;
+    if (monitor_interval_ms > 0) {
+        mem_monitor = std::make_unique<MemoryMonitor>(monitor_interval_ms, &live_data.live_bytes);
+#ifndef LATTISENSE_DEV
+        mem_monitor->print_report = false;
 #endif
+        mem_monitor->start(monitor_csv_path);
+    }
+
+    // Run CPU tasks in thread pool. The other ranks of a distributed run are told if this one fails.
+    size_t n_computes_run = 0;
+    try {
+        n_computes_run = run_tasks(mega_ag, pool, context, available_data, get_other_args, nullptr, nullptr,
+                                   progress_cb, run_options);
+        if (exchange) {
+            exchange->flush();
+        }
+    } catch (...) {
+        if (exchange) {
+            exchange->abort();
+        }
+        throw;
+    }
+    uint64_t checkpoints_written = 0;
+    uint64_t checkpoint_bytes_written = 0;
+    if (checkpoint) {
+        // The run is complete, so its checkpoint is no longer needed
+        if (checkpoint_writer) {
+            checkpoint_writer->flush();
+            checkpoints_written = checkpoint_writer->checkpoints_written();
+            checkpoint_bytes_written = checkpoint_writer->bytes_written();
+            checkpoint_writer.reset();
+        }
+        checkpoint->remove();
+    }
+    if (admission) {
+        admission->complete();
+        if (options.memory_estimate) {
+            options.memory_estimate->observe(live_data.peak_bytes.load());
+        }
+    }
+
+    // Constant computes left out for unrequested outputs leave their frontier values missing; such a cache is not
+    // reused
+    if (capture_constants) {
+        constant_cache->valid = constant_cache->frontier.size() == frontier.size();
+    }
+
+    stats = cpu_task_stats_t{};
+    stats.n_computes_run = n_computes_run;
+    stats.n_computes_skipped = skip_computes.size() - n_computes_remote;
+    stats.cached_bytes = incremental_cache ? incremental_cache->bytes : 0;
+    stats.peak_live_bytes = live_data.peak_bytes.load();
+    stats.admission_wait_ns = admission ? admission->wait_ns() : 0;
+    stats.estimated_peak_bytes = estimated_bytes;
+    stats.spilled_bytes = spill_counters.spilled_bytes.load();
+    stats.prefetched_bytes = spill_counters.prefetched_bytes.load();
+    stats.demand_loaded_bytes = spill_counters.demand_loaded_bytes.load();
+    stats.peak_spill_file_bytes = spill_counters.peak_file_bytes.load();
+    stats.n_computes_resumed = completed_before.size();
+    stats.checkpoints_written = checkpoints_written;
+    stats.checkpoint_bytes_written = checkpoint_bytes_written;
+    stats.n_computes_remote = n_computes_remote;
+    stats.remote_bytes_sent = exchange ? exchange->bytes_sent() : 0;
+    stats.remote_bytes_received = exchange ? exchange->bytes_received() : 0;
+    if (mem_monitor) {
+        mem_monitor->stop();
+        MemoryMonitor::Sample peak = mem_monitor->peak();
+        stats.n_samples = mem_monitor->samples.size();
+        stats.peak_rss_kb = peak.rss_kb;
+    }
 
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    stats.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
 #ifdef LATTISENSE_DEV
-    std::cout << "Run CPU mega_ag time: " << duration.count() << " milliseconds" << std::endl;
+    std::cout << "Run CPU mega_ag time: " << stats.duration_ns / 1000000 << " milliseconds" << std::endl;
 #endif
 }
 
@@ -97,30 +681,37 @@ template <HEScheme SchemeType>
 void _run_mega_ag(gsl::span<CArgument> input_args,
                   gsl::span<CArgument> output_args,
                   const MegaAG& mega_ag,
-                  ProgressCallback progress_cb = nullptr) {
+                  ProgressCallback progress_cb,
+                  const CpuRunOptions& options,
+                  ConstantCache* constant_cache,
+                  IncrementalCache* incremental_cache,
+                  cpu_task_stats_t& stats) {
     // Determine TContext based on SchemeType and bootstrap parameters
     if constexpr (SchemeType == HEScheme::CKKS) {
         // Check if bootstrap parameters exist
         if (mega_ag.parameter.contains("btp_output_level")) {
             // Use CkksBtpContext for bootstrap
             using TContext = CkksBtpContext;
-            _run_mega_ag_impl<SchemeType, TContext>(input_args, output_args, mega_ag, progress_cb);
+            _run_mega_ag_impl<SchemeType, TContext>(input_args, output_args, mega_ag, progress_cb, options,
+                                                    constant_cache, incremental_cache, stats);
         } else {
             // Use regular CkksContext
             using TContext = CkksContext;
-            _run_mega_ag_impl<SchemeType, TContext>(input_args, output_args, mega_ag, progress_cb);
+            _run_mega_ag_impl<SchemeType, TContext>(input_args, output_args, mega_ag, progress_cb, options,
+                                                    constant_cache, incremental_cache, stats);
         }
     } else {
         // BFV always uses BfvContext
         using TContext = BfvContext;
-        _run_mega_ag_impl<SchemeType, TContext>(input_args, output_args, mega_ag, progress_cb);
+        _run_mega_ag_impl<SchemeType, TContext>(input_args, output_args, mega_ag, progress_cb, options, constant_cache,
+                                                incremental_cache, stats);
     }
 }
 
 class FheCpuTask {
 public:
-    FheCpuTask(const std::string& project_path)
-        : mega_ag_(MegaAG::load(project_path + "/mega_ag.json", Processor::CPU)) {}
+    FheCpuTask(const std::string& project_path, Processor processor = Processor::CPU)
+        : mega_ag_(MegaAG::load(project_path + "/mega_ag.json", processor)) {}
 
     ~FheCpuTask() {}
 
@@ -132,18 +723,131 @@ public:
         mega_ag_.bind_abi_bridge_executors(abi_export, abi_import);
     }
 
-    int run(gsl::span<CArgument> input_args, gsl::span<CArgument> output_args, ProgressCallback progress_cb = nullptr) {
-        switch (mega_ag_.algo) {
-            case Algo::ALGO_BFV: _run_mega_ag<HEScheme::BFV>(input_args, output_args, mega_ag_, progress_cb); break;
-            case Algo::ALGO_CKKS: _run_mega_ag<HEScheme::CKKS>(input_args, output_args, mega_ag_, progress_cb); break;
-            default: throw std::invalid_argument("algo not supported"); break;
+    void set_max_coalesce(size_t max_coalesce) {
+        options_.max_coalesce = max_coalesce == 0 ? 1 : max_coalesce;
+    }
+
+    void set_chain_fusion(bool enable) {
+        options_.fuse_chains = enable;
+    }
+
+    void set_requested_outputs(const std::vector<std::string>& output_ids) {
+        options_.requested_outputs = output_ids;
+    }
+
+    void set_output_priority(bool enable) {
+        options_.prioritize_outputs = enable;
+    }
+
+    void set_output_ready_callback(output_ready_callback_t callback, void* user_data) {
+        options_.output_ready_cb = callback;
+        options_.output_ready_user_data = user_data;
+    }
+
+    void set_runtime(const std::shared_ptr<CpuRuntime>& runtime, const std::string& tenant) {
+        options_.runtime = runtime;
+        options_.tenant = tenant;
+        memory_estimate_ = MemoryEstimate();
+    }
+
+    void set_mem_monitor(int interval_ms, const std::string& csv_path) {
+        options_.mem_monitor_interval_ms = interval_ms;
+        options_.mem_monitor_csv_path = csv_path;
+    }
+
+    void set_spill(uint64_t threshold_bytes, const std::string& dir) {
+        options_.spill_threshold_bytes = threshold_bytes;
+        options_.spill_dir = dir;
+    }
+
+    void set_checkpoint(const std::string& dir, uint32_t interval_ms) {
+        options_.checkpoint_dir = dir;
+        options_.checkpoint_interval_ms = interval_ms;
+    }
+
+    void set_transport(const std::shared_ptr<Transport>& transport) {
+        if (transport && mega_ag_.processor == Processor::CPU_NATIVE) {
+            throw std::invalid_argument("Distributed runs are not supported by the native CPU backend");
+        }
+        options_.transport = transport;
+        partition_ = transport ? partition_mega_ag(mega_ag_, transport->size()) : GraphPartition();
+        distributed_runs_ = 0;
+    }
+
+    const cpu_task_stats_t& last_run_stats() const {
+        return stats_;
+    }
+
+    void set_constant_folding(bool enable) {
+        fold_constants_ = enable;
+        constant_cache_.clear();
+    }
+
+    void set_incremental(bool enable, uint64_t memory_budget_bytes) {
+        incremental_ = enable;
+        incremental_cache_.clear();
+        incremental_cache_.budget_bytes = memory_budget_bytes;
+    }
+
+    void invalidate_constant_cache() {
+        constant_cache_.clear();
+        incremental_cache_.clear();
+    }
+
+    int run(gsl::span<CArgument> input_args,
+            gsl::span<CArgument> output_args,
+            ProgressCallback progress_cb = nullptr,
+            const cpu_run_control_st* control = nullptr) {
+        ConstantCache* constant_cache =
+            fold_constants_ && !mega_ag_.constant_frontier.empty() ? &constant_cache_ : nullptr;
+        IncrementalCache* incremental_cache = incremental_ ? &incremental_cache_ : nullptr;
+        CpuRunOptions options = options_;
+        options.control = control;
+        options.memory_estimate = &memory_estimate_;
+        if (options.transport) {
+            // Every rank runs the same sequence of runs, and none keeps results across runs or checkpoints them
+            options.partition = &partition_;
+            options.distributed_run = distributed_runs_++;
+            options.checkpoint_dir.clear();
+            constant_cache = nullptr;
+            incremental_cache = nullptr;
+        }
+        int ret = 0;
+        try {
+            switch (mega_ag_.algo) {
+                case Algo::ALGO_BFV:
+                    _run_mega_ag<HEScheme::BFV>(input_args, output_args, mega_ag_, progress_cb, options,
+                                                constant_cache, incremental_cache, stats_);
+                    break;
+                case Algo::ALGO_CKKS:
+                    _run_mega_ag<HEScheme::CKKS>(input_args, output_args, mega_ag_, progress_cb, options,
+                                                 constant_cache, incremental_cache, stats_);
+                    break;
+                default: throw std::invalid_argument("algo not supported"); break;
+            }
+        } catch (const RunCancelledError&) {
+            // The results kept from a partial run may not match the inputs they are keyed by
+            incremental_cache_.clear();
+            ret = CPU_RUN_CANCELLED;
+        } catch (...) {
+            incremental_cache_.clear();
+            throw;
         }
 
-        return 0;
+        return ret;
     }
 
 protected:
     MegaAG mega_ag_;
+    CpuRunOptions options_;
+    cpu_task_stats_t stats_{};
+    bool fold_constants_ = true;
+    ConstantCache constant_cache_;
+    bool incremental_ = false;
+    IncrementalCache incremental_cache_;
+    MemoryEstimate memory_estimate_;
+    GraphPartition partition_;
+    uint64_t distributed_runs_ = 0;
 };
 };  // namespace cpu_wrapper
 
@@ -153,6 +857,11 @@ fhe_task_handle create_fhe_cpu_task(const char* project_path) {
     return (fhe_task_handle)task;
 }
 
+fhe_task_handle create_fhe_cpu_native_task(const char* project_path) {
+    cpu_wrapper::FheCpuTask* task = new cpu_wrapper::FheCpuTask(project_path, Processor::CPU_NATIVE);
+    return (fhe_task_handle)task;
+}
+
 void release_fhe_cpu_task(fhe_task_handle handle) {
     cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
     delete task;
@@ -178,6 +887,139 @@ void bind_cpu_task_abi_bridge_executors(fhe_task_handle handle, void* abi_export
     task->bind_abi_bridge_executors(*export_executor, *import_executor);
 }
 
+void set_cpu_task_max_coalesce(fhe_task_handle handle, uint64_t max_coalesce) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_max_coalesce(max_coalesce);
+}
+
+void set_cpu_task_chain_fusion(fhe_task_handle handle, bool enable) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_chain_fusion(enable);
+}
+
+void set_cpu_task_requested_outputs(fhe_task_handle handle, const char** output_ids, uint64_t n_ids) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_requested_outputs(std::vector<std::string>(output_ids, output_ids + n_ids));
+}
+
+void set_cpu_task_output_priority(fhe_task_handle handle, bool enable) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_output_priority(enable);
+}
+
+void set_cpu_task_output_ready_callback(fhe_task_handle handle, output_ready_callback_t callback, void* user_data) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_output_ready_callback(callback, user_data);
+}
+
+cpu_runtime create_cpu_runtime(uint32_t num_threads) {
+    return new cpu_runtime_st{std::make_shared<CpuRuntime>(num_threads)};
+}
+
+void release_cpu_runtime(cpu_runtime runtime) {
+    delete runtime;
+}
+
+void set_cpu_runtime_tenant(cpu_runtime runtime,
+                            const char* tenant,
+                            uint32_t weight,
+                            int32_t priority,
+                            uint32_t max_concurrent_runs) {
+    CpuRuntime::TenantOptions options;
+    options.weight = weight;
+    options.priority = priority;
+    options.max_concurrent_runs = max_concurrent_runs;
+    runtime->runtime->set_tenant_options(tenant, options);
+}
+
+void get_cpu_runtime_tenant_stats(cpu_runtime runtime, const char* tenant, cpu_tenant_stats_t* stats) {
+    CpuRuntime::TenantStats tenant_stats = runtime->runtime->get_tenant_stats(tenant);
+    stats->runs_completed = tenant_stats.runs_completed;
+    stats->runs_failed = tenant_stats.runs_failed;
+    stats->active_runs = tenant_stats.active_runs;
+    stats->waiting_runs = tenant_stats.waiting_runs;
+    stats->jobs = tenant_stats.jobs;
+    stats->busy_ns = tenant_stats.busy_ns;
+    stats->wait_ns = tenant_stats.wait_ns;
+}
+
+void set_cpu_runtime_memory_budget(cpu_runtime runtime, uint64_t budget_bytes) {
+    runtime->runtime->set_memory_budget(budget_bytes);
+}
+
+uint64_t get_cpu_runtime_reserved_bytes(cpu_runtime runtime) {
+    return runtime->runtime->reserved_bytes();
+}
+
+void set_cpu_task_runtime(fhe_task_handle handle, cpu_runtime runtime, const char* tenant) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_runtime(runtime ? runtime->runtime : nullptr, tenant ? tenant : "");
+}
+
+void set_cpu_task_mem_monitor(fhe_task_handle handle, uint32_t interval_ms, const char* csv_path) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_mem_monitor(static_cast<int>(interval_ms), csv_path ? csv_path : "");
+}
+
+void set_cpu_task_spill(fhe_task_handle handle, uint64_t threshold_bytes, const char* dir) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_spill(threshold_bytes, dir ? dir : "");
+}
+
+void set_cpu_task_checkpoint(fhe_task_handle handle, const char* dir, uint32_t interval_ms) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_checkpoint(dir ? dir : "", interval_ms);
+}
+
+cpu_transport create_unix_socket_transport(const char* dir, uint32_t rank, uint32_t n_ranks) {
+    return new cpu_transport_st{std::make_shared<UnixSocketTransport>(dir ? dir : "", rank, n_ranks)};
+}
+
+void release_cpu_transport(cpu_transport transport) {
+    delete transport;
+}
+
+void set_cpu_task_transport(fhe_task_handle handle, cpu_transport transport) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_transport(transport ? transport->transport : nullptr);
+}
+
+void set_cpu_task_constant_folding(fhe_task_handle handle, bool enable) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_constant_folding(enable);
+}
+
+void set_cpu_task_incremental(fhe_task_handle handle, bool enable, uint64_t memory_budget_bytes) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->set_incremental(enable, memory_budget_bytes);
+}
+
+void invalidate_cpu_task_constant_cache(fhe_task_handle handle) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    task->invalidate_constant_cache();
+}
+
+void get_cpu_task_stats(fhe_task_handle handle, cpu_task_stats_t* stats) {
+    cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
+    *stats = task->last_run_stats();
+}
+
+cpu_run_control create_cpu_run_control(uint64_t timeout_ms) {
+    cpu_run_control control = new cpu_run_control_st();
+    if (timeout_ms > 0) {
+        control->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    }
+    return control;
+}
+
+void release_cpu_run_control(cpu_run_control control) {
+    delete control;
+}
+
+void cancel_cpu_run(cpu_run_control control) {
+    control->cancelled.store(true);
+}
+
 int run_fhe_cpu_task(fhe_task_handle handle,
                      CArgument* input_args,
                      uint64_t n_in_args,
@@ -185,6 +1027,18 @@ int run_fhe_cpu_task(fhe_task_handle handle,
                      uint64_t n_out_args,
                      progress_callback_t progress_cb,
                      void* user_data) {
+    return run_fhe_cpu_task_controlled(handle, input_args, n_in_args, output_args, n_out_args, progress_cb, user_data,
+                                       nullptr);
+}
+
+int run_fhe_cpu_task_controlled(fhe_task_handle handle,
+                                CArgument* input_args,
+                                uint64_t n_in_args,
+                                CArgument* output_args,
+                                uint64_t n_out_args,
+                                progress_callback_t progress_cb,
+                                void* user_data,
+                                cpu_run_control control) {
     cpu_wrapper::FheCpuTask* task = (cpu_wrapper::FheCpuTask*)handle;
     gsl::span<CArgument> input_arg_span{input_args, n_in_args};
     gsl::span<CArgument> output_arg_span{output_args, n_out_args};
@@ -194,6 +1048,6 @@ int run_fhe_cpu_task(fhe_task_handle handle,
     if (progress_cb) {
         cb = [progress_cb, user_data](int completed, int total) { progress_cb(completed, total, user_data); };
     }
-    return task->run(input_arg_span, output_arg_span, cb);
+    return task->run(input_arg_span, output_arg_span, cb, control);
 }
 }  // extern "C"
@@ -20,16 +20,105 @@
  * @brief CPU executor implementations for MegaAG compute nodes
  */
 
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <stdexcept>
 #include <any>
+#include <utility>
 
 #include "../mega_ag_executors.h"
 #include "fhe_lib_v2.h"
 
 using namespace fhe_ops_lib;
 
-// Helper macro to extract common executor setup with typed data
+// Kinds of executor operands; each kind gets its own typed slot array in CPU_EXECUTOR_SETUP
+enum CpuOperandKind : uint8_t {
+    OPERAND_CT,        // Ciphertext of degree 1
+    OPERAND_CT3,       // Ciphertext of degree 2, before relinearization
+    OPERAND_PT,        // Plaintext
+    OPERAND_PT_RINGT,  // Plaintext in ring t
+    OPERAND_PT_MUL,    // Plaintext in NTT and Montgomery form
+    OPERAND_KIND_COUNT
+};
+
+// Operand layout of a compute node: for each input, in order, its kind and its position among the inputs of that
+// kind. It is resolved from the FHE properties of the input data when the executor is bound, so running the node
+// only looks up and casts the input pointers.
+struct CpuOperandLayout {
+    std::vector<std::pair<CpuOperandKind, uint32_t>> slots;
+    std::array<uint32_t, OPERAND_KIND_COUNT> counts{};
+};
+
+static CpuOperandLayout make_operand_layout(const ComputeNode& node) {
+    CpuOperandLayout layout;
+    for (auto* input_node : node.input_nodes) {
+        if (!input_node->fhe_prop.has_value()) {
+            throw std::runtime_error("FHE property not found for input node");
+        }
+        CpuOperandKind kind;
+        if (input_node->datum_type == TYPE_CIPHERTEXT) {
+            kind = input_node->fhe_prop->degree == 2 ? OPERAND_CT3 : OPERAND_CT;
+        } else if (input_node->datum_type == TYPE_PLAINTEXT) {
+            if (input_node->fhe_prop->p && input_node->fhe_prop->p->is_ringt) {
+                kind = OPERAND_PT_RINGT;
+            } else if (input_node->fhe_prop->is_ntt && input_node->fhe_prop->is_mform) {
+                kind = OPERAND_PT_MUL;
+            } else {
+                kind = OPERAND_PT;
+            }
+        } else {
+            throw std::runtime_error("Unknown input datum type");
+        }
+        layout.slots.emplace_back(kind, layout.counts[kind]++);
+    }
+    return layout;
+}
+
+// Operand pointers of one kind, sized from the layout. Up to inline_capacity of them are kept on the stack, so only
+// wide nodes (MAC sums, linear transforms) allocate when they run.
+template <typename T> class OperandSlots {
+public:
+    explicit OperandSlots(size_t count) : size_(count) {
+        if (count > inline_capacity) {
+            heap_.resize(count);
+            data_ = heap_.data();
+        } else {
+            data_ = inline_.data();
+        }
+    }
+
+    OperandSlots(const OperandSlots&) = delete;
+    OperandSlots& operator=(const OperandSlots&) = delete;
+
+    T*& operator[](size_t i) {
+        return data_[i];
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    static constexpr size_t inline_capacity = 4;
+    std::array<T*, inline_capacity> inline_{};
+    std::vector<T*> heap_;
+    T** data_;
+    size_t size_;
+};
+
+// Borrow the object held by an input without copying its shared_ptr
+template <typename T> static T* operand_ptr(const std::any& input) {
+    return std::any_cast<const std::shared_ptr<T>&>(input).get();
+}
+
+// Helper macro to extract common executor setup with typed data. Expects the node's CpuOperandLayout as `layout`.
 #define CPU_EXECUTOR_SETUP(SchemeType)                                                                                 \
     using CiphertextType = std::conditional_t<SchemeType == HEScheme::BFV, BfvCiphertext, CkksCiphertext>;             \
     using Ciphertext3Type = std::conditional_t<SchemeType == HEScheme::BFV, BfvCiphertext3, CkksCiphertext3>;          \
@@ -49,32 +138,24 @@ using namespace fhe_ops_lib;
             throw std::runtime_error("Unknown CKKS context type");                                                     \
         }                                                                                                              \
     }                                                                                                                  \
-    std::vector<CiphertextType*> ciphertexts;                                                                          \
-    std::vector<Ciphertext3Type*> ciphertexts3;                                                                        \
-    std::vector<PlaintextType*> plaintexts;                                                                            \
-    std::vector<PlaintextRingtType*> plaintexts_ringt;                                                                 \
-    std::vector<PlaintextMulType*> plaintexts_mul;                                                                     \
-    for (auto* input_node : self.input_nodes) {                                                                        \
-        if (!input_node->fhe_prop.has_value()) {                                                                       \
-            throw std::runtime_error("FHE property not found for input node");                                         \
-        }                                                                                                              \
-        auto input_any = inputs.at(input_node->index);                                                                 \
-        if (input_node->datum_type == TYPE_CIPHERTEXT) {                                                               \
-            if (input_node->fhe_prop->degree == 2) {                                                                   \
-                ciphertexts3.push_back(std::any_cast<std::shared_ptr<Ciphertext3Type>>(input_any).get());              \
-            } else {                                                                                                   \
-                ciphertexts.push_back(std::any_cast<std::shared_ptr<CiphertextType>>(input_any).get());                \
-            }                                                                                                          \
-        } else if (input_node->datum_type == TYPE_PLAINTEXT) {                                                         \
-            if (input_node->fhe_prop->p && input_node->fhe_prop->p->is_ringt) {                                        \
-                plaintexts_ringt.push_back(std::any_cast<std::shared_ptr<PlaintextRingtType>>(input_any).get());       \
-            } else if (input_node->fhe_prop->is_ntt && input_node->fhe_prop->is_mform) {                               \
-                plaintexts_mul.push_back(std::any_cast<std::shared_ptr<PlaintextMulType>>(input_any).get());           \
-            } else {                                                                                                   \
-                plaintexts.push_back(std::any_cast<std::shared_ptr<PlaintextType>>(input_any).get());                  \
-            }                                                                                                          \
-        } else {                                                                                                       \
-            throw std::runtime_error("Unknown input datum type");                                                      \
+    OperandSlots<CiphertextType> ciphertexts(layout.counts[OPERAND_CT]);                                               \
+    OperandSlots<Ciphertext3Type> ciphertexts3(layout.counts[OPERAND_CT3]);                                            \
+    OperandSlots<PlaintextType> plaintexts(layout.counts[OPERAND_PT]);                                                 \
+    OperandSlots<PlaintextRingtType> plaintexts_ringt(layout.counts[OPERAND_PT_RINGT]);                                \
+    OperandSlots<PlaintextMulType> plaintexts_mul(layout.counts[OPERAND_PT_MUL]);                                      \
+    if (self.input_nodes.size() != layout.slots.size()) {                                                              \
+        throw std::runtime_error("Operand layout does not match the inputs of the compute node");                      \
+    }                                                                                                                  \
+    for (size_t i = 0; i < layout.slots.size(); i++) {                                                                 \
+        const std::any& input_any = inputs.at(self.input_nodes[i]->index);                                             \
+        const uint32_t slot = layout.slots[i].second;                                                                  \
+        switch (layout.slots[i].first) {                                                                               \
+            case OPERAND_CT: ciphertexts[slot] = operand_ptr<CiphertextType>(input_any); break;                        \
+            case OPERAND_CT3: ciphertexts3[slot] = operand_ptr<Ciphertext3Type>(input_any); break;                     \
+            case OPERAND_PT: plaintexts[slot] = operand_ptr<PlaintextType>(input_any); break;                          \
+            case OPERAND_PT_RINGT: plaintexts_ringt[slot] = operand_ptr<PlaintextRingtType>(input_any); break;         \
+            case OPERAND_PT_MUL: plaintexts_mul[slot] = operand_ptr<PlaintextMulType>(input_any); break;               \
+            default: throw std::runtime_error("Unknown operand kind");                                                 \
         }                                                                                                              \
     }
 
@@ -93,11 +174,117 @@ static DatumNode* find_plaintext_node(const ComputeNode& node) {
     return nullptr;
 }
 
+using PolyFunction = double (*)(double);
+
+// Built-in functions for POLY_EVAL, approximated by Lattigo over the node's interval
+static double poly_relu(double x) {
+    return x > 0 ? x : 0.0;
+}
+static double poly_sigmoid(double x) {
+    return 1.0 / (1.0 + std::exp(-x));
+}
+static double poly_tanh(double x) {
+    return std::tanh(x);
+}
+static double poly_exp(double x) {
+    return std::exp(x);
+}
+static double poly_gelu(double x) {
+    return 0.5 * x * (1.0 + std::erf(x / std::sqrt(2.0)));
+}
+static double poly_silu(double x) {
+    return x / (1.0 + std::exp(-x));
+}
+
+static const std::map<std::string, PolyFunction> poly_builtin_functions = {
+    {"relu", poly_relu}, {"sigmoid", poly_sigmoid}, {"tanh", poly_tanh},
+    {"exp", poly_exp},   {"gelu", poly_gelu},       {"silu", poly_silu},
+};
+
+// Coefficient polynomial of a POLY_EVAL node, evaluated in plain arithmetic
+struct PolyCoeffs {
+    std::vector<double> coeffs;
+    bool chebyshev;
+    double left;
+    double right;
+
+    double operator()(double x) const {
+        if (!chebyshev) {
+            double y = 0.0;
+            for (auto it = coeffs.rbegin(); it != coeffs.rend(); ++it) {
+                y = y * x + *it;
+            }
+            return y;
+        }
+        // Clenshaw recurrence on x mapped onto [-1, 1]
+        double t = (2.0 * x - left - right) / (right - left);
+        double b1 = 0.0, b2 = 0.0;
+        for (size_t k = coeffs.size() - 1; k > 0; k--) {
+            double b0 = 2.0 * t * b1 - b2 + coeffs[k];
+            b2 = b1;
+            b1 = b0;
+        }
+        return t * b1 - b2 + coeffs[0];
+    }
+};
+
+// PolyEvalFunction only accepts a plain function pointer, which Lattigo samples synchronously to interpolate
+// the polynomial. A coefficient polynomial is bound to one of a fixed set of trampolines for the duration of
+// the call; concurrent POLY_EVAL nodes each hold their own slot.
+static constexpr size_t poly_slot_count = 32;
+static std::array<const PolyCoeffs*, poly_slot_count> poly_slot_coeffs{};
+static std::mutex poly_slot_mutex;
+static std::condition_variable poly_slot_cv;
+
+template <size_t I> static double poly_slot_trampoline(double x) {
+    return (*poly_slot_coeffs[I])(x);
+}
+
+template <size_t... I>
+static constexpr std::array<PolyFunction, sizeof...(I)> make_poly_slot_trampolines(std::index_sequence<I...>) {
+    return {&poly_slot_trampoline<I>...};
+}
+
+static const std::array<PolyFunction, poly_slot_count> poly_slot_trampolines =
+    make_poly_slot_trampolines(std::make_index_sequence<poly_slot_count>{});
+
+class PolySlotGuard {
+public:
+    explicit PolySlotGuard(const PolyCoeffs* coeffs) {
+        std::unique_lock<std::mutex> lock(poly_slot_mutex);
+        poly_slot_cv.wait(lock, [this] {
+            for (slot_ = 0; slot_ < poly_slot_count; slot_++) {
+                if (poly_slot_coeffs[slot_] == nullptr) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        poly_slot_coeffs[slot_] = coeffs;
+    }
+
+    ~PolySlotGuard() {
+        {
+            std::lock_guard<std::mutex> lock(poly_slot_mutex);
+            poly_slot_coeffs[slot_] = nullptr;
+        }
+        poly_slot_cv.notify_one();
+    }
+
+    PolyFunction function() const {
+        return poly_slot_trampolines[slot_];
+    }
+
+private:
+    size_t slot_ = 0;
+};
+
 template <HEScheme SchemeType> void bind_cpu_add(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if (node.input_nodes.size() == 1) {
         // Single input: ct + ct (same input)
-        node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                           std::any& output, const ComputeNode& self) -> void {
+        node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                 std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             output = std::make_shared<CiphertextType>(context->add(*ciphertexts[0], *ciphertexts[0]));
         };
@@ -106,24 +293,24 @@ template <HEScheme SchemeType> void bind_cpu_add(ComputeNode& node) {
         if (pt_node) {
             if (pt_node->fhe_prop->p && pt_node->fhe_prop->p->is_ringt) {
                 // ct + pt_ringt (BFV and CKKS)
-                node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                   std::any& output, const ComputeNode& self) -> void {
+                node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
                     CPU_EXECUTOR_SETUP(SchemeType);
                     output = std::make_shared<CiphertextType>(
                         context->add_plain_ringt(*ciphertexts[0], *plaintexts_ringt[0]));
                 };
             } else {
                 // ct + pt (normal)
-                node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                   std::any& output, const ComputeNode& self) -> void {
+                node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
                     CPU_EXECUTOR_SETUP(SchemeType);
                     output = std::make_shared<CiphertextType>(context->add_plain(*ciphertexts[0], *plaintexts[0]));
                 };
             }
         } else {
             // ct + ct
-            node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                               std::any& output, const ComputeNode& self) -> void {
+            node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                     std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 output = std::make_shared<CiphertextType>(context->add(*ciphertexts[0], *ciphertexts[1]));
             };
@@ -132,10 +319,11 @@ template <HEScheme SchemeType> void bind_cpu_add(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_sub(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if (node.input_nodes.size() == 1) {
         // Single input: ct - ct (same input)
-        node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                           std::any& output, const ComputeNode& self) -> void {
+        node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                 std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             output = std::make_shared<CiphertextType>(context->sub(*ciphertexts[0], *ciphertexts[0]));
         };
@@ -144,24 +332,24 @@ template <HEScheme SchemeType> void bind_cpu_sub(ComputeNode& node) {
         if (pt_node) {
             if (pt_node->fhe_prop->p && pt_node->fhe_prop->p->is_ringt) {
                 // ct - pt_ringt (BFV and CKKS)
-                node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                   std::any& output, const ComputeNode& self) -> void {
+                node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
                     CPU_EXECUTOR_SETUP(SchemeType);
                     output = std::make_shared<CiphertextType>(
                         context->sub_plain_ringt(*ciphertexts[0], *plaintexts_ringt[0]));
                 };
             } else {
                 // ct - pt (normal)
-                node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                   std::any& output, const ComputeNode& self) -> void {
+                node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
                     CPU_EXECUTOR_SETUP(SchemeType);
                     output = std::make_shared<CiphertextType>(context->sub_plain(*ciphertexts[0], *plaintexts[0]));
                 };
             }
         } else {
             // ct - ct
-            node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                               std::any& output, const ComputeNode& self) -> void {
+            node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                     std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 output = std::make_shared<CiphertextType>(context->sub(*ciphertexts[0], *ciphertexts[1]));
             };
@@ -170,18 +358,20 @@ template <HEScheme SchemeType> void bind_cpu_sub(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_neg(ComputeNode& node) {
-    node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs, std::any& output,
-                       const ComputeNode& self) -> void {
+    const CpuOperandLayout layout = make_operand_layout(node);
+    node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                             std::any& output, const ComputeNode& self) -> void {
         CPU_EXECUTOR_SETUP(SchemeType);
         output = std::make_shared<CiphertextType>(context->negate(*ciphertexts[0]));
     };
 }
 
 template <HEScheme SchemeType> void bind_cpu_mult(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if (node.input_nodes.size() == 1) {
         // Single input: ct * ct (same input)
-        node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                           std::any& output, const ComputeNode& self) -> void {
+        node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                 std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             output = std::make_shared<Ciphertext3Type>(context->mult(*ciphertexts[0], *ciphertexts[0]));
         };
@@ -191,15 +381,15 @@ template <HEScheme SchemeType> void bind_cpu_mult(ComputeNode& node) {
             if (pt_node->fhe_prop->p && pt_node->fhe_prop->p->is_ringt) {
                 // ct * pt_ringt
                 if constexpr (SchemeType == HEScheme::BFV) {
-                    node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                       std::any& output, const ComputeNode& self) -> void {
+                    node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex,
+                                             std::any>& inputs, std::any& output, const ComputeNode& self) -> void {
                         CPU_EXECUTOR_SETUP(SchemeType);
                         output = std::make_shared<CiphertextType>(
                             context->mult_plain_ringt(*ciphertexts[0], *plaintexts_ringt[0]));
                     };
                 } else {
-                    node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                       std::any& output, const ComputeNode& self) -> void {
+                    node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex,
+                                             std::any>& inputs, std::any& output, const ComputeNode& self) -> void {
                         CPU_EXECUTOR_SETUP(SchemeType);
                         int level = ciphertexts[0]->get_level();
                         PlaintextMulType pt_mul = context->ringt_to_mul(*plaintexts_ringt[0], level);
@@ -208,24 +398,24 @@ template <HEScheme SchemeType> void bind_cpu_mult(ComputeNode& node) {
                 }
             } else if (pt_node->fhe_prop->is_ntt && pt_node->fhe_prop->is_mform) {
                 // ct * pt_mul
-                node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                   std::any& output, const ComputeNode& self) -> void {
+                node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
                     CPU_EXECUTOR_SETUP(SchemeType);
                     output =
                         std::make_shared<CiphertextType>(context->mult_plain_mul(*ciphertexts[0], *plaintexts_mul[0]));
                 };
             } else {
                 // ct * pt (normal)
-                node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                   std::any& output, const ComputeNode& self) -> void {
+                node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
                     CPU_EXECUTOR_SETUP(SchemeType);
                     output = std::make_shared<CiphertextType>(context->mult_plain(*ciphertexts[0], *plaintexts[0]));
                 };
             }
         } else {
             // ct * ct
-            node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                               std::any& output, const ComputeNode& self) -> void {
+            node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                     std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 output = std::make_shared<Ciphertext3Type>(context->mult(*ciphertexts[0], *ciphertexts[1]));
             };
@@ -234,16 +424,18 @@ template <HEScheme SchemeType> void bind_cpu_mult(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_relin(ComputeNode& node) {
-    node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs, std::any& output,
-                       const ComputeNode& self) -> void {
+    const CpuOperandLayout layout = make_operand_layout(node);
+    node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                             std::any& output, const ComputeNode& self) -> void {
         CPU_EXECUTOR_SETUP(SchemeType);
         output = std::make_shared<CiphertextType>(context->relinearize(*ciphertexts3[0]));
     };
 }
 
 template <HEScheme SchemeType> void bind_cpu_rescale(ComputeNode& node) {
-    node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs, std::any& output,
-                       const ComputeNode& self) -> void {
+    const CpuOperandLayout layout = make_operand_layout(node);
+    node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                             std::any& output, const ComputeNode& self) -> void {
         CPU_EXECUTOR_SETUP(SchemeType);
         if constexpr (SchemeType == HEScheme::BFV) {
             output = std::make_shared<CiphertextType>(context->rescale(*ciphertexts[0]));
@@ -255,9 +447,10 @@ template <HEScheme SchemeType> void bind_cpu_rescale(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_drop_level(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if constexpr (SchemeType == HEScheme::CKKS) {
-        node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                           std::any& output, const ComputeNode& self) -> void {
+        node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                 std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             output = std::make_shared<CiphertextType>(context->drop_level(*ciphertexts[0], 1));
         };
@@ -267,12 +460,13 @@ template <HEScheme SchemeType> void bind_cpu_drop_level(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_rotate_col(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if (!node.fhe_prop->p.has_value()) {
         throw std::runtime_error("ROTATE_COL requires rotation_step property");
     }
     int step = node.fhe_prop->p->rotation_step;
-    node.executor = [step](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                           std::any& output, const ComputeNode& self) -> void {
+    node.executor = [step, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                   std::any& output, const ComputeNode& self) -> void {
         CPU_EXECUTOR_SETUP(SchemeType);
         if constexpr (SchemeType == HEScheme::BFV) {
             output = std::make_shared<CiphertextType>(context->advanced_rotate_cols(*ciphertexts[0], step));
@@ -283,8 +477,9 @@ template <HEScheme SchemeType> void bind_cpu_rotate_col(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_rotate_row(ComputeNode& node) {
-    node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs, std::any& output,
-                       const ComputeNode& self) -> void {
+    const CpuOperandLayout layout = make_operand_layout(node);
+    node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                             std::any& output, const ComputeNode& self) -> void {
         CPU_EXECUTOR_SETUP(SchemeType);
         if constexpr (SchemeType == HEScheme::BFV) {
             output = std::make_shared<CiphertextType>(context->rotate_rows(*ciphertexts[0]));
@@ -295,6 +490,7 @@ template <HEScheme SchemeType> void bind_cpu_rotate_row(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_cmpac_sum(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if (!node.fhe_prop->p.has_value()) {
         throw std::runtime_error("MAC_W_PARTIAL_SUM requires sum_cnt property");
     }
@@ -307,8 +503,8 @@ template <HEScheme SchemeType> void bind_cpu_cmpac_sum(ComputeNode& node) {
     if (pt_node->fhe_prop->p && pt_node->fhe_prop->p->is_ringt) {
         // ct * pt_ringt
         if constexpr (SchemeType == HEScheme::BFV) {
-            node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                std::any& output, const ComputeNode& self) -> void {
+            node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                        std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 std::vector<CiphertextType> products(n);
                 for (int i = 0; i < n; i++) {
@@ -322,8 +518,8 @@ template <HEScheme SchemeType> void bind_cpu_cmpac_sum(ComputeNode& node) {
             };
         } else {
             // CKKS: convert pt_ringt to pt_mul then multiply
-            node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                std::any& output, const ComputeNode& self) -> void {
+            node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                        std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 std::vector<CiphertextType> products(n);
                 for (int i = 0; i < n; i++) {
@@ -340,8 +536,8 @@ template <HEScheme SchemeType> void bind_cpu_cmpac_sum(ComputeNode& node) {
         }
     } else if (pt_node->fhe_prop->is_ntt && pt_node->fhe_prop->is_mform) {
         // ct * pt_mul
-        node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                            std::any& output, const ComputeNode& self) -> void {
+        node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                    std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             std::vector<CiphertextType> products(n);
             for (int i = 0; i < n; i++) {
@@ -355,8 +551,8 @@ template <HEScheme SchemeType> void bind_cpu_cmpac_sum(ComputeNode& node) {
         };
     } else {
         // ct * pt (normal)
-        node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                            std::any& output, const ComputeNode& self) -> void {
+        node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                    std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             std::vector<CiphertextType> products(n);
             for (int i = 0; i < n; i++) {
@@ -372,6 +568,7 @@ template <HEScheme SchemeType> void bind_cpu_cmpac_sum(ComputeNode& node) {
 }
 
 template <HEScheme SchemeType> void bind_cpu_cmp_sum(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
     if (!node.fhe_prop->p.has_value()) {
         throw std::runtime_error("MAC_WO_PARTIAL_SUM requires sum_cnt property");
     }
@@ -384,8 +581,8 @@ template <HEScheme SchemeType> void bind_cpu_cmp_sum(ComputeNode& node) {
     if (pt_node->fhe_prop->p && pt_node->fhe_prop->p->is_ringt) {
         // ct * pt_ringt
         if constexpr (SchemeType == HEScheme::BFV) {
-            node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                std::any& output, const ComputeNode& self) -> void {
+            node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                        std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 std::vector<CiphertextType> products(n);
                 for (int i = 0; i < n; i++) {
@@ -399,8 +596,8 @@ template <HEScheme SchemeType> void bind_cpu_cmp_sum(ComputeNode& node) {
             };
         } else {
             // CKKS: convert pt_ringt to pt_mul then multiply
-            node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                                std::any& output, const ComputeNode& self) -> void {
+            node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                        std::any& output, const ComputeNode& self) -> void {
                 CPU_EXECUTOR_SETUP(SchemeType);
                 std::vector<CiphertextType> products(n);
                 for (int i = 0; i < n; i++) {
@@ -417,8 +614,8 @@ template <HEScheme SchemeType> void bind_cpu_cmp_sum(ComputeNode& node) {
         }
     } else if (pt_node->fhe_prop->is_ntt && pt_node->fhe_prop->is_mform) {
         // ct * pt_mul
-        node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                            std::any& output, const ComputeNode& self) -> void {
+        node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                    std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             std::vector<CiphertextType> products(n);
             for (int i = 0; i < n; i++) {
@@ -432,8 +629,8 @@ template <HEScheme SchemeType> void bind_cpu_cmp_sum(ComputeNode& node) {
         };
     } else {
         // ct * pt (normal)
-        node.executor = [n](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                            std::any& output, const ComputeNode& self) -> void {
+        node.executor = [n, layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                    std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             std::vector<CiphertextType> products(n);
             for (int i = 0; i < n; i++) {
@@ -450,8 +647,9 @@ template <HEScheme SchemeType> void bind_cpu_cmp_sum(ComputeNode& node) {
 
 template <HEScheme SchemeType> void bind_cpu_bootstrap(ComputeNode& node) {
     if constexpr (SchemeType == HEScheme::CKKS) {
-        node.executor = [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
-                           std::any& output, const ComputeNode& self) -> void {
+        const CpuOperandLayout layout = make_operand_layout(node);
+        node.executor = [layout](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                 std::any& output, const ComputeNode& self) -> void {
             CPU_EXECUTOR_SETUP(SchemeType);
             auto* btp_context = dynamic_cast<CkksBtpContext*>(context);
             if (!btp_context) {
@@ -468,6 +666,118 @@ template <HEScheme SchemeType> void bind_cpu_bootstrap(ComputeNode& node) {
     }
 }
 
+template <HEScheme SchemeType> void bind_cpu_linear_transform(ComputeNode& node) {
+    const CpuOperandLayout layout = make_operand_layout(node);
+    if (!node.fhe_prop->p.has_value() || node.fhe_prop->p->bsgs_n1 <= 0) {
+        throw std::runtime_error("LINEAR_TRANSFORM requires diag_indices and bsgs_n1 properties");
+    }
+    const std::vector<int32_t> diag_indices = node.fhe_prop->p->diag_indices;
+    const int32_t n1 = node.fhe_prop->p->bsgs_n1;
+    if (diag_indices.empty() || node.input_nodes.size() != diag_indices.size() + 1) {
+        throw std::runtime_error("LINEAR_TRANSFORM expects one ciphertext and one pt_mul per diagonal");
+    }
+
+    // Group diagonals by giant step: giant_step -> [(baby_step, position of the diagonal in pt_mul inputs)]
+    std::map<int32_t, std::vector<std::pair<int32_t, size_t>>> giant_groups;
+    std::set<int32_t> baby_step_set;
+    for (size_t i = 0; i < diag_indices.size(); i++) {
+        int32_t baby = diag_indices[i] % n1;
+        giant_groups[diag_indices[i] - baby].emplace_back(baby, i);
+        if (baby != 0) {
+            baby_step_set.insert(baby);
+        }
+    }
+    const std::vector<int32_t> baby_steps(baby_step_set.begin(), baby_step_set.end());
+
+    node.executor = [giant_groups, baby_steps, layout](ExecutionContext& ctx,
+                                                       const std::unordered_map<NodeIndex, std::any>& inputs,
+                                                       std::any& output, const ComputeNode& self) -> void {
+        CPU_EXECUTOR_SETUP(SchemeType);
+        const CiphertextType& x = *ciphertexts[0];
+
+        // Baby steps share one hoisted key-switch decomposition of x
+        std::map<int32_t, CiphertextType> rotated;
+        if (!baby_steps.empty()) {
+            if constexpr (SchemeType == HEScheme::BFV) {
+                rotated = context->advanced_rotate_cols(x, baby_steps);
+            } else {
+                rotated = context->advanced_rotate(x, baby_steps);
+            }
+        }
+
+        std::optional<CiphertextType> result;
+        for (const auto& [giant, group] : giant_groups) {
+            std::optional<CiphertextType> inner;
+            for (const auto& [baby, pt_pos] : group) {
+                const CiphertextType& x_rot = baby == 0 ? x : rotated.at(baby);
+                CiphertextType prod = context->mult_plain_mul(x_rot, *plaintexts_mul[pt_pos]);
+                inner = inner ? context->add(*inner, prod) : std::move(prod);
+            }
+            if (giant != 0) {
+                if constexpr (SchemeType == HEScheme::BFV) {
+                    inner = context->advanced_rotate_cols(*inner, giant);
+                } else {
+                    inner = context->advanced_rotate(*inner, giant);
+                }
+            }
+            result = result ? context->add(*result, *inner) : std::move(*inner);
+        }
+        output = std::make_shared<CiphertextType>(std::move(*result));
+    };
+}
+
+template <HEScheme SchemeType> void bind_cpu_poly_eval(ComputeNode& node) {
+    if constexpr (SchemeType == HEScheme::CKKS) {
+        const CpuOperandLayout layout = make_operand_layout(node);
+        if (!node.fhe_prop->p.has_value() || node.fhe_prop->p->poly_degree <= 0) {
+            throw std::runtime_error("POLY_EVAL requires poly_interval and poly_degree properties");
+        }
+        const auto& prop = *node.fhe_prop->p;
+        PolyFunction builtin = nullptr;
+        std::shared_ptr<const PolyCoeffs> coeffs;
+        if (!prop.poly_func.empty()) {
+            auto it = poly_builtin_functions.find(prop.poly_func);
+            if (it == poly_builtin_functions.end()) {
+                throw std::runtime_error("POLY_EVAL unsupported function: " + prop.poly_func);
+            }
+            builtin = it->second;
+        } else if (!prop.poly_coeffs.empty()) {
+            coeffs = std::make_shared<const PolyCoeffs>(
+                PolyCoeffs{prop.poly_coeffs, prop.poly_chebyshev, prop.poly_left, prop.poly_right});
+        } else {
+            throw std::runtime_error("POLY_EVAL requires poly_func or poly_coeffs property");
+        }
+        const double left = prop.poly_left;
+        const double right = prop.poly_right;
+        const int degree = prop.poly_degree;
+
+        node.executor = [builtin, coeffs, left, right, degree, layout](
+                            ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                            std::any& output, const ComputeNode& self) -> void {
+            CPU_EXECUTOR_SETUP(SchemeType);
+            std::optional<CiphertextType> result;
+            if (builtin) {
+                result = context->poly_eval_function(builtin, *ciphertexts[0], left, right, degree);
+            } else {
+                PolySlotGuard slot(coeffs.get());
+                result = context->poly_eval_function(slot.function(), *ciphertexts[0], left, right, degree);
+            }
+
+            // The frontend reserves an upper bound on the evaluation depth; align to the level it declared
+            int target_level = self.output_nodes[0]->fhe_prop->level;
+            if (result->get_level() < target_level) {
+                throw std::runtime_error("POLY_EVAL consumed more levels than the frontend reserved");
+            }
+            if (result->get_level() > target_level) {
+                result = context->drop_level(*result, result->get_level() - target_level);
+            }
+            output = std::make_shared<CiphertextType>(std::move(*result));
+        };
+    } else {
+        throw std::runtime_error("POLY_EVAL only supported for CKKS scheme");
+    }
+}
+
 // Explicit template instantiations
 template void bind_cpu_add<HEScheme::BFV>(ComputeNode& node);
 template void bind_cpu_add<HEScheme::CKKS>(ComputeNode& node);
@@ -503,6 +813,11 @@ template void bind_cpu_cmp_sum<HEScheme::CKKS>(ComputeNode& node);
 
 template void bind_cpu_bootstrap<HEScheme::CKKS>(ComputeNode& node);
 
+template void bind_cpu_linear_transform<HEScheme::BFV>(ComputeNode& node);
+template void bind_cpu_linear_transform<HEScheme::CKKS>(ComputeNode& node);
+
+template void bind_cpu_poly_eval<HEScheme::CKKS>(ComputeNode& node);
+
 // Wrapper function for ExecutorBinder (callable from mega_ag.cpp)
 void bind_cpu_executor(ComputeNode& node, Algo algorithm) {
     if (!node.fhe_prop.has_value()) {
@@ -522,6 +837,7 @@ void bind_cpu_executor(ComputeNode& node, Algo algorithm) {
                 case OperationType::ROTATE_ROW: bind_cpu_rotate_row<HEScheme::BFV>(node); break;
                 case OperationType::MAC_W_PARTIAL_SUM: bind_cpu_cmpac_sum<HEScheme::BFV>(node); break;
                 case OperationType::MAC_WO_PARTIAL_SUM: bind_cpu_cmp_sum<HEScheme::BFV>(node); break;
+                case OperationType::LINEAR_TRANSFORM: bind_cpu_linear_transform<HEScheme::BFV>(node); break;
                 default: throw std::runtime_error("Unsupported operation type for CPU BFV");
             }
             break;
@@ -539,6 +855,8 @@ void bind_cpu_executor(ComputeNode& node, Algo algorithm) {
                 case OperationType::MAC_W_PARTIAL_SUM: bind_cpu_cmpac_sum<HEScheme::CKKS>(node); break;
                 case OperationType::MAC_WO_PARTIAL_SUM: bind_cpu_cmp_sum<HEScheme::CKKS>(node); break;
                 case OperationType::BOOTSTRAP: bind_cpu_bootstrap<HEScheme::CKKS>(node); break;
+                case OperationType::LINEAR_TRANSFORM: bind_cpu_linear_transform<HEScheme::CKKS>(node); break;
+                case OperationType::POLY_EVAL: bind_cpu_poly_eval<HEScheme::CKKS>(node); break;
                 default: throw std::runtime_error("Unsupported operation type for CPU CKKS");
             }
             break;
@@ -0,0 +1,487 @@
+/*
+ * Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file mega_ag_executors_cpu_native.cpp
+ * @brief Native CPU executor implementations for MegaAG compute nodes
+ *
+ * The native executors compute on the ABI structs (CCiphertext, CPlaintext) that the heterogeneous bridge executors
+ * export, with the vectorized kernels of native_kernels.h in place of Lattigo calls. They cover the element-wise
+ * operations and the CKKS rescale, and produce the same words as the Lattigo executors. Key switching (relinearize,
+ * rotate, bootstrap) and the operations on plaintexts in ring t are not supported and fail when the node is bound.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <any>
+#include <unordered_map>
+#include <vector>
+
+#include "../mega_ag_executors.h"
+#include "fhe_lib_v2.h"
+#include "native_kernels.h"
+
+extern "C" {
+#include "../../abi/c_structs.h"
+}
+
+using namespace fhe_ops_lib;
+using namespace cpu_native;
+
+namespace {
+
+// Moduli of a parameter set, and the NTT tables of the moduli a rescale has divided by
+struct NativeRing {
+    uint64_t parameter = 0;  // Handle of the parameter
+    size_t n = 0;
+    std::vector<Modulus> moduli;
+    std::mutex ntt_mutex;
+    std::vector<std::unique_ptr<const NttTables>> ntt;  // Built on first use by ckks_ntt_tables()
+};
+
+// Ring of a parameter set, built on first use. Parameter handles are never reused, so the rings are kept for the
+// lifetime of the process.
+template <typename ParameterType> NativeRing& ring_of(const ParameterType& param) {
+    static std::mutex mutex;
+    static std::unordered_map<uint64_t, std::unique_ptr<NativeRing>> rings;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<NativeRing>& ring = rings[param.get()];
+    if (!ring) {
+        ring = std::make_unique<NativeRing>();
+        ring->parameter = param.get();
+        ring->n = param.get_n();
+        for (int i = 0; i <= param.get_max_level(); i++) {
+            ring->moduli.emplace_back(param.get_q(i));
+        }
+        ring->ntt.resize(ring->moduli.size());
+    }
+    return *ring;
+}
+
+template <HEScheme SchemeType> NativeRing& ring_of(ExecutionContext& ctx) {
+    if constexpr (SchemeType == HEScheme::BFV) {
+        if (auto* bfv_ctx = ctx.get_arithmetic_context<BfvContext>()) {
+            return ring_of(bfv_ctx->get_parameter());
+        }
+        throw std::runtime_error("BFV context not found for native CPU executor");
+    } else {
+        if (auto* ckks_ctx = ctx.get_arithmetic_context<CkksContext>()) {
+            return ring_of(ckks_ctx->get_parameter());
+        } else if (auto* ckks_btp_ctx = ctx.get_arithmetic_context<CkksBtpContext>()) {
+            return ring_of(ckks_btp_ctx->get_parameter());
+        }
+        throw std::runtime_error("Unknown CKKS context type");
+    }
+}
+
+// NTT tables of CKKS modulus `index`. The root of unity is read from the transform of the monomial X by Lattigo,
+// which holds it at position 0, and the tables are checked to reproduce that whole transform, so that both NTTs
+// evaluate at the same points in the same order.
+const NttTables& ckks_ntt_tables(NativeRing& ring, int index) {
+    std::lock_guard<std::mutex> lock(ring.ntt_mutex);
+    std::unique_ptr<const NttTables>& tables = ring.ntt[index];
+    if (!tables) {
+        std::vector<uint64_t> expected(ring.n, 0);
+        expected[1] = 1;
+        ckks_component_ntt(ring.parameter, expected.data(), index);
+        auto candidate = std::make_unique<const NttTables>(ring.moduli[index], ring.n, expected[0]);
+        std::vector<uint64_t> monomial(ring.n, 0);
+        monomial[1] = 1;
+        candidate->forward(monomial.data());
+        if (monomial != expected) {
+            throw std::runtime_error("Native NTT does not match the NTT of modulus " + std::to_string(index));
+        }
+        tables = std::move(candidate);
+    }
+    return *tables;
+}
+
+const CCiphertext& ciphertext_input(const std::unordered_map<NodeIndex, std::any>& inputs, const DatumNode* node) {
+    const std::any& value = inputs.at(node->index);
+    if (value.type() != typeid(std::shared_ptr<CCiphertext>)) {
+        throw std::runtime_error("Input " + node->id + " of a native CPU node is not an ABI ciphertext");
+    }
+    return *std::any_cast<const std::shared_ptr<CCiphertext>&>(value);
+}
+
+const CPlaintext& plaintext_input(const std::unordered_map<NodeIndex, std::any>& inputs, const DatumNode* node) {
+    const std::any& value = inputs.at(node->index);
+    if (value.type() != typeid(std::shared_ptr<CPlaintext>)) {
+        throw std::runtime_error("Input " + node->id + " of a native CPU node is not an ABI plaintext");
+    }
+    return *std::any_cast<const std::shared_ptr<CPlaintext>&>(value);
+}
+
+void check_level(const CCiphertext& ct, int level) {
+    if (ct.level < level) {
+        throw std::runtime_error("Ciphertext level " + std::to_string(ct.level) + " is below the level " +
+                                 std::to_string(level) + " of the native CPU node");
+    }
+}
+
+void check_level(const CPlaintext& pt, int level) {
+    if (pt.poly.n_component <= level) {
+        throw std::runtime_error("Plaintext level " + std::to_string(pt.poly.n_component - 1) +
+                                 " is below the level " + std::to_string(level) + " of the native CPU node");
+    }
+}
+
+std::shared_ptr<CCiphertext> new_ciphertext(int degree, int level, size_t n) {
+    CCiphertext* ct = (CCiphertext*)malloc(sizeof(CCiphertext));
+    alloc_ciphertext_contiguous(ct, degree, level, static_cast<int>(n));
+    if (!ct->polys) {
+        free(ct);
+        throw std::bad_alloc();
+    }
+    return std::shared_ptr<CCiphertext>(ct, [](CCiphertext* p) {
+        free_ciphertext_contiguous(p);
+        free(p);
+    });
+}
+
+inline uint64_t* component(const CCiphertext& ct, int poly, int index) {
+    return ct.polys[poly].components[index].data;
+}
+
+inline const uint64_t* component(const CPlaintext& pt, int index) {
+    return pt.poly.components[index].data;
+}
+
+enum class PlaintextForm { NORMAL, MUL, RINGT };
+
+PlaintextForm plaintext_form(const DatumNode* node) {
+    if (!node->fhe_prop.has_value()) {
+        throw std::runtime_error("FHE property not found for input node");
+    }
+    if (node->fhe_prop->p && node->fhe_prop->p->is_ringt) {
+        return PlaintextForm::RINGT;
+    }
+    return node->fhe_prop->is_ntt && node->fhe_prop->is_mform ? PlaintextForm::MUL : PlaintextForm::NORMAL;
+}
+
+[[noreturn]] void unsupported(const ComputeNode& node, const std::string& what) {
+    throw std::runtime_error("Compute node " + node.id + ": " + what + " is not supported by the native CPU backend");
+}
+
+int output_level(const ComputeNode& node) {
+    if (node.output_nodes.empty() || !node.output_nodes[0]->fhe_prop.has_value()) {
+        throw std::runtime_error("FHE property not found for output node");
+    }
+    return node.output_nodes[0]->fhe_prop->level;
+}
+
+template <HEScheme SchemeType> void bind_native_add_sub(ComputeNode& node, bool subtract) {
+    const int level = output_level(node);
+    const Kernels* k = &kernels();
+    if (node.input_nodes.size() == 2 && node.input_nodes[1]->datum_type == DataType::TYPE_PLAINTEXT) {
+        if (SchemeType == HEScheme::BFV || plaintext_form(node.input_nodes[1]) != PlaintextForm::NORMAL) {
+            unsupported(node, "adding or subtracting this plaintext form");
+        }
+        // ct +/- pt: only the first polynomial changes
+        node.executor = [level, k, subtract](ExecutionContext& ctx,
+                                             const std::unordered_map<NodeIndex, std::any>& inputs, std::any& output,
+                                             const ComputeNode& self) -> void {
+            NativeRing& ring = ring_of<SchemeType>(ctx);
+            const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+            const CPlaintext& b = plaintext_input(inputs, self.input_nodes[1]);
+            check_level(a, level);
+            check_level(b, level);
+            auto out = new_ciphertext(a.degree, level, ring.n);
+            for (int i = 0; i <= level; i++) {
+                (subtract ? k->sub : k->add)(component(a, 0, i), component(b, i), component(*out, 0, i), ring.n,
+                                             ring.moduli[i]);
+                for (int p = 1; p <= a.degree; p++) {
+                    std::memcpy(component(*out, p, i), component(a, p, i), ring.n * sizeof(uint64_t));
+                }
+            }
+            output = out;
+        };
+        return;
+    }
+    // ct +/- ct, of any degrees: the polynomials beyond the smaller degree are copied (or negated) from the larger
+    node.executor = [level, k, subtract](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                                         std::any& output, const ComputeNode& self) -> void {
+        NativeRing& ring = ring_of<SchemeType>(ctx);
+        const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+        const CCiphertext& b = ciphertext_input(inputs, self.input_nodes[self.input_nodes.size() - 1]);
+        check_level(a, level);
+        check_level(b, level);
+        auto out = new_ciphertext(std::max(a.degree, b.degree), level, ring.n);
+        for (int p = 0; p <= out->degree; p++) {
+            for (int i = 0; i <= level; i++) {
+                const Modulus& m = ring.moduli[i];
+                if (p <= a.degree && p <= b.degree) {
+                    (subtract ? k->sub : k->add)(component(a, p, i), component(b, p, i), component(*out, p, i),
+                                                 ring.n, m);
+                } else if (p <= a.degree) {
+                    std::memcpy(component(*out, p, i), component(a, p, i), ring.n * sizeof(uint64_t));
+                } else if (subtract) {
+                    k->neg(component(b, p, i), component(*out, p, i), ring.n, m);
+                } else {
+                    std::memcpy(component(*out, p, i), component(b, p, i), ring.n * sizeof(uint64_t));
+                }
+            }
+        }
+        output = out;
+    };
+}
+
+template <HEScheme SchemeType> void bind_native_neg(ComputeNode& node) {
+    const int level = output_level(node);
+    const Kernels* k = &kernels();
+    node.executor = [level, k](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                               std::any& output, const ComputeNode& self) -> void {
+        NativeRing& ring = ring_of<SchemeType>(ctx);
+        const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+        check_level(a, level);
+        auto out = new_ciphertext(a.degree, level, ring.n);
+        for (int p = 0; p <= a.degree; p++) {
+            for (int i = 0; i <= level; i++) {
+                k->neg(component(a, p, i), component(*out, p, i), ring.n, ring.moduli[i]);
+            }
+        }
+        output = out;
+    };
+}
+
+void bind_native_ckks_mult(ComputeNode& node) {
+    const int level = output_level(node);
+    const Kernels* k = &kernels();
+    if (node.input_nodes.size() == 2 && node.input_nodes[1]->datum_type == DataType::TYPE_PLAINTEXT) {
+        PlaintextForm form = plaintext_form(node.input_nodes[1]);
+        if (form == PlaintextForm::RINGT) {
+            unsupported(node, "multiplying by a plaintext in ring t");
+        }
+        // ct * pt_mul is a Montgomery product, ct * pt a plain one
+        const bool montgomery = form == PlaintextForm::MUL;
+        node.executor = [level, k, montgomery](ExecutionContext& ctx,
+                                               const std::unordered_map<NodeIndex, std::any>& inputs,
+                                               std::any& output, const ComputeNode& self) -> void {
+            NativeRing& ring = ring_of<HEScheme::CKKS>(ctx);
+            const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+            const CPlaintext& b = plaintext_input(inputs, self.input_nodes[1]);
+            check_level(a, level);
+            check_level(b, level);
+            auto out = new_ciphertext(a.degree, level, ring.n);
+            for (int p = 0; p <= a.degree; p++) {
+                for (int i = 0; i <= level; i++) {
+                    (montgomery ? k->mul_mont : k->mul)(component(a, p, i), component(b, i), component(*out, p, i),
+                                                        ring.n, ring.moduli[i]);
+                }
+            }
+            output = out;
+        };
+        return;
+    }
+    // ct * ct (or ct * ct of a single input): tensor product of degree 2, before relinearization
+    node.executor = [level, k](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                               std::any& output, const ComputeNode& self) -> void {
+        NativeRing& ring = ring_of<HEScheme::CKKS>(ctx);
+        const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+        const CCiphertext& b = ciphertext_input(inputs, self.input_nodes[self.input_nodes.size() - 1]);
+        if (a.degree != 1 || b.degree != 1) {
+            throw std::runtime_error("Native CPU multiplication requires ciphertexts of degree 1");
+        }
+        check_level(a, level);
+        check_level(b, level);
+        auto out = new_ciphertext(2, level, ring.n);
+        for (int i = 0; i <= level; i++) {
+            const Modulus& m = ring.moduli[i];
+            k->mul(component(a, 0, i), component(b, 0, i), component(*out, 0, i), ring.n, m);
+            k->mul(component(a, 0, i), component(b, 1, i), component(*out, 1, i), ring.n, m);
+            k->mul_add(component(a, 1, i), component(b, 0, i), component(*out, 1, i), ring.n, m);
+            k->mul(component(a, 1, i), component(b, 1, i), component(*out, 2, i), ring.n, m);
+        }
+        output = out;
+    };
+}
+
+// Sum of products of ciphertexts and plaintexts, plus a partial sum if `partial`. Inputs: the sum_cnt ciphertexts,
+// the partial sum, then the sum_cnt plaintexts.
+void bind_native_ckks_mac(ComputeNode& node, bool partial) {
+    if (!node.fhe_prop->p.has_value()) {
+        throw std::runtime_error("MAC requires sum_cnt property");
+    }
+    const int n_terms = node.fhe_prop->p->sum_cnt;
+    const int pt_offset = partial ? n_terms + 1 : n_terms;
+    if (n_terms < 1 || static_cast<int>(node.input_nodes.size()) != pt_offset + n_terms) {
+        throw std::runtime_error("MAC inputs do not match its sum_cnt property");
+    }
+    PlaintextForm form = plaintext_form(node.input_nodes[pt_offset]);
+    if (form == PlaintextForm::RINGT) {
+        unsupported(node, "multiplying by a plaintext in ring t");
+    }
+    const bool montgomery = form == PlaintextForm::MUL;
+    const int level = output_level(node);
+    const Kernels* k = &kernels();
+    node.executor = [level, k, montgomery, n_terms, pt_offset, partial](
+                        ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                        std::any& output, const ComputeNode& self) -> void {
+        NativeRing& ring = ring_of<HEScheme::CKKS>(ctx);
+        auto out = new_ciphertext(1, level, ring.n);
+        for (int t = 0; t < n_terms; t++) {
+            const CCiphertext& c = ciphertext_input(inputs, self.input_nodes[t]);
+            const CPlaintext& pt = plaintext_input(inputs, self.input_nodes[pt_offset + t]);
+            if (c.degree != 1) {
+                throw std::runtime_error("Native CPU MAC requires ciphertexts of degree 1");
+            }
+            check_level(c, level);
+            check_level(pt, level);
+            auto product = t == 0 ? (montgomery ? k->mul_mont : k->mul) : (montgomery ? k->mul_mont_add : k->mul_add);
+            for (int p = 0; p <= 1; p++) {
+                for (int i = 0; i <= level; i++) {
+                    product(component(c, p, i), component(pt, i), component(*out, p, i), ring.n, ring.moduli[i]);
+                }
+            }
+        }
+        if (partial) {
+            const CCiphertext& s = ciphertext_input(inputs, self.input_nodes[n_terms]);
+            if (s.degree != 1) {
+                throw std::runtime_error("Native CPU MAC requires ciphertexts of degree 1");
+            }
+            check_level(s, level);
+            for (int p = 0; p <= 1; p++) {
+                for (int i = 0; i <= level; i++) {
+                    k->add(component(*out, p, i), component(s, p, i), component(*out, p, i), ring.n, ring.moduli[i]);
+                }
+            }
+        }
+        output = out;
+    };
+}
+
+// Divide by the last modulus q_l of `ct` with rounding: with t the residue of the last component, centered by
+// h = (q_l - 1) / 2, component i becomes (c_i - t) * q_l^-1 mod q_i
+std::shared_ptr<CCiphertext> rescale_once(NativeRing& ring, const Kernels& k, const CCiphertext& ct) {
+    const int l = ct.level;
+    const size_t n = ring.n;
+    const Modulus& last = ring.moduli[l];
+    const uint64_t half = (last.q - 1) >> 1;
+    std::vector<uint64_t> q_l_inv(l);
+    for (int i = 0; i < l; i++) {
+        const Modulus& m = ring.moduli[i];
+        q_l_inv[i] = pow_mod(reduce(last.q, m), m.q - 2, m.q);
+    }
+    auto out = new_ciphertext(ct.degree, l - 1, n);
+    std::vector<uint64_t> residue(n);
+    std::vector<uint64_t> t(n);
+    for (int p = 0; p <= ct.degree; p++) {
+        std::memcpy(residue.data(), component(ct, p, l), n * sizeof(uint64_t));
+        ckks_ntt_tables(ring, l).inverse(residue.data());
+        for (size_t j = 0; j < n; j++) {
+            uint64_t s = residue[j] + half;
+            residue[j] = s >= last.q ? s - last.q : s;
+        }
+        for (int i = 0; i < l; i++) {
+            const Modulus& m = ring.moduli[i];
+            const uint64_t half_i = m.q - reduce(half, m);
+            for (size_t j = 0; j < n; j++) {
+                uint64_t s = reduce(residue[j], m) + half_i;
+                t[j] = s >= m.q ? s - m.q : s;
+            }
+            ckks_ntt_tables(ring, i).forward(t.data());
+            k.sub(component(ct, p, i), t.data(), component(*out, p, i), n, m);
+            mul_scalar(component(*out, p, i), q_l_inv[i], shoup_quotient(q_l_inv[i], m), component(*out, p, i), n, m);
+        }
+    }
+    return out;
+}
+
+void bind_native_ckks_rescale(ComputeNode& node) {
+    const int level = output_level(node);
+    const Kernels* k = &kernels();
+    node.executor = [level, k](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs,
+                               std::any& output, const ComputeNode& self) -> void {
+        NativeRing& ring = ring_of<HEScheme::CKKS>(ctx);
+        const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+        if (a.level <= level) {
+            throw std::runtime_error("Rescale needs a ciphertext above level " + std::to_string(level));
+        }
+        auto out = rescale_once(ring, *k, a);
+        while (out->level > level) {
+            out = rescale_once(ring, *k, *out);
+        }
+        output = out;
+    };
+}
+
+// Drop the components above the output level. The result is a view of the input components, which it keeps alive.
+void bind_native_ckks_drop_level(ComputeNode& node) {
+    const int level = output_level(node);
+    node.executor = [level](ExecutionContext& /*ctx*/, const std::unordered_map<NodeIndex, std::any>& inputs,
+                            std::any& output, const ComputeNode& self) -> void {
+        const CCiphertext& a = ciphertext_input(inputs, self.input_nodes[0]);
+        check_level(a, level);
+        std::shared_ptr<CCiphertext> source = std::any_cast<std::shared_ptr<CCiphertext>>(
+            inputs.at(self.input_nodes[0]->index));
+        CCiphertext* view = (CCiphertext*)malloc(sizeof(CCiphertext));
+        view->degree = a.degree;
+        view->level = level;
+        view->polys = (CPolynomial*)malloc((a.degree + 1) * sizeof(CPolynomial));
+        for (int p = 0; p <= a.degree; p++) {
+            view->polys[p].n_component = level + 1;
+            view->polys[p].components = (CComponent*)malloc((level + 1) * sizeof(CComponent));
+            std::memcpy(view->polys[p].components, a.polys[p].components, (level + 1) * sizeof(CComponent));
+        }
+        output = std::shared_ptr<CCiphertext>(view, [source](CCiphertext* p) {
+            for (int i = 0; i <= p->degree; i++) {
+                free(p->polys[i].components);
+            }
+            free(p->polys);
+            free(p);
+        });
+    };
+}
+
+}  // namespace
+
+// Wrapper function for ExecutorBinder (callable from mega_ag.cpp)
+void bind_cpu_native_executor(ComputeNode& node, Algo algorithm) {
+    if (!node.fhe_prop.has_value()) {
+        throw std::runtime_error("FHE property not found for compute node");
+    }
+
+    switch (algorithm) {
+        case ALGO_BFV:
+            switch (node.fhe_prop->op_type) {
+                case OperationType::ADD: bind_native_add_sub<HEScheme::BFV>(node, false); break;
+                case OperationType::SUB: bind_native_add_sub<HEScheme::BFV>(node, true); break;
+                case OperationType::NEGATE: bind_native_neg<HEScheme::BFV>(node); break;
+                default: unsupported(node, "this BFV operation");
+            }
+            break;
+        case ALGO_CKKS:
+            switch (node.fhe_prop->op_type) {
+                case OperationType::ADD: bind_native_add_sub<HEScheme::CKKS>(node, false); break;
+                case OperationType::SUB: bind_native_add_sub<HEScheme::CKKS>(node, true); break;
+                case OperationType::NEGATE: bind_native_neg<HEScheme::CKKS>(node); break;
+                case OperationType::MULTIPLY: bind_native_ckks_mult(node); break;
+                case OperationType::RESCALE: bind_native_ckks_rescale(node); break;
+                case OperationType::DROP_LEVEL: bind_native_ckks_drop_level(node); break;
+                case OperationType::MAC_W_PARTIAL_SUM: bind_native_ckks_mac(node, true); break;
+                case OperationType::MAC_WO_PARTIAL_SUM: bind_native_ckks_mac(node, false); break;
+                default: unsupported(node, "this CKKS operation");
+            }
+            break;
+        default: throw std::runtime_error("Unknown algorithm type for native CPU");
+    }
+}
@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file native_kernels.cpp
+ * @brief Scalar, AVX2, AVX-512 and AVX-512 IFMA modular arithmetic kernels, and the scalar NTT
+ *
+ * The vector kernels are compiled with function-level target attributes, so the library keeps its baseline flags and
+ * picks the instruction set at run time. Modular products are vectorized with the 52-bit multipliers of AVX-512 IFMA
+ * for moduli below 2^50; other products use 128-bit scalar Montgomery multiplication.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "native_kernels.h"
+
+namespace cpu_native {
+
+namespace {
+
+using u128 = unsigned __int128;
+
+inline uint64_t mulhi(uint64_t a, uint64_t b) {
+    return static_cast<uint64_t>((static_cast<u128>(a) * b) >> 64);
+}
+
+// a * b * 2^-64 mod q in [0, q), for a * b < q * 2^64
+inline uint64_t mont_mul(uint64_t a, uint64_t b, const Modulus& m) {
+    u128 t = static_cast<u128>(a) * b;
+    uint64_t hi = static_cast<uint64_t>(t >> 64);
+    uint64_t mq = mulhi(static_cast<uint64_t>(t) * m.q_inv, m.q);
+    return hi >= mq ? hi - mq : hi - mq + m.q;
+}
+
+inline uint64_t plain_mul(uint64_t a, uint64_t b, const Modulus& m) {
+    return mont_mul(mont_mul(a, b, m), m.r2, m);
+}
+
+inline uint64_t add_mod(uint64_t a, uint64_t b, uint64_t q) {
+    uint64_t s = a + b;
+    return s >= q ? s - q : s;
+}
+
+// w * x mod q in [0, 2q), for any x < 2^64
+inline uint64_t mul_shoup_lazy(uint64_t x, uint64_t w, uint64_t w_shoup, uint64_t q) {
+    return w * x - mulhi(x, w_shoup) * q;
+}
+
+size_t bit_reverse(size_t x, int n_bits) {
+    size_t r = 0;
+    for (int i = 0; i < n_bits; i++) {
+        r = (r << 1) | ((x >> i) & 1);
+    }
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Scalar kernels
+// ---------------------------------------------------------------------------
+
+void add_scalar(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = add_mod(a[i], b[i], m.q);
+    }
+}
+
+void sub_scalar(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = add_mod(a[i], m.q - b[i], m.q);
+    }
+}
+
+void neg_scalar(const uint64_t* a, uint64_t* out, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = m.q - a[i];
+    }
+}
+
+void mul_mont_scalar(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = mont_mul(a[i], b[i], m);
+    }
+}
+
+void mul_scalar_kernel(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = plain_mul(a[i], b[i], m);
+    }
+}
+
+void mul_mont_add_scalar(const uint64_t* a, const uint64_t* b, uint64_t* acc, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        acc[i] = add_mod(acc[i], mont_mul(a[i], b[i], m), m.q);
+    }
+}
+
+void mul_add_scalar(const uint64_t* a, const uint64_t* b, uint64_t* acc, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        acc[i] = add_mod(acc[i], plain_mul(a[i], b[i], m), m.q);
+    }
+}
+
+#if defined(__x86_64__)
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels: values stay below 2^63, so the signed 64-bit comparison orders them
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2"))) inline __m256i reduce_once_avx2(__m256i s, __m256i q) {
+    __m256i below = _mm256_cmpgt_epi64(q, s);
+    return _mm256_blendv_epi8(_mm256_sub_epi64(s, q), s, below);
+}
+
+__attribute__((target("avx2"))) void
+add_avx2(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    const __m256i q = _mm256_set1_epi64x(static_cast<long long>(m.q));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), reduce_once_avx2(_mm256_add_epi64(x, y), q));
+    }
+    add_scalar(a + i, b + i, out + i, n - i, m);
+}
+
+__attribute__((target("avx2"))) void
+sub_avx2(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    const __m256i q = _mm256_set1_epi64x(static_cast<long long>(m.q));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i t = _mm256_sub_epi64(_mm256_add_epi64(x, q), y);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), reduce_once_avx2(t, q));
+    }
+    sub_scalar(a + i, b + i, out + i, n - i, m);
+}
+
+__attribute__((target("avx2"))) void neg_avx2(const uint64_t* a, uint64_t* out, size_t n, const Modulus& m) {
+    const __m256i q = _mm256_set1_epi64x(static_cast<long long>(m.q));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_sub_epi64(q, x));
+    }
+    neg_scalar(a + i, out + i, n - i, m);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 kernels: min(s, s - q) reduces s in [0, 2q) to [0, q), as s - q wraps around when s < q
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f"))) inline __m512i reduce_once_avx512(__m512i s, __m512i q) {
+    return _mm512_min_epu64(s, _mm512_sub_epi64(s, q));
+}
+
+__attribute__((target("avx512f"))) void
+add_avx512(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    const __m512i q = _mm512_set1_epi64(static_cast<long long>(m.q));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(out + i, reduce_once_avx512(_mm512_add_epi64(x, y), q));
+    }
+    add_scalar(a + i, b + i, out + i, n - i, m);
+}
+
+__attribute__((target("avx512f"))) void
+sub_avx512(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    const __m512i q = _mm512_set1_epi64(static_cast<long long>(m.q));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(out + i, reduce_once_avx512(_mm512_sub_epi64(_mm512_add_epi64(x, q), y), q));
+    }
+    sub_scalar(a + i, b + i, out + i, n - i, m);
+}
+
+__attribute__((target("avx512f"))) void neg_avx512(const uint64_t* a, uint64_t* out, size_t n, const Modulus& m) {
+    const __m512i q = _mm512_set1_epi64(static_cast<long long>(m.q));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_si512(out + i, _mm512_sub_epi64(q, _mm512_loadu_si512(a + i)));
+    }
+    neg_scalar(a + i, out + i, n - i, m);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 IFMA products, for q < 2^50. mont52(a, b) = a * b * 2^-52 mod q: with m = lo(a * b) * (-q^-1) mod 2^52,
+// a * b + m * q is a multiple of 2^52 below 2q * 2^52, and the low halves of both products sum to 0 or exactly 2^52.
+// A second mont52 by 2^40 or 2^104 mod q gives the 2^-64 Montgomery product or the plain one.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f,avx512ifma"))) inline __m512i
+mont52(__m512i a, __m512i b, __m512i q, __m512i q_inv52) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i lo = _mm512_madd52lo_epu64(zero, a, b);
+    __m512i hi = _mm512_madd52hi_epu64(zero, a, b);
+    __m512i k = _mm512_madd52lo_epu64(zero, lo, q_inv52);
+    hi = _mm512_madd52hi_epu64(hi, k, q);
+    hi = _mm512_mask_add_epi64(hi, _mm512_test_epi64_mask(lo, lo), hi, _mm512_set1_epi64(1));
+    return reduce_once_avx512(hi, q);
+}
+
+template <bool Montgomery, bool Accumulate>
+__attribute__((target("avx512f,avx512ifma"))) void
+mul_ifma(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m) {
+    size_t i = 0;
+    if (m.ifma_ok) {
+        const __m512i q = _mm512_set1_epi64(static_cast<long long>(m.q));
+        const __m512i q_inv52 = _mm512_set1_epi64(static_cast<long long>(m.q_inv52));
+        const __m512i c = _mm512_set1_epi64(static_cast<long long>(Montgomery ? m.c40 : m.c104));
+        for (; i + 8 <= n; i += 8) {
+            __m512i x = _mm512_loadu_si512(a + i);
+            __m512i y = _mm512_loadu_si512(b + i);
+            __m512i p = mont52(mont52(x, y, q, q_inv52), c, q, q_inv52);
+            if constexpr (Accumulate) {
+                p = reduce_once_avx512(_mm512_add_epi64(_mm512_loadu_si512(out + i), p), q);
+            }
+            _mm512_storeu_si512(out + i, p);
+        }
+    }
+    if constexpr (Montgomery) {
+        (Accumulate ? mul_mont_add_scalar : mul_mont_scalar)(a + i, b + i, out + i, n - i, m);
+    } else {
+        (Accumulate ? mul_add_scalar : mul_scalar_kernel)(a + i, b + i, out + i, n - i, m);
+    }
+}
+
+#endif  // __x86_64__
+
+const Kernels scalar_kernels = {Isa::SCALAR,      add_scalar,          sub_scalar,    neg_scalar, mul_mont_scalar,
+                                mul_scalar_kernel, mul_mont_add_scalar, mul_add_scalar};
+
+#if defined(__x86_64__)
+const Kernels avx2_kernels = {Isa::AVX2,        add_avx2,            sub_avx2,      neg_avx2, mul_mont_scalar,
+                              mul_scalar_kernel, mul_mont_add_scalar, mul_add_scalar};
+
+const Kernels avx512_kernels = {Isa::AVX512,      add_avx512,          sub_avx512,    neg_avx512, mul_mont_scalar,
+                                mul_scalar_kernel, mul_mont_add_scalar, mul_add_scalar};
+
+const Kernels avx512_ifma_kernels = {Isa::AVX512_IFMA,
+                                     add_avx512,
+                                     sub_avx512,
+                                     neg_avx512,
+                                     mul_ifma<true, false>,
+                                     mul_ifma<false, false>,
+                                     mul_ifma<true, true>,
+                                     mul_ifma<false, true>};
+#endif
+
+}  // namespace
+
+Modulus::Modulus(uint64_t modulus) : q(modulus) {
+    if (q % 2 == 0 || q >= (uint64_t(1) << 62)) {
+        throw std::invalid_argument("Modulus " + std::to_string(q) + " is not an odd number below 2^62");
+    }
+    q_inv = q;
+    for (int i = 0; i < 5; i++) {
+        q_inv *= 2 - q * q_inv;
+    }
+    barrett = static_cast<uint64_t>((static_cast<u128>(1) << 64) / q);
+    uint64_t r = static_cast<uint64_t>((static_cast<u128>(1) << 64) % q);
+    r2 = mul_mod(r, r, q);
+    q_inv52 = (0 - q_inv) & ((uint64_t(1) << 52) - 1);
+    c40 = (uint64_t(1) << 40) % q;
+    c104 = static_cast<uint64_t>((static_cast<u128>(1) << 104) % q);
+    ifma_ok = q < (uint64_t(1) << 50);
+}
+
+Isa detect_isa() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return __builtin_cpu_supports("avx512ifma") ? Isa::AVX512_IFMA : Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::AVX2;
+    }
+#endif
+    return Isa::SCALAR;
+}
+
+const Kernels& kernels_for(Isa isa) {
+    if (static_cast<int>(isa) > static_cast<int>(detect_isa())) {
+        throw std::invalid_argument(std::string("Instruction set ") + isa_name(isa) + " is not supported by this CPU");
+    }
+    switch (isa) {
+#if defined(__x86_64__)
+        case Isa::AVX2: return avx2_kernels;
+        case Isa::AVX512: return avx512_kernels;
+        case Isa::AVX512_IFMA: return avx512_ifma_kernels;
+#endif
+        default: return scalar_kernels;
+    }
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = kernels_for(detect_isa());
+    return best;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "avx2";
+        case Isa::AVX512: return "avx512";
+        case Isa::AVX512_IFMA: return "avx512_ifma";
+        default: return "scalar";
+    }
+}
+
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t q) {
+    return static_cast<uint64_t>(static_cast<u128>(a) * b % q);
+}
+
+uint64_t pow_mod(uint64_t a, uint64_t e, uint64_t q) {
+    uint64_t r = 1 % q;
+    a %= q;
+    for (; e > 0; e >>= 1) {
+        if (e & 1) {
+            r = mul_mod(r, a, q);
+        }
+        a = mul_mod(a, a, q);
+    }
+    return r;
+}
+
+uint64_t reduce(uint64_t x, const Modulus& m) {
+    uint64_t r = x - mulhi(x, m.barrett) * m.q;
+    return r >= m.q ? r - m.q : r;
+}
+
+uint64_t shoup_quotient(uint64_t w, const Modulus& m) {
+    return static_cast<uint64_t>((static_cast<u128>(w) << 64) / m.q);
+}
+
+void mul_scalar(const uint64_t* a, uint64_t w, uint64_t w_shoup, uint64_t* out, size_t n, const Modulus& m) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t r = mul_shoup_lazy(a[i], w, w_shoup, m.q);
+        out[i] = r >= m.q ? r - m.q : r;
+    }
+}
+
+NttTables::NttTables(const Modulus& modulus, size_t n, uint64_t psi)
+    : modulus_(modulus), n_(n), roots_(n), roots_shoup_(n), inv_roots_(n), inv_roots_shoup_(n) {
+    const uint64_t q = modulus_.q;
+    if (n < 2 || (n & (n - 1)) != 0) {
+        throw std::invalid_argument("NTT size " + std::to_string(n) + " is not a power of two");
+    }
+    if (psi >= q || pow_mod(psi, n, q) != q - 1) {
+        throw std::invalid_argument("Root " + std::to_string(psi) + " is not a primitive " + std::to_string(2 * n) +
+                                    "-th root of unity modulo " + std::to_string(q));
+    }
+    int log_n = 0;
+    while ((size_t(1) << log_n) < n) {
+        log_n++;
+    }
+    const uint64_t psi_inv = pow_mod(psi, 2 * n - 1, q);
+    uint64_t power = 1;
+    uint64_t inv_power = 1;
+    for (size_t j = 0; j < n; j++) {
+        size_t k = bit_reverse(j, log_n);
+        roots_[k] = power;
+        inv_roots_[k] = inv_power;
+        power = mul_mod(power, psi, q);
+        inv_power = mul_mod(inv_power, psi_inv, q);
+    }
+    for (size_t k = 0; k < n; k++) {
+        roots_shoup_[k] = shoup_quotient(roots_[k], modulus_);
+        inv_roots_shoup_[k] = shoup_quotient(inv_roots_[k], modulus_);
+    }
+    n_inv_ = pow_mod(n % q, q - 2, q);
+    n_inv_shoup_ = shoup_quotient(n_inv_, modulus_);
+}
+
+// Cooley-Tukey butterflies with lazy reduction (Harvey): values stay in [0, 4q)
+void NttTables::forward(uint64_t* a) const {
+    const uint64_t q = modulus_.q;
+    const uint64_t two_q = 2 * q;
+    size_t t = n_;
+    for (size_t m = 1; m < n_; m <<= 1) {
+        t >>= 1;
+        for (size_t i = 0; i < m; i++) {
+            const uint64_t w = roots_[m + i];
+            const uint64_t w_shoup = roots_shoup_[m + i];
+            uint64_t* x = a + 2 * i * t;
+            uint64_t* y = x + t;
+            for (size_t j = 0; j < t; j++) {
+                uint64_t u = x[j] >= two_q ? x[j] - two_q : x[j];
+                uint64_t v = mul_shoup_lazy(y[j], w, w_shoup, q);
+                x[j] = u + v;
+                y[j] = u + two_q - v;
+            }
+        }
+    }
+    for (size_t j = 0; j < n_; j++) {
+        uint64_t r = a[j] >= two_q ? a[j] - two_q : a[j];
+        a[j] = r >= q ? r - q : r;
+    }
+}
+
+// Gentleman-Sande butterflies with lazy reduction: values stay in [0, 2q)
+void NttTables::inverse(uint64_t* a) const {
+    const uint64_t q = modulus_.q;
+    const uint64_t two_q = 2 * q;
+    size_t t = 1;
+    for (size_t m = n_; m > 1; m >>= 1) {
+        const size_t h = m >> 1;
+        for (size_t i = 0; i < h; i++) {
+            const uint64_t w = inv_roots_[h + i];
+            const uint64_t w_shoup = inv_roots_shoup_[h + i];
+            uint64_t* x = a + 2 * i * t;
+            uint64_t* y = x + t;
+            for (size_t j = 0; j < t; j++) {
+                uint64_t u = x[j];
+                uint64_t v = y[j];
+                uint64_t s = u + v;
+                x[j] = s >= two_q ? s - two_q : s;
+                y[j] = mul_shoup_lazy(u + two_q - v, w, w_shoup, q);
+            }
+        }
+        t <<= 1;
+    }
+    mul_scalar(a, n_inv_, n_inv_shoup_, a, n_, modulus_);
+}
+
+}  // namespace cpu_native
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/** @file native_kernels.h
+ * @brief Modular arithmetic kernels on RNS components for the native CPU backend
+ *
+ * The kernels work on the coefficient arrays of ABI components (CComponent::data), one word-size prime modulus at a
+ * time. Every result is fully reduced into [0, q), except negation which, like Lattigo, maps x to q - x, so that the
+ * native backend produces the same words as the Lattigo path.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpu_native {
+
+/**
+ * @brief Word-size prime modulus with its precomputed reduction constants
+ */
+struct Modulus {
+    uint64_t q = 0;
+    uint64_t q_inv = 0;     // q^-1 mod 2^64
+    uint64_t barrett = 0;   // floor(2^64 / q)
+    uint64_t r2 = 0;        // 2^128 mod q, takes a Montgomery product back to a plain one
+    uint64_t q_inv52 = 0;   // -q^-1 mod 2^52, for the 52-bit Montgomery products of IFMA
+    uint64_t c40 = 0;       // 2^40 mod q, turns a 2^-52 Montgomery product into a 2^-64 one
+    uint64_t c104 = 0;      // 2^104 mod q, turns a 2^-52 Montgomery product into a plain one
+    bool ifma_ok = false;   // Whether q is small enough (< 2^50) for the IFMA kernels
+
+    Modulus() = default;
+
+    // @throws std::invalid_argument if q is even or not below 2^62
+    explicit Modulus(uint64_t q);
+};
+
+// Instruction sets the kernels are built for, from slowest to fastest
+enum class Isa { SCALAR, AVX2, AVX512, AVX512_IFMA };
+
+/**
+ * @brief Kernels over n coefficients modulo one modulus. Inputs are in [0, q]; outputs may alias inputs.
+ */
+struct Kernels {
+    Isa isa;
+
+    // out = a + b mod q
+    void (*add)(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m);
+    // out = a - b mod q
+    void (*sub)(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m);
+    // out = q - a
+    void (*neg)(const uint64_t* a, uint64_t* out, size_t n, const Modulus& m);
+    // out = a * b * 2^-64 mod q, the product with an operand in Montgomery form
+    void (*mul_mont)(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m);
+    // out = a * b mod q
+    void (*mul)(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n, const Modulus& m);
+    // acc = acc + a * b * 2^-64 mod q
+    void (*mul_mont_add)(const uint64_t* a, const uint64_t* b, uint64_t* acc, size_t n, const Modulus& m);
+    // acc = acc + a * b mod q
+    void (*mul_add)(const uint64_t* a, const uint64_t* b, uint64_t* acc, size_t n, const Modulus& m);
+};
+
+// Best instruction set supported by this CPU and operating system
+Isa detect_isa();
+
+// Kernels for `isa`, which must be supported by this CPU
+const Kernels& kernels_for(Isa isa);
+
+// Kernels for the best instruction set of this CPU, detected on the first call
+const Kernels& kernels();
+
+const char* isa_name(Isa isa);
+
+// a * b mod q, for a, b < 2^64
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t q);
+
+// a^e mod q
+uint64_t pow_mod(uint64_t a, uint64_t e, uint64_t q);
+
+// x mod q, for any x < 2^64
+uint64_t reduce(uint64_t x, const Modulus& m);
+
+// floor(w * 2^64 / q), the Shoup quotient of a constant w < q
+uint64_t shoup_quotient(uint64_t w, const Modulus& m);
+
+// out = a * w mod q for a constant w < q and its Shoup quotient
+void mul_scalar(const uint64_t* a, uint64_t w, uint64_t w_shoup, uint64_t* out, size_t n, const Modulus& m);
+
+/**
+ * @brief Negacyclic number-theoretic transform modulo one prime, with values in bit-reversed order: the forward
+ * transform of a(X) holds a(psi^(2 * brv(j) + 1)) at position j, psi being a primitive 2n-th root of unity. This is
+ * the ordering of Lattigo, so given the same psi both produce the same words.
+ */
+class NttTables {
+public:
+    // @throws std::invalid_argument if n is not a power of two or psi is not a primitive 2n-th root of unity mod q
+    NttTables(const Modulus& modulus, size_t n, uint64_t psi);
+
+    // In place; input in [0, q], output in [0, q)
+    void forward(uint64_t* a) const;
+
+    // In place; input in [0, q], output in [0, q)
+    void inverse(uint64_t* a) const;
+
+    const Modulus& modulus() const {
+        return modulus_;
+    }
+
+    size_t n() const {
+        return n_;
+    }
+
+private:
+    Modulus modulus_;
+    size_t n_;
+    std::vector<uint64_t> roots_;  // psi^brv(k), and their Shoup quotients floor(w * 2^64 / q)
+    std::vector<uint64_t> roots_shoup_;
+    std::vector<uint64_t> inv_roots_;  // psi^-brv(k)
+    std::vector<uint64_t> inv_roots_shoup_;
+    uint64_t n_inv_;
+    uint64_t n_inv_shoup_;
+};
+
+}  // namespace cpu_native
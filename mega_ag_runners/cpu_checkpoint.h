@@ -0,0 +1,369 @@
+// Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "nlohmann/json.hpp"
+#include "mega_ag.h"
+#include "cpu_task_utils.h"
+
+// 64-bit FNV-1a hash, continued from `hash`.
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Hash of the structure of a graph: the ids and edges of its nodes, and the type and level of its data.
+inline uint64_t graph_fingerprint(const MegaAG& mega_ag) {
+    uint64_t hash = fnv1a(nullptr, 0);
+    auto add = [&hash](const auto& value) { hash = fnv1a(&value, sizeof(value), hash); };
+    std::vector<NodeIndex> indices;
+    for (const auto& [index, datum] : mega_ag.data) {
+        indices.push_back(index);
+    }
+    std::sort(indices.begin(), indices.end());
+    for (NodeIndex index : indices) {
+        const DatumNode& datum = mega_ag.data.at(index);
+        add(index);
+        hash = fnv1a(datum.id.data(), datum.id.size(), hash);
+        add(datum.datum_type);
+        add(datum.fhe_prop ? datum.fhe_prop->level : -1);
+        add(datum.fhe_prop ? datum.fhe_prop->degree : -1);
+    }
+    indices.clear();
+    for (const auto& [index, node] : mega_ag.computes) {
+        indices.push_back(index);
+    }
+    std::sort(indices.begin(), indices.end());
+    for (NodeIndex index : indices) {
+        const ComputeNode& node = mega_ag.computes.at(index);
+        add(index);
+        hash = fnv1a(node.id.data(), node.id.size(), hash);
+        for (const DatumNode* input : node.input_nodes) {
+            add(input->index);
+        }
+        add(uint64_t(-1));
+        for (const DatumNode* output : node.output_nodes) {
+            add(output->index);
+        }
+    }
+    return hash;
+}
+
+// ---------------------------------------------------------------------------
+// CheckpointDir: checkpoint of a task run in a directory. A checkpoint is a
+// manifest, listing the completed compute nodes and the data they left, and
+// one file per datum. Data files are written once and kept while the datum is
+// listed, so a new checkpoint writes only the data that became live since the
+// last one. The manifest is replaced atomically after the data files are
+// synced, so a run killed at any point leaves the previous checkpoint intact.
+//
+// The manifest holds a fingerprint of the graph and inputs; a checkpoint with
+// another fingerprint is ignored.
+// ---------------------------------------------------------------------------
+class CheckpointDir {
+public:
+    struct State {
+        std::unordered_set<NodeIndex> completed;
+        std::vector<NodeIndex> data;
+    };
+
+    // @throws std::runtime_error if the directory does not exist and cannot be created
+    CheckpointDir(const std::string& dir, uint64_t fingerprint) : dir_(dir), fingerprint_(fingerprint) {
+        if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error("Failed to create checkpoint directory " + dir_);
+        }
+    }
+
+    // The last checkpoint, if there is one for this fingerprint; a checkpoint of another run is removed
+    std::optional<State> load() {
+        std::ifstream file(manifest_path());
+        if (!file) {
+            return std::nullopt;
+        }
+        nlohmann::json manifest = nlohmann::json::parse(file, nullptr, false);
+        if (manifest.is_discarded()) {
+            return std::nullopt;
+        }
+        if (manifest.value("fingerprint", std::string()) != hex(fingerprint_)) {
+            for (NodeIndex index : manifest.value("data", std::vector<NodeIndex>())) {
+                unlink(datum_path(index).c_str());
+            }
+            unlink(manifest_path().c_str());
+            return std::nullopt;
+        }
+        State state;
+        for (NodeIndex index : manifest["completed"].get<std::vector<NodeIndex>>()) {
+            state.completed.insert(index);
+        }
+        state.data = manifest["data"].get<std::vector<NodeIndex>>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        saved_ = std::unordered_set<NodeIndex>(state.data.begin(), state.data.end());
+        return state;
+    }
+
+    // @throws std::runtime_error if the data file cannot be read
+    std::vector<uint8_t> read_datum(NodeIndex index) const {
+        std::ifstream file(datum_path(index), std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to read checkpoint datum " + datum_path(index));
+        }
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Whether the last checkpoint holds the datum; can be called concurrently with commit()
+    bool has_datum(NodeIndex index) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return saved_.count(index) != 0;
+    }
+
+    // Write the data not held yet, then a manifest listing `completed` and `data`, and remove the files of the data
+    // no longer listed. Returns the bytes written.
+    // @throws std::runtime_error if a file cannot be written; the previous checkpoint is then kept
+    uint64_t commit(const std::vector<NodeIndex>& completed,
+                    const std::vector<NodeIndex>& data,
+                    const std::unordered_map<NodeIndex, std::vector<uint8_t>>& new_data) {
+        uint64_t bytes = 0;
+        for (const auto& [index, value] : new_data) {
+            write_file(datum_path(index), value.data(), value.size());
+            bytes += value.size();
+        }
+        nlohmann::json manifest = {{"fingerprint", hex(fingerprint_)}, {"completed", completed}, {"data", data}};
+        std::string text = manifest.dump();
+        write_file(manifest_path() + ".tmp", text.data(), text.size());
+        if (rename((manifest_path() + ".tmp").c_str(), manifest_path().c_str()) != 0) {
+            throw std::runtime_error("Failed to replace checkpoint manifest in " + dir_);
+        }
+        sync_dir();
+        bytes += text.size();
+
+        std::unordered_set<NodeIndex> listed(data.begin(), data.end());
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (NodeIndex index : saved_) {
+            if (!listed.count(index)) {
+                unlink(datum_path(index).c_str());
+            }
+        }
+        saved_ = std::move(listed);
+        return bytes;
+    }
+
+    // Remove the checkpoint, e.g. once the run it belongs to has finished
+    void remove() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unlink(manifest_path().c_str());
+        for (NodeIndex index : saved_) {
+            unlink(datum_path(index).c_str());
+        }
+        saved_.clear();
+    }
+
+private:
+    static std::string hex(uint64_t value) {
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+        return text;
+    }
+
+    std::string manifest_path() const {
+        return dir_ + "/manifest.json";
+    }
+
+    std::string datum_path(NodeIndex index) const {
+        return dir_ + "/datum_" + std::to_string(index) + ".bin";
+    }
+
+    static void write_file(const std::string& path, const void* data, size_t size) {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to create checkpoint file " + path);
+        }
+        const char* begin = static_cast<const char*>(data);
+        size_t written = 0;
+        while (written < size) {
+            ssize_t n = ::write(fd, begin + written, size - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                close(fd);
+                throw std::runtime_error("Failed to write checkpoint file " + path);
+            }
+            written += n;
+        }
+        bool synced = fsync(fd) == 0;
+        close(fd);
+        if (!synced) {
+            throw std::runtime_error("Failed to sync checkpoint file " + path);
+        }
+    }
+
+    // Make the rename of the manifest durable: it is recorded in the directory, not in the file
+    void sync_dir() const {
+        int fd = open(dir_.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open checkpoint directory " + dir_);
+        }
+        bool synced = fsync(fd) == 0;
+        close(fd);
+        if (!synced) {
+            throw std::runtime_error("Failed to sync checkpoint directory " + dir_);
+        }
+    }
+
+    std::string dir_;
+    uint64_t fingerprint_;
+    mutable std::mutex mutex_;
+    std::unordered_set<NodeIndex> saved_;  // Data held by the last checkpoint
+};
+
+// ---------------------------------------------------------------------------
+// CheckpointWriter: writes the snapshots of a run (see RunSnapshot) to a
+// CheckpointDir on a thread of its own, so that the run goes on meanwhile.
+// If snapshots come faster than they are written, only the latest pending one
+// is kept. A snapshot holding a datum that cannot be serialized is dropped;
+// the next one is tried again.
+// ---------------------------------------------------------------------------
+class CheckpointWriter {
+public:
+    // Serialized value of a datum, nullopt if it cannot be serialized
+    using Serializer = std::function<std::optional<std::vector<uint8_t>>(NodeIndex, const std::any&)>;
+
+    // @param completed_before Compute nodes completed by the runs that the checkpoint resumed, listed in every
+    //                         snapshot besides those completed by this run
+    CheckpointWriter(CheckpointDir& dir, Serializer serializer, std::vector<NodeIndex> completed_before)
+        : dir_(dir), serializer_(std::move(serializer)), completed_before_(std::move(completed_before)),
+          thread_([this]() { write_loop(); }) {}
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void submit(RunSnapshot&& snapshot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ = std::move(snapshot);
+        }
+        cv_.notify_all();
+    }
+
+    // Wait until the submitted snapshots are written or dropped
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !pending_ && !writing_; });
+    }
+
+    uint64_t checkpoints_written() const {
+        return checkpoints_written_.load();
+    }
+
+    uint64_t bytes_written() const {
+        return bytes_written_.load();
+    }
+
+private:
+    void write_loop() {
+        while (true) {
+            RunSnapshot snapshot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || pending_; });
+                if (!pending_) {
+                    return;
+                }
+                snapshot = std::move(*pending_);
+                pending_.reset();
+                writing_ = true;
+            }
+            try {
+                write(snapshot);
+            } catch (...) {
+                // Keep the previous checkpoint; the next snapshot is tried again
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                writing_ = false;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    void write(RunSnapshot& snapshot) {
+        std::vector<NodeIndex> data;
+        std::unordered_map<NodeIndex, std::vector<uint8_t>> new_data;
+        for (auto& [index, value] : snapshot.data) {
+            data.push_back(index);
+            if (!value.has_value() || dir_.has_datum(index)) {
+                continue;
+            }
+            std::optional<std::vector<uint8_t>> bytes = serializer_(index, value);
+            if (!bytes) {
+                return;
+            }
+            new_data[index] = std::move(*bytes);
+            value.reset();
+        }
+        std::vector<NodeIndex> completed = completed_before_;
+        completed.insert(completed.end(), snapshot.completed.begin(), snapshot.completed.end());
+        bytes_written_.fetch_add(dir_.commit(completed, data, new_data));
+        checkpoints_written_.fetch_add(1);
+    }
+
+    CheckpointDir& dir_;
+    Serializer serializer_;
+    const std::vector<NodeIndex> completed_before_;
+    std::atomic<uint64_t> checkpoints_written_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::optional<RunSnapshot> pending_;
+    bool writing_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,512 @@
+// Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "mega_ag.h"
+#include "cpu_task_utils.h"
+#include "cpu_transport.h"
+
+/**
+ * @brief Assignment of the compute nodes of a graph to the ranks of a distributed run (see partition_mega_ag()).
+ */
+struct GraphPartition {
+    uint32_t n_ranks = 1;
+    // Rank of each compute node. EXPORT_TO_ABI nodes are left out: they only alias task inputs, which every rank
+    // holds, so every rank runs them.
+    std::unordered_map<NodeIndex, uint32_t> rank_of;
+    std::vector<uint64_t> work;  // Weighted work of each rank
+    uint64_t cut_bytes = 0;      // Estimated bytes sent between ranks in a run
+
+    bool runs_on(const ComputeNode& node, uint32_t rank) const {
+        auto it = rank_of.find(node.index);
+        return it == rank_of.end() || it->second == rank;
+    }
+};
+
+/**
+ * @brief Whether a datum can be sent to another rank: only ciphertexts of degree 1 serialize.
+ */
+inline bool is_shippable(const DatumNode& datum) {
+    return datum.datum_type == DataType::TYPE_CIPHERTEXT && datum.fhe_prop.has_value() && datum.fhe_prop->degree == 1;
+}
+
+/**
+ * @brief Partition the compute nodes of a graph among `n_ranks` ranks, keeping the weighted work of each rank within
+ * `imbalance` of the mean (plus the largest indivisible group) and the bytes sent between ranks small.
+ *
+ * The work of a node is its estimated cost (ComputeNode::ScheduleMeta::cost) times the RNS limbs of its output, and
+ * a datum read on another rank than its producer's costs its estimated size (estimate_datum_bytes(), i.e. by level
+ * and degree) once per such rank. Data that cannot be sent (plaintexts, degree-2 ciphertexts, custom data) keep
+ * their producer and consumers together, and the ABI imports that fill the output arguments stay on rank 0, where
+ * the outputs are collected.
+ *
+ * The groups of nodes are placed in topological order by linear deterministic greedy streaming (each group goes to
+ * the rank it shares the most bytes with, discounted by the rank's load), then refined by moving boundary groups to
+ * the rank that most reduces the cut bytes while the balance holds.
+ */
+inline GraphPartition partition_mega_ag(const MegaAG& mega_ag, uint32_t n_ranks, double imbalance = 0.1) {
+    GraphPartition partition;
+    partition.n_ranks = std::max<uint32_t>(n_ranks, 1);
+    partition.work.assign(partition.n_ranks, 0);
+    const uint64_t n = mega_ag.parameter.value("n", uint64_t(0));
+
+    auto is_op = [](const ComputeNode& node, OperationType op) {
+        return node.fhe_prop.has_value() && node.fhe_prop->op_type == op;
+    };
+
+    // Nodes to place, in topological order
+    std::vector<const ComputeNode*> nodes;
+    for (const auto& [index, node] : mega_ag.computes) {
+        if (!is_op(node, OperationType::EXPORT_TO_ABI)) {
+            nodes.push_back(&node);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const ComputeNode* a, const ComputeNode* b) {
+        return a->sched_meta.top_level != b->sched_meta.top_level ? a->sched_meta.top_level < b->sched_meta.top_level
+                                                                  : a->index < b->index;
+    });
+    std::unordered_map<NodeIndex, size_t> position;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        position[nodes[i]->index] = i;
+    }
+
+    // Group the producer and consumers of each datum that cannot be sent
+    std::vector<size_t> parent(nodes.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    std::function<size_t(size_t)> find = [&](size_t i) { return parent[i] == i ? i : parent[i] = find(parent[i]); };
+    for (const auto& [index, datum] : mega_ag.data) {
+        if (datum.predecessors.empty() || is_input_alias(datum) || is_shippable(datum)) {
+            continue;
+        }
+        size_t producer = find(position.at(datum.predecessors[0]->index));
+        for (const ComputeNode* consumer : datum.successors) {
+            size_t root = find(position.at(consumer->index));
+            parent[std::max(producer, root)] = std::min(producer, root);
+            producer = std::min(producer, root);
+        }
+    }
+
+    // Groups in order of their first node, with their work
+    std::vector<size_t> group_of(nodes.size());
+    std::vector<uint64_t> group_work;
+    std::vector<bool> group_pinned;
+    std::unordered_map<size_t, size_t> group_of_root;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        auto [it, inserted] = group_of_root.emplace(find(i), group_work.size());
+        if (inserted) {
+            group_work.push_back(0);
+            group_pinned.push_back(false);
+        }
+        size_t group = group_of[i] = it->second;
+        const DatumNode* output = nodes[i]->output_nodes.empty() ? nullptr : nodes[i]->output_nodes[0];
+        int limbs = output && output->fhe_prop.has_value() ? output->fhe_prop->level + 1 : 1;
+        group_work[group] += uint64_t(std::max(nodes[i]->sched_meta.cost, 1)) * uint64_t(std::max(limbs, 1));
+        if (is_op(*nodes[i], OperationType::IMPORT_FROM_ABI)) {
+            group_pinned[group] = true;
+        }
+    }
+    const size_t n_groups = group_work.size();
+
+    // Data sent between groups: the producer group and the consumer groups of each shippable datum
+    struct Edge {
+        uint64_t bytes;
+        size_t producer;
+        std::vector<size_t> consumers;
+    };
+    std::vector<Edge> edges;
+    std::vector<std::vector<size_t>> edges_of(n_groups);
+    for (const auto& [index, datum] : mega_ag.data) {
+        if (datum.predecessors.empty() || is_input_alias(datum) || datum.successors.empty()) {
+            continue;
+        }
+        Edge edge{estimate_datum_bytes(datum, n), group_of[position.at(datum.predecessors[0]->index)], {}};
+        for (const ComputeNode* consumer : datum.successors) {
+            size_t group = group_of[position.at(consumer->index)];
+            if (group != edge.producer &&
+                std::find(edge.consumers.begin(), edge.consumers.end(), group) == edge.consumers.end()) {
+                edge.consumers.push_back(group);
+            }
+        }
+        if (edge.consumers.empty()) {
+            continue;
+        }
+        edges_of[edge.producer].push_back(edges.size());
+        for (size_t group : edge.consumers) {
+            edges_of[group].push_back(edges.size());
+        }
+        edges.push_back(std::move(edge));
+    }
+
+    constexpr uint32_t unplaced = UINT32_MAX;
+    std::vector<uint32_t> rank(n_groups, unplaced);
+    std::vector<uint64_t>& load = partition.work;
+    uint64_t total_work = std::accumulate(group_work.begin(), group_work.end(), uint64_t(0));
+    uint64_t largest = n_groups ? *std::max_element(group_work.begin(), group_work.end()) : 0;
+    const double capacity = double(total_work) / partition.n_ranks * (1.0 + imbalance) + double(largest);
+
+    // Bytes of an edge sent between ranks under the current placement
+    auto edge_cost = [&](const Edge& edge) {
+        std::vector<uint32_t> ranks;
+        for (size_t group : edge.consumers) {
+            uint32_t r = rank[group];
+            if (r != unplaced && r != rank[edge.producer] && std::find(ranks.begin(), ranks.end(), r) == ranks.end()) {
+                ranks.push_back(r);
+            }
+        }
+        return edge.bytes * ranks.size();
+    };
+
+    // Streaming placement
+    for (size_t group = 0; group < n_groups; group++) {
+        if (group_pinned[group]) {
+            rank[group] = 0;
+            load[0] += group_work[group];
+        }
+    }
+    for (size_t group = 0; group < n_groups; group++) {
+        if (rank[group] != unplaced) {
+            continue;
+        }
+        std::vector<uint64_t> shared(partition.n_ranks, 0);
+        for (size_t e : edges_of[group]) {
+            const Edge& edge = edges[e];
+            if (edge.producer != group) {
+                if (rank[edge.producer] != unplaced) {
+                    shared[rank[edge.producer]] += edge.bytes;
+                }
+                continue;
+            }
+            for (size_t consumer : edge.consumers) {
+                if (rank[consumer] != unplaced) {
+                    shared[rank[consumer]] += edge.bytes;
+                }
+            }
+        }
+        uint32_t best = 0;
+        double best_score = -1.0;
+        for (uint32_t r = 0; r < partition.n_ranks; r++) {
+            if (double(load[r] + group_work[group]) > capacity) {
+                continue;
+            }
+            double score = double(shared[r]) * (1.0 - double(load[r]) / capacity);
+            if (score > best_score || (score == best_score && load[r] < load[best])) {
+                best = r;
+                best_score = score;
+            }
+        }
+        if (best_score < 0) {
+            best = uint32_t(std::min_element(load.begin(), load.end()) - load.begin());
+        }
+        rank[group] = best;
+        load[best] += group_work[group];
+    }
+
+    // Refinement
+    for (int pass = 0; pass < 8 && partition.n_ranks > 1; pass++) {
+        bool moved = false;
+        for (size_t group = 0; group < n_groups; group++) {
+            if (group_pinned[group] || edges_of[group].empty()) {
+                continue;
+            }
+            uint32_t from = rank[group];
+            int64_t before = 0;
+            for (size_t e : edges_of[group]) {
+                before += int64_t(edge_cost(edges[e]));
+            }
+            uint32_t best = from;
+            int64_t best_gain = 0;
+            for (uint32_t r = 0; r < partition.n_ranks; r++) {
+                if (r == from || double(load[r] + group_work[group]) > capacity) {
+                    continue;
+                }
+                rank[group] = r;
+                int64_t after = 0;
+                for (size_t e : edges_of[group]) {
+                    after += int64_t(edge_cost(edges[e]));
+                }
+                if (before - after > best_gain) {
+                    best = r;
+                    best_gain = before - after;
+                }
+            }
+            rank[group] = best;
+            if (best != from) {
+                load[from] -= group_work[group];
+                load[best] += group_work[group];
+                moved = true;
+            }
+        }
+        if (!moved) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        partition.rank_of[nodes[i]->index] = rank[group_of[i]];
+    }
+    for (const Edge& edge : edges) {
+        partition.cut_bytes += edge_cost(edge);
+    }
+    return partition;
+}
+
+/**
+ * @brief Exchange of the data of one distributed run between this rank and the others (see partition_mega_ag()).
+ *
+ * The data stored by this rank that computes of other ranks read are serialized and sent by a background thread; the
+ * data this rank reads from other ranks are received and deserialized by another. If a rank abandons the run, it
+ * tells the others, so that their runs fail instead of waiting for data that never come.
+ */
+template <typename TContext> class RemoteExchange {
+public:
+    using Ciphertext = CiphertextOf<TContext>;
+
+    // @param runs Whether a compute node runs on its rank in this run, e.g. false for nodes left out for unrequested
+    //             outputs; must give the same answer on every rank
+    RemoteExchange(const MegaAG& mega_ag,
+                   const GraphPartition& partition,
+                   Transport& transport,
+                   uint64_t run,
+                   TContext& context,
+                   const std::function<bool(const ComputeNode&)>& runs)
+        : transport_(transport), run_(run), param_(context.get_parameter()) {
+        const uint32_t self = transport.rank();
+        for (const auto& [index, datum] : mega_ag.data) {
+            if (datum.predecessors.empty() || is_input_alias(datum)) {
+                continue;
+            }
+            const ComputeNode& producer = *datum.predecessors[0];
+            if (!runs(producer)) {
+                continue;
+            }
+            uint32_t producer_rank = partition.rank_of.at(producer.index);
+            for (const ComputeNode* consumer : datum.successors) {
+                if (!runs(*consumer)) {
+                    continue;
+                }
+                uint32_t consumer_rank = partition.rank_of.at(consumer->index);
+                if (producer_rank == self && consumer_rank != self) {
+                    std::vector<uint32_t>& to = destinations_[index];
+                    if (std::find(to.begin(), to.end(), consumer_rank) == to.end()) {
+                        to.push_back(consumer_rank);
+                    }
+                } else if (producer_rank != self && consumer_rank == self) {
+                    awaited_[index] = producer_rank;
+                }
+            }
+        }
+        sender_ = std::thread([this]() { send_loop(); });
+        receiver_ = std::thread([this]() { receive_loop(); });
+    }
+
+    RemoteExchange(const RemoteExchange&) = delete;
+    RemoteExchange& operator=(const RemoteExchange&) = delete;
+
+    ~RemoteExchange() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        sender_.join();
+        receiver_.join();
+    }
+
+    // Queue a datum stored by this rank for the ranks that read it
+    void publish(const DatumNode& datum, const std::any& value) {
+        if (!destinations_.count(datum.index)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            outbox_.emplace_back(datum.index, value);
+        }
+        cv_.notify_all();
+    }
+
+    // Data received since the last call
+    // @throws std::runtime_error if another rank abandoned the run, or disconnected before sending all it owes
+    std::vector<std::pair<NodeIndex, std::any>> take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return std::exchange(received_, {});
+    }
+
+    // Wait until every published datum has been sent
+    // @throws std::runtime_error if a datum could not be sent
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return (outbox_.empty() && !sending_) || send_error_; });
+        if (send_error_) {
+            std::rethrow_exception(send_error_);
+        }
+    }
+
+    // Tell the other ranks that this rank abandons the run; best effort
+    void abort() {
+        TransportMessage message;
+        message.from = transport_.rank();
+        message.run = run_;
+        message.index = TransportMessage::abort_index;
+        for (uint32_t r = 0; r < transport_.size(); r++) {
+            if (r == transport_.rank()) {
+                continue;
+            }
+            try {
+                transport_.send(r, message);
+            } catch (...) {
+            }
+        }
+    }
+
+    uint64_t bytes_sent() const {
+        return bytes_sent_.load();
+    }
+
+    uint64_t bytes_received() const {
+        return bytes_received_.load();
+    }
+
+private:
+    void send_loop() {
+        while (true) {
+            std::pair<NodeIndex, std::any> item;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !outbox_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                if (send_error_) {
+                    outbox_.clear();
+                    continue;
+                }
+                item = std::move(outbox_.front());
+                outbox_.pop_front();
+                sending_ = true;
+            }
+            try {
+                TransportMessage message;
+                message.from = transport_.rank();
+                message.run = run_;
+                message.index = item.first;
+                message.payload = std::any_cast<const std::shared_ptr<Ciphertext>&>(item.second)->serialize(param_);
+                item.second.reset();
+                for (uint32_t to : destinations_.at(item.first)) {
+                    transport_.send(to, message);
+                    bytes_sent_.fetch_add(message.payload.size());
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                send_error_ = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                sending_ = false;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    void receive_loop() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stop_ || error_ || awaited_.empty()) {
+                    return;
+                }
+            }
+            std::optional<TransportMessage> message = transport_.receive(run_, std::chrono::milliseconds(10));
+            if (!message) {
+                // A rank that disconnected has delivered all it sent, so what it still owes never comes
+                for (const auto& [index, from] : awaited_) {
+                    if (transport_.peer_lost(from)) {
+                        fail("Rank " + std::to_string(from) + " disconnected during the run");
+                        return;
+                    }
+                }
+                continue;
+            }
+            if (message->index == TransportMessage::abort_index) {
+                fail("Rank " + std::to_string(message->from) + " abandoned the run");
+                return;
+            }
+            auto it = awaited_.find(message->index);
+            if (it == awaited_.end()) {
+                continue;
+            }
+            awaited_.erase(it);
+            bytes_received_.fetch_add(message->payload.size());
+            try {
+                std::any value = std::make_shared<Ciphertext>(Ciphertext::deserialize(message->payload));
+                std::lock_guard<std::mutex> lock(mutex_);
+                received_.emplace_back(message->index, std::move(value));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                error_ = std::current_exception();
+                return;
+            }
+        }
+    }
+
+    void fail(const std::string& what) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::make_exception_ptr(std::runtime_error(what));
+    }
+
+    Transport& transport_;
+    const uint64_t run_;
+    const decltype(std::declval<TContext&>().get_parameter()) param_;
+    std::unordered_map<NodeIndex, std::vector<uint32_t>> destinations_;  // Ranks reading each datum stored here
+    std::unordered_map<NodeIndex, uint32_t> awaited_;  // Rank of each datum read here and not received yet
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::pair<NodeIndex, std::any>> outbox_;
+    bool sending_ = false;
+    std::exception_ptr send_error_;
+    std::vector<std::pair<NodeIndex, std::any>> received_;
+    std::exception_ptr error_;
+    bool stop_ = false;
+
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> bytes_received_{0};
+
+    std::thread sender_;
+    std::thread receiver_;
+};
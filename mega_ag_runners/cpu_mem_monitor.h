@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
@@ -28,6 +30,10 @@
 // ---------------------------------------------------------------------------
 // MemoryMonitor: background thread that samples /proc/self/status every
 // `interval_ms` milliseconds and records (elapsed_ms, VmRSS_kB) pairs.
+// When a live-byte counter is attached (see LiveDataCounter in
+// cpu_task_utils.h), each sample also records the bytes of live intermediate
+// data held by the task runner, which shows whether RSS growth comes from
+// live ciphertexts or from memory the runtime has not released yet.
 //
 // Each sample is flushed to the CSV file immediately, so data is preserved
 // even if the process is killed abnormally (SIGKILL, crash, OOM, etc.).
@@ -40,19 +46,23 @@ struct MemoryMonitor {
     struct Sample {
         long elapsed_ms;
         long rss_kb;
+        uint64_t live_bytes;  // zero if no live-byte counter is attached
     };
 
     std::vector<Sample> samples;
     std::atomic<bool> running{false};
     std::thread thr;
     int interval_ms;
+    const std::atomic<uint64_t>* live_bytes{nullptr};
+    bool print_report{true};  // print the summary to stderr on stop()
     long rss_at_start{0};
     long hwm_at_start{0};
     std::chrono::steady_clock::time_point t0;
     std::ofstream ofs_live;  // written continuously
     std::string csv_path_;
 
-    explicit MemoryMonitor(int interval_ms_ = 100) : interval_ms(interval_ms_) {}
+    explicit MemoryMonitor(int interval_ms_ = 100, const std::atomic<uint64_t>* live_bytes_ = nullptr)
+        : interval_ms(interval_ms_), live_bytes(live_bytes_) {}
 
     // Destructor ensures the file is flushed and closed even on abnormal exit
     // (uncaught exception, early return, etc.). SIGKILL cannot be caught, but
@@ -108,14 +118,39 @@ struct MemoryMonitor {
         return base + "_" + buf + ".csv";
     }
 
-    // Open the CSV and start the background sampling thread.
+    // Take one sample and append it to the CSV, flushing immediately so data survives a kill signal.
+    void take_sample() {
+        auto now = std::chrono::steady_clock::now();
+        long ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - t0).count();
+        Sample sample{ms, read_mem().rss_kb, 0};
+        if (live_bytes)
+            sample.live_bytes = live_bytes->load(std::memory_order_relaxed);
+        samples.push_back(sample);
+
+        if (ofs_live.is_open()) {
+            const double gb = 1024.0 * 1024.0 * 1024.0;
+            ofs_live << ms << "," << sample.rss_kb << "," << std::fixed << sample.rss_kb / 1024.0 / 1024.0;
+            if (live_bytes)
+                ofs_live << "," << sample.live_bytes / gb;
+            ofs_live << "\n";
+            ofs_live.flush();
+        }
+    }
+
+    // Open the CSV (unless csv_path is empty) and start the background sampling thread.
     // The file is written sample-by-sample so it survives abnormal termination.
+    // Columns: elapsed_ms,rss_kb,rss_gb, then live_gb if a live-byte counter is attached.
     void start(const std::string& csv_path = "mem_usage_cpu.csv") {
         csv_path_ = csv_path;
 
-        ofs_live.open(csv_path_, std::ios::out | std::ios::trunc);
-        ofs_live << "elapsed_ms,rss_kb,rss_gb\n";
-        ofs_live.flush();
+        if (!csv_path_.empty()) {
+            ofs_live.open(csv_path_, std::ios::out | std::ios::trunc);
+            ofs_live << "elapsed_ms,rss_kb,rss_gb";
+            if (live_bytes)
+                ofs_live << ",live_gb";
+            ofs_live << "\n";
+            ofs_live.flush();
+        }
 
         auto m = read_mem();
         rss_at_start = m.rss_kb;
@@ -124,34 +159,35 @@ struct MemoryMonitor {
         running = true;
         thr = std::thread([this] {
             while (running) {
-                auto now = std::chrono::steady_clock::now();
-                long ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - t0).count();
-                auto m = read_mem();
-                samples.push_back({ms, m.rss_kb});
-
-                // Write and flush immediately so data survives a kill signal.
-                ofs_live << ms << "," << m.rss_kb << "," << std::fixed << m.rss_kb / 1024.0 / 1024.0 << "\n";
-                ofs_live.flush();
-
+                take_sample();
                 std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
             }
         });
     }
 
+    // Peak of each sampled series.
+    Sample peak() const {
+        Sample p{0, 0, 0};
+        for (const auto& s : samples) {
+            p.elapsed_ms = std::max(p.elapsed_ms, s.elapsed_ms);
+            p.rss_kb = std::max(p.rss_kb, s.rss_kb);
+            p.live_bytes = std::max(p.live_bytes, s.live_bytes);
+        }
+        return p;
+    }
+
     void stop() {
         running = false;
         if (thr.joinable())
             thr.join();
 
         // Final sample
-        auto now = std::chrono::steady_clock::now();
-        long ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - t0).count();
-        auto m = read_mem();
-        samples.push_back({ms, m.rss_kb});
+        take_sample();
+        if (ofs_live.is_open())
+            ofs_live.close();
 
-        ofs_live << ms << "," << m.rss_kb << "," << std::fixed << m.rss_kb / 1024.0 / 1024.0 << "\n";
-        ofs_live.flush();
-        ofs_live.close();
+        if (!print_report)
+            return;
 
         long max_rss = 0, sum_rss = 0;
         for (auto& s : samples) {
@@ -176,6 +212,10 @@ struct MemoryMonitor {
         fprintf(stderr, "[MEM] Avg RSS        : %ld kB  (%.1f GB)\n", avg_rss, avg_rss / 1024.0 / 1024.0);
         fprintf(stderr, "[MEM] Final RSS      : %ld kB  (%.1f GB)\n", samples.back().rss_kb,
                 samples.back().rss_kb / 1024.0 / 1024.0);
+        if (live_bytes) {
+            const double gb = 1024.0 * 1024.0 * 1024.0;
+            fprintf(stderr, "[MEM] Peak live data : %.2f GB  [sampled intermediate data]\n", peak().live_bytes / gb);
+        }
         fprintf(stderr, "[MEM] Duration       : %ld ms\n", samples.back().elapsed_ms);
         fprintf(stderr, "[MEM] CSV            : %s\n", csv_path_.c_str());
         fprintf(stderr, "[MEM] -----------------------------------\n\n");
@@ -0,0 +1,258 @@
+// Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include "../lib/thread_pool/BS_thread_pool.hpp"
+#include "cpu_task_utils.h"
+
+// ---------------------------------------------------------------------------
+// CpuRuntime: one worker pool shared by the runs of any number of CPU tasks,
+// instead of a pool per run.
+//
+// Each run belongs to a tenant. A tenant may cap its number of concurrent
+// runs; further runs wait for admission. While the pool has queued jobs, each
+// run keeps at most its fair share of jobs in flight: the pool threads are
+// divided among the tenants with active runs in proportion to their weights,
+// and a tenant's share evenly among its runs. When workers are idle, any run
+// may dispatch. Jobs queued in the pool run in tenant priority order; within
+// a run, ready nodes are dispatched in critical-path order as usual.
+//
+// With a memory budget, a run is admitted only while the intermediate bytes
+// reserved by the admitted runs plus its own estimated peak stay within the
+// budget; a run that fits nowhere is admitted once it is alone. Each admitted
+// run reserves the larger of its estimate and the peak of its live-byte
+// counter so far, so an underestimate is corrected while the run goes on.
+// Runs waiting for memory are admitted in arrival order.
+// ---------------------------------------------------------------------------
+class CpuRuntime {
+public:
+    struct TenantOptions {
+        uint32_t weight = 1;               // share of the pool relative to the other active tenants, at least 1
+        BS::priority_t priority = 0;       // pool priority of the tenant's jobs, higher runs first
+        uint32_t max_concurrent_runs = 0;  // runs admitted at once, 0 for no limit
+    };
+
+    struct TenantStats {
+        uint64_t runs_completed = 0;  // runs that finished successfully
+        uint64_t runs_failed = 0;     // runs that failed or were cancelled, including while waiting for admission
+        uint64_t active_runs = 0;     // runs admitted and not finished
+        uint64_t waiting_runs = 0;    // runs waiting for admission
+        uint64_t jobs = 0;            // pool jobs run
+        uint64_t busy_ns = 0;         // wall time of the pool jobs run
+        uint64_t wait_ns = 0;         // time runs spent waiting for admission
+    };
+
+    // One admitted run of a tenant; the run is released when the object is destroyed
+    class Admission {
+    public:
+        // Wait until the tenant is below its concurrency limit and the run's estimated peak of intermediate bytes
+        // fits in the memory budget; `live` is the run's live-byte counter and must outlive the admission
+        // @throws RunCancelledError if `cancelled` is set or `deadline` passes while waiting
+        Admission(CpuRuntime& runtime,
+                  const std::string& tenant,
+                  uint64_t estimated_bytes,
+                  const LiveDataCounter* live,
+                  const std::atomic<bool>* cancelled,
+                  std::chrono::steady_clock::time_point deadline)
+            : runtime_(runtime), tenant_(tenant), estimated_bytes_(estimated_bytes), live_(live) {
+            auto start = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(runtime_.mutex_);
+            Tenant& t = runtime_.tenants_[tenant_];
+            t.stats.waiting_runs++;
+            auto is_cancelled = [&]() {
+                return (cancelled && cancelled->load()) || std::chrono::steady_clock::now() >= deadline;
+            };
+            const uint64_t ticket = runtime_.next_ticket_++;
+            auto& memory_queue = runtime_.memory_queue_;
+            while (true) {
+                bool below_limit =
+                    t.options.max_concurrent_runs == 0 || t.stats.active_runs < t.options.max_concurrent_runs;
+                if (below_limit) {
+                    bool fits = runtime_.active_.empty() ||
+                                runtime_.reserved_bytes_locked() + estimated_bytes_ <= runtime_.memory_budget_;
+                    bool first = memory_queue.empty() || memory_queue.front() == ticket;
+                    if (fits && first) {
+                        break;
+                    }
+                    if (std::find(memory_queue.begin(), memory_queue.end(), ticket) == memory_queue.end()) {
+                        memory_queue.push_back(ticket);
+                    }
+                }
+                if (is_cancelled()) {
+                    memory_queue.erase(std::remove(memory_queue.begin(), memory_queue.end(), ticket),
+                                       memory_queue.end());
+                    t.stats.waiting_runs--;
+                    t.stats.runs_failed++;
+                    runtime_.admission_cv_.notify_all();
+                    throw RunCancelledError("Task run was cancelled while waiting for admission");
+                }
+                runtime_.admission_cv_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            if (!memory_queue.empty() && memory_queue.front() == ticket) {
+                memory_queue.pop_front();
+                runtime_.admission_cv_.notify_all();
+            }
+            runtime_.active_.insert(this);
+            t.stats.waiting_runs--;
+            t.stats.active_runs++;
+            wait_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                           .count();
+            t.stats.wait_ns += wait_ns_;
+            if (t.stats.active_runs == 1) {
+                runtime_.active_weight_ += t.options.weight;
+            }
+        }
+
+        Admission(const Admission&) = delete;
+        Admission& operator=(const Admission&) = delete;
+
+        ~Admission() {
+            std::lock_guard<std::mutex> lock(runtime_.mutex_);
+            Tenant& t = runtime_.tenants_[tenant_];
+            runtime_.active_.erase(this);
+            t.stats.active_runs--;
+            if (t.stats.active_runs == 0) {
+                runtime_.active_weight_ -= t.options.weight;
+            }
+            (succeeded_ ? t.stats.runs_completed : t.stats.runs_failed)++;
+            runtime_.admission_cv_.notify_all();
+        }
+
+        // Mark the run as successful
+        void complete() {
+            succeeded_ = true;
+        }
+
+        // Time the run waited for admission
+        uint64_t wait_ns() const {
+            return wait_ns_;
+        }
+
+        // Intermediate bytes held for the run: its estimate, or its peak so far if that is larger
+        uint64_t reserved_bytes() const {
+            return std::max(estimated_bytes_, live_ ? live_->peak_bytes.load() : 0);
+        }
+
+        BS::priority_t priority() const {
+            std::lock_guard<std::mutex> lock(runtime_.mutex_);
+            return runtime_.tenants_.at(tenant_).options.priority;
+        }
+
+        // Whether the run may dispatch another pool job while `in_flight` of its jobs are queued or running
+        bool may_dispatch(size_t in_flight) const {
+            if (runtime_.pool_.get_tasks_queued() == 0) {
+                return true;
+            }
+            std::lock_guard<std::mutex> lock(runtime_.mutex_);
+            const Tenant& t = runtime_.tenants_.at(tenant_);
+            uint64_t share = runtime_.pool_.get_thread_count() * t.options.weight /
+                             (std::max<uint64_t>(runtime_.active_weight_, 1) * t.stats.active_runs);
+            return in_flight < std::max<uint64_t>(share, 1);
+        }
+
+        void record_job(std::chrono::nanoseconds busy) {
+            std::lock_guard<std::mutex> lock(runtime_.mutex_);
+            Tenant& t = runtime_.tenants_[tenant_];
+            t.stats.jobs++;
+            t.stats.busy_ns += busy.count();
+        }
+
+    private:
+        CpuRuntime& runtime_;
+        std::string tenant_;
+        uint64_t estimated_bytes_;
+        const LiveDataCounter* live_;
+        uint64_t wait_ns_ = 0;
+        bool succeeded_ = false;
+    };
+
+    // @param num_threads Number of worker threads, 0 for the per-run default of min(32, hardware threads)
+    explicit CpuRuntime(size_t num_threads)
+        : pool_(num_threads ? num_threads : std::min(32u, std::max(1u, std::thread::hardware_concurrency()))) {}
+
+    BS::priority_thread_pool& pool() {
+        return pool_;
+    }
+
+    // Set the options of a tenant, created on first use with the default options; they apply to its running and
+    // waiting runs at once
+    void set_tenant_options(const std::string& tenant, const TenantOptions& options) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Tenant& t = tenants_[tenant];
+        uint32_t weight = std::max<uint32_t>(options.weight, 1);
+        if (t.stats.active_runs > 0) {
+            active_weight_ = active_weight_ - t.options.weight + weight;
+        }
+        t.options = options;
+        t.options.weight = weight;
+        admission_cv_.notify_all();
+    }
+
+    // Budget of intermediate bytes of the admitted runs, UINT64_MAX (the default) for none
+    void set_memory_budget(uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memory_budget_ = bytes;
+        admission_cv_.notify_all();
+    }
+
+    // Intermediate bytes currently reserved by the admitted runs
+    uint64_t reserved_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reserved_bytes_locked();
+    }
+
+    TenantStats get_tenant_stats(const std::string& tenant) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tenants_.find(tenant);
+        return it == tenants_.end() ? TenantStats() : it->second.stats;
+    }
+
+private:
+    struct Tenant {
+        TenantOptions options;
+        TenantStats stats;
+    };
+
+    uint64_t reserved_bytes_locked() const {
+        uint64_t bytes = 0;
+        for (const Admission* admission : active_) {
+            bytes += admission->reserved_bytes();
+        }
+        return bytes;
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable admission_cv_;
+    std::map<std::string, Tenant> tenants_;
+    uint64_t active_weight_ = 0;  // Total weight of the tenants with active runs
+    uint64_t memory_budget_ = UINT64_MAX;
+    std::unordered_set<const Admission*> active_;
+    std::deque<uint64_t> memory_queue_;  // Tickets of the runs below their tenant limit that wait for memory
+    uint64_t next_ticket_ = 0;
+    BS::priority_thread_pool pool_;
+};
@@ -0,0 +1,174 @@
+// Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// SpillFile: scratch file for intermediate data moved out of memory by the
+// task runner. The file is unlinked as soon as it is created, so it goes away
+// with the process. Records are placed at page-aligned offsets, first fit;
+// released ranges are reused. Records are written and read with pwrite() and
+// pread(), so that their bytes are page cache, not process memory, and a full
+// disk fails the write instead of faulting a mapped store. The directory must
+// be on a disk: spilling to a tmpfs (as /tmp often is) frees no memory.
+//
+// write(), read() and release() can be called concurrently.
+// ---------------------------------------------------------------------------
+class SpillFile {
+public:
+    // @throws std::runtime_error if the file cannot be created in `dir` (empty for /tmp)
+    explicit SpillFile(const std::string& dir) {
+        std::string path = (dir.empty() ? std::string("/tmp") : dir) + "/lattisense_spill_XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        fd_ = mkstemp(name.data());
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to create spill file " + path);
+        }
+        unlink(name.data());
+    }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    ~SpillFile() {
+        close(fd_);
+    }
+
+    // Store a record and return its offset
+    // @throws std::runtime_error if the record cannot be written, e.g. when the disk is full; nothing is stored then
+    uint64_t write(const void* data, uint64_t size) {
+        uint64_t offset = allocate(size);
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        uint64_t written = 0;
+        while (written < size) {
+            ssize_t n = pwrite(fd_, begin + written, size - written, static_cast<off_t>(offset + written));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                release(offset, size);
+                throw std::runtime_error("Failed to write spill file");
+            }
+            written += n;
+        }
+        return offset;
+    }
+
+    // Copy out the record at `offset`
+    // @throws std::runtime_error if the record cannot be read
+    std::vector<uint8_t> read(uint64_t offset, uint64_t size) const {
+        std::vector<uint8_t> bytes(size);
+        uint64_t done = 0;
+        while (done < size) {
+            ssize_t n = pread(fd_, bytes.data() + done, size - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                throw std::runtime_error("Failed to read spill file");
+            }
+            done += n;
+        }
+        return bytes;
+    }
+
+    // Free the record at `offset` for reuse
+    void release(uint64_t offset, uint64_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [it, _] = free_.emplace(offset, round_up(size));
+        auto next = std::next(it);
+        if (next != free_.end() && it->first + it->second == next->first) {
+            it->second += next->second;
+            free_.erase(next);
+        }
+        if (it != free_.begin()) {
+            auto prev = std::prev(it);
+            if (prev->first + prev->second == it->first) {
+                prev->second += it->second;
+                free_.erase(it);
+            }
+        }
+    }
+
+    // Bytes of the file in use by records or free ranges
+    uint64_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return end_;
+    }
+
+private:
+    static constexpr uint64_t page_size = 4096;
+
+    static uint64_t round_up(uint64_t size) {
+        return (size + page_size - 1) / page_size * page_size;
+    }
+
+    uint64_t allocate(uint64_t size) {
+        size = round_up(size);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = free_.begin(); it != free_.end(); ++it) {
+            if (it->second >= size) {
+                uint64_t offset = it->first;
+                uint64_t rest = it->second - size;
+                free_.erase(it);
+                if (rest > 0) {
+                    free_.emplace(offset + size, rest);
+                }
+                return offset;
+            }
+        }
+        uint64_t offset = end_;
+        end_ += size;
+        return offset;
+    }
+
+    int fd_ = -1;
+    uint64_t end_ = 0;
+    std::map<uint64_t, uint64_t> free_;  // Offset and size of the released ranges
+    mutable std::mutex mutex_;           // Guards end_ and the free list
+};
+
+/**
+ * @brief Placeholder of a datum moved to a SpillFile, kept in the runner's available data in place of its value.
+ */
+struct SpilledDatum {
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * @brief Serialized bytes moved by the spill tier of run_tasks(); can be read concurrently.
+ */
+struct SpillCounters {
+    std::atomic<uint64_t> spilled_bytes{0};        // Written to the spill file
+    std::atomic<uint64_t> prefetched_bytes{0};     // Read back ahead of the consumers
+    std::atomic<uint64_t> demand_loaded_bytes{0};  // Read back by a consumer that found its input still spilled
+    std::atomic<uint64_t> peak_file_bytes{0};      // Peak size of the spill file
+};
@@ -22,15 +22,22 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <set>
+#include <stdexcept>
 #include <atomic>
 #include <condition_variable>
+#include <exception>
 #include <functional>
+#include <future>
+#include <iterator>
+#include <optional>
 #include <any>
 #include <unordered_map>
+#include <unordered_set>
 #include <chrono>
 #include <thread>
 #include <cstdio>
@@ -40,6 +47,7 @@
 #include "mega_ag.h"
 #include "../lib/gsl/span"
 #include "../tools/task_progress_bar.h"
+#include "cpu_spill.h"
 
 extern "C" {
 #include "../abi/c_structs.h"
@@ -211,12 +219,11 @@ std::vector<std::unique_ptr<TContext>> create_thread_contexts(BS::priority_threa
                                                               const std::unique_ptr<TContext>& context) {
     const size_t num_threads = pool.get_thread_count();
     std::vector<std::unique_ptr<TContext>> context_ptrs(num_threads);
-    for (size_t i = 0; i < num_threads; ++i) {
-        pool.detach_task([&context_ptrs, &context, i]() {
-            context_ptrs[i] = std::make_unique<TContext>(context->shallow_copy_context());
-        });
-    }
-    pool.wait();
+    auto copy_context = [&context_ptrs, &context](size_t i) {
+        context_ptrs[i] = std::make_unique<TContext>(context->shallow_copy_context());
+    };
+    // Wait for these jobs only, the pool may be shared with other runs
+    pool.submit_sequence(size_t(0), num_threads, copy_context).wait();
 
     return context_ptrs;
 }
@@ -352,6 +359,589 @@ struct TaskInfo {
     }
 };
 
+/**
+ * @brief Whether a compute node is cheap enough that its pool dispatch overhead matters, so that several of them are
+ * worth running in one pool job.
+ */
+inline bool is_coalescable(const ComputeNode& node) {
+    if (!node.fhe_prop.has_value() || node.output_nodes.size() != 1 || !node.output_nodes[0]->fhe_prop.has_value()) {
+        return false;
+    }
+    switch (node.fhe_prop->op_type) {
+        case OperationType::ADD:
+        case OperationType::SUB:
+        case OperationType::NEGATE:
+        case OperationType::MULTIPLY:
+        case OperationType::DROP_LEVEL: return true;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Whether `candidate` can run in the same pool job as `head`: same op type and same output level.
+ */
+inline bool can_coalesce(const ComputeNode& head, const ComputeNode& candidate) {
+    return is_coalescable(candidate) && candidate.fhe_prop->op_type == head.fhe_prop->op_type &&
+           candidate.output_nodes[0]->fhe_prop->level == head.output_nodes[0]->fhe_prop->level;
+}
+
+/**
+ * @brief Estimated in-memory size of an FHE datum: (degree + 1) polynomials of (level + 1) RNS limbs of n 64-bit words,
+ * or a single n-word polynomial for ring-t plaintexts. Custom data counts as 0.
+ */
+inline uint64_t estimate_datum_bytes(const DatumNode& node, uint64_t n) {
+    if (!node.fhe_prop.has_value()) {
+        return 0;
+    }
+    const DatumNode::FheProperty& prop = *node.fhe_prop;
+    if (prop.p.has_value() && prop.p->is_ringt) {
+        return n * sizeof(uint64_t);
+    }
+    return uint64_t(prop.degree + 1) * uint64_t(prop.level + 1) * n * sizeof(uint64_t);
+}
+
+/**
+ * @brief Whether a datum is the ABI copy of a task input made by an EXPORT_TO_ABI node; on CPU it shares the input's
+ * value.
+ */
+inline bool is_input_alias(const DatumNode& datum) {
+    return !datum.predecessors.empty() && datum.predecessors[0]->fhe_prop.has_value() &&
+           datum.predecessors[0]->fhe_prop->op_type == OperationType::EXPORT_TO_ABI;
+}
+
+/**
+ * @brief Estimate the peak bytes of intermediate data (neither task input, ABI copy of an input nor task output) held
+ * by a run of the graph on `parallelism` threads.
+ *
+ * The graph is replayed one node at a time in the order of the runner's dispatcher, highest node priority first, so
+ * the estimate follows the schedule mode. Each output is counted from its producer until its last consumer has run,
+ * as with purge_unused_data(). The other threads may hold up to `parallelism - 1` more results at the peak, which are
+ * counted at the size of the largest intermediate.
+ */
+inline uint64_t estimate_peak_live_bytes(const MegaAG& mega_ag, size_t parallelism) {
+    const uint64_t n = mega_ag.parameter.value("n", uint64_t(0));
+    auto is_intermediate = [](const DatumNode* datum) {
+        return !datum->is_input && !datum->is_output && !is_input_alias(*datum);
+    };
+
+    std::unordered_set<NodeIndex> available;
+    std::unordered_map<NodeIndex, size_t> ref_counts;
+    uint64_t largest = 0;
+    for (const auto& [index, datum] : mega_ag.data) {
+        if (datum.predecessors.empty()) {
+            available.insert(index);
+        }
+        ref_counts[index] = datum.successors.size();
+        if (is_intermediate(&datum)) {
+            largest = std::max(largest, estimate_datum_bytes(datum, n));
+        }
+    }
+    auto is_ready = [&available](const ComputeNode& node) {
+        return std::all_of(node.input_nodes.begin(), node.input_nodes.end(),
+                           [&available](const DatumNode* input) { return available.count(input->index) != 0; });
+    };
+
+    std::priority_queue<TaskInfo> ready;
+    std::unordered_set<NodeIndex> queued;
+    for (const auto& [index, node] : mega_ag.computes) {
+        if (is_ready(node)) {
+            ready.push({node.priority, index});
+            queued.insert(index);
+        }
+    }
+
+    uint64_t live = 0;
+    uint64_t peak = 0;
+    while (!ready.empty()) {
+        const ComputeNode& node = mega_ag.computes.at(ready.top().index);
+        ready.pop();
+        for (const DatumNode* output : node.output_nodes) {
+            available.insert(output->index);
+            if (is_intermediate(output)) {
+                live += estimate_datum_bytes(*output, n);
+            }
+        }
+        peak = std::max(peak, live);
+        for (const DatumNode* input : node.input_nodes) {
+            size_t& refs = ref_counts[input->index];
+            if (refs > 0 && --refs == 0 && is_intermediate(input)) {
+                live -= estimate_datum_bytes(*input, n);
+            }
+        }
+        for (const DatumNode* output : node.output_nodes) {
+            for (const ComputeNode* consumer : output->successors) {
+                if (!queued.count(consumer->index) && is_ready(*consumer)) {
+                    ready.push({consumer->priority, consumer->index});
+                    queued.insert(consumer->index);
+                }
+            }
+        }
+    }
+    return peak + largest * (std::max<size_t>(parallelism, 1) - 1);
+}
+
+/**
+ * @brief Bytes of intermediate data (neither task input, ABI copy of an input nor task output) currently held by
+ * run_tasks, and the peak.
+ *
+ * Updated by the runner as intermediates are produced and purged; `live_bytes` can be read concurrently, e.g. by
+ * MemoryMonitor.
+ */
+struct LiveDataCounter {
+    std::atomic<uint64_t> live_bytes{0};
+    std::atomic<uint64_t> peak_bytes{0};
+
+    void add(uint64_t bytes) {
+        uint64_t now = live_bytes.fetch_add(bytes) + bytes;
+        uint64_t peak = peak_bytes.load();
+        while (now > peak && !peak_bytes.compare_exchange_weak(peak, now)) {
+        }
+    }
+
+    void sub(uint64_t bytes) {
+        live_bytes.fetch_sub(bytes);
+    }
+};
+
+/**
+ * @brief Thrown by run_tasks() when the run is cancelled or passes its deadline.
+ */
+class RunCancelledError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Number of the pool jobs of one run that are queued or running, so that the run can wait for its own jobs
+ * in a pool shared with other runs.
+ */
+struct PoolJobCounter {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t in_flight = 0;
+
+    void add() {
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight++;
+    }
+
+    void done() {
+        std::lock_guard<std::mutex> lock(mutex);
+        in_flight--;
+        cv.notify_all();
+    }
+
+    // Marks a job added with add() done when it goes out of scope, however the job exits
+    struct Scope {
+        PoolJobCounter& counter;
+        ~Scope() {
+            counter.done();
+        }
+    };
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return in_flight;
+    }
+
+    // Wait until fewer than `seen` jobs are in flight, at most `timeout`
+    template <typename Duration> void wait_below(size_t seen, Duration timeout) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, timeout, [&] { return in_flight < seen; });
+    }
+
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return in_flight == 0; });
+    }
+};
+
+/**
+ * @brief Check whether a compute node writes a task output, directly or through the ABI bridge nodes
+ * (IMPORT_FROM_ABI, STORE_FROM_BACKEND) that only copy its result out.
+ */
+inline bool produces_output(const ComputeNode& node) {
+    for (const DatumNode* output : node.output_nodes) {
+        if (output->is_output) {
+            return true;
+        }
+        for (const ComputeNode* consumer : output->successors) {
+            bool is_copy_out = consumer->fhe_prop.has_value() &&
+                               (consumer->fhe_prop->op_type == OperationType::IMPORT_FROM_ABI ||
+                                consumer->fhe_prop->op_type == OperationType::STORE_FROM_BACKEND);
+            if (is_copy_out && produces_output(*consumer)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// Ciphertext type of a context: BfvCiphertext for BfvContext, CkksCiphertext for the CKKS contexts.
+template <typename TContext>
+using CiphertextOf = std::conditional_t<std::is_same_v<TContext, BfvContext>, BfvCiphertext, CkksCiphertext>;
+
+/**
+ * @brief Spill tier of run_tasks(): moves idle intermediate ciphertexts to a SpillFile under memory pressure and
+ * reads them back ahead of their consumers.
+ *
+ * While the live intermediate bytes exceed the threshold, the ciphertexts produced by the run none of whose pending
+ * consumers has been queued yet are spilled, those used last first. The time until the next use of a datum is
+ * estimated by the smallest top level of its pending consumers, then by their highest priority. A spilled datum stays
+ * in the available data as a SpilledDatum, so that readiness is tracked as usual. When a datum is stored, the spilled
+ * inputs of its consumers are prefetched by a background thread; a consumer that still finds an input spilled reads
+ * it back itself. Restored data are not spilled again.
+ *
+ * Members marked "under the scheduler lock" must be called with the run's scheduler mutex held; the others take it
+ * themselves.
+ */
+template <typename TContext> class SpillTier {
+public:
+    using Ciphertext = CiphertextOf<TContext>;
+
+    SpillTier(const MegaAG& mega_ag,
+              TContext& context,
+              std::unordered_map<NodeIndex, std::any>& available_data,
+              const std::set<NodeIndex>& queued_computes,
+              std::mutex& scheduler_mutex,
+              LiveDataCounter& live_data,
+              uint64_t threshold_bytes,
+              const std::string& dir,
+              SpillCounters* counters)
+        : mega_ag_(mega_ag), param_(context.get_parameter()), available_data_(available_data),
+          queued_computes_(queued_computes), mutex_(scheduler_mutex), live_data_(live_data),
+          threshold_bytes_(threshold_bytes), file_(dir), counters_(counters ? counters : &own_counters_),
+          n_(mega_ag.parameter.value("n", uint64_t(0))), prefetcher_([this]() { prefetch_loop(); }) {}
+
+    SpillTier(const SpillTier&) = delete;
+    SpillTier& operator=(const SpillTier&) = delete;
+
+    ~SpillTier() {
+        stop_prefetch();
+    }
+
+    // Stop the prefetch thread and wait for the read back it is doing, so that it no longer touches the available data
+    void stop_prefetch() {
+        {
+            std::lock_guard<std::mutex> lock(prefetch_mutex_);
+            stop_ = true;
+        }
+        prefetch_cv_.notify_all();
+        if (prefetcher_.joinable()) {
+            prefetcher_.join();
+        }
+    }
+
+    static bool is_spilled(const std::any& value) {
+        return value.type() == typeid(SpilledDatum);
+    }
+
+    // Record a completed compute node; under the scheduler lock
+    void note_done(NodeIndex compute) {
+        done_.insert(compute);
+    }
+
+    // Queue the spilled inputs of the consumers of a newly stored datum for prefetch; under the scheduler lock
+    void prefetch_consumer_inputs(const DatumNode& stored) {
+        std::vector<NodeIndex> to_prefetch;
+        for (const ComputeNode* consumer : stored.successors) {
+            for (const DatumNode* input : consumer->input_nodes) {
+                auto it = available_data_.find(input->index);
+                if (it != available_data_.end() && is_spilled(it->second) && !restoring_.count(input->index)) {
+                    to_prefetch.push_back(input->index);
+                }
+            }
+        }
+        if (to_prefetch.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(prefetch_mutex_);
+            for (NodeIndex index : to_prefetch) {
+                if (prefetch_queued_.insert(index).second) {
+                    prefetch_queue_.push_back(index);
+                }
+            }
+        }
+        prefetch_cv_.notify_one();
+    }
+
+    // Get the value of a datum, reading it back from the spill file if needed
+    std::any restore(NodeIndex index, bool prefetch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = available_data_.find(index);
+        if (it == available_data_.end() || !is_spilled(it->second)) {
+            return it == available_data_.end() ? std::any() : it->second;
+        }
+        auto restoring = restoring_.find(index);
+        if (restoring != restoring_.end()) {
+            std::shared_future<std::any> pending = restoring->second;
+            lock.unlock();
+            return pending.get();
+        }
+        SpilledDatum slot = std::any_cast<SpilledDatum>(it->second);
+        std::promise<std::any> promise;
+        restoring_[index] = promise.get_future().share();
+        lock.unlock();
+
+        std::any value;
+        try {
+            Bytes bytes = file_.read(slot.offset, slot.size);
+            value = std::make_shared<Ciphertext>(Ciphertext::deserialize(bytes));
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            lock.lock();
+            restoring_.erase(index);
+            throw;
+        }
+        (prefetch ? counters_->prefetched_bytes : counters_->demand_loaded_bytes).fetch_add(slot.size);
+
+        lock.lock();
+        file_.release(slot.offset, slot.size);
+        available_data_[index] = value;
+        restoring_.erase(index);
+        restored_.insert(index);
+        live_data_.add(estimate_datum_bytes(mega_ag_.data.at(index), n_));
+        lock.unlock();
+        promise.set_value(value);
+        return value;
+    }
+
+    // Serialized value of a spilled datum; under the scheduler lock, which keeps its slot in the file
+    Bytes read_spilled(NodeIndex index) const {
+        SpilledDatum slot = std::any_cast<SpilledDatum>(available_data_.at(index));
+        return file_.read(slot.offset, slot.size);
+    }
+
+    // Spill idle ciphertexts until the live intermediate bytes are back under the threshold. Does nothing if another
+    // thread is already spilling. Spilling is best effort: a datum that cannot be written stays in memory.
+    void relieve_pressure() {
+        if (live_data_.live_bytes.load() <= threshold_bytes_ || spilling_.exchange(true)) {
+            return;
+        }
+        std::vector<std::pair<NodeIndex, std::any>> victims;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            victims = select_victims();
+        }
+        for (auto& [index, value] : victims) {
+            try {
+                Bytes bytes = std::any_cast<const std::shared_ptr<Ciphertext>&>(value)->serialize(param_);
+                uint64_t offset = file_.write(bytes.data(), bytes.size());
+                uint64_t file_bytes = file_.size();
+                uint64_t peak = counters_->peak_file_bytes.load();
+                while (file_bytes > peak && !counters_->peak_file_bytes.compare_exchange_weak(peak, file_bytes)) {
+                }
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = available_data_.find(index);
+                bool still_idle = it != available_data_.end() && !is_spilled(it->second) && is_idle(index);
+                if (still_idle) {
+                    it->second = SpilledDatum{offset, bytes.size()};
+                    live_data_.sub(estimate_datum_bytes(mega_ag_.data.at(index), n_));
+                    counters_->spilled_bytes.fetch_add(bytes.size());
+                } else {
+                    file_.release(offset, bytes.size());
+                }
+            } catch (...) {
+                // Leave the datum in memory
+            }
+            value.reset();
+        }
+        spilling_.store(false);
+    }
+
+private:
+    // Whether a datum has no pending consumer queued yet; under the scheduler lock
+    bool is_idle(NodeIndex index) const {
+        for (const ComputeNode* consumer : mega_ag_.data.at(index).successors) {
+            if (!done_.count(consumer->index) && queued_computes_.count(consumer->index)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Pick idle ciphertexts, used last first, whose estimated size covers the excess; under the scheduler lock
+    std::vector<std::pair<NodeIndex, std::any>> select_victims() {
+        struct Candidate {
+            int next_top_level;
+            int next_priority;
+            NodeIndex index;
+        };
+        std::vector<Candidate> candidates;
+        for (const auto& [index, value] : available_data_) {
+            const DatumNode& datum = mega_ag_.data.at(index);
+            // Only results of this run other than input copies: seeded values are shared with a cache and input copies
+            // with the caller, so spilling them frees nothing
+            bool produced = !datum.predecessors.empty() && done_.count(datum.predecessors.front()->index);
+            if (!produced || is_input_alias(datum) || datum.is_output ||
+                datum.datum_type != DataType::TYPE_CIPHERTEXT || value.type() != typeid(std::shared_ptr<Ciphertext>) ||
+                restored_.count(index) || !is_idle(index)) {
+                continue;
+            }
+            Candidate candidate{INT32_MAX, INT32_MIN, index};
+            for (const ComputeNode* consumer : datum.successors) {
+                if (!done_.count(consumer->index)) {
+                    candidate.next_top_level = std::min(candidate.next_top_level, consumer->sched_meta.top_level);
+                    candidate.next_priority = std::max(candidate.next_priority, consumer->priority);
+                }
+            }
+            candidates.push_back(candidate);
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.next_top_level != b.next_top_level ? a.next_top_level > b.next_top_level
+                                                        : a.next_priority < b.next_priority;
+        });
+
+        std::vector<std::pair<NodeIndex, std::any>> victims;
+        uint64_t live = live_data_.live_bytes.load();
+        for (const Candidate& candidate : candidates) {
+            if (live <= threshold_bytes_) {
+                break;
+            }
+            const DatumNode& datum = mega_ag_.data.at(candidate.index);
+            victims.emplace_back(candidate.index, available_data_.at(candidate.index));
+            live -= std::min(live, estimate_datum_bytes(datum, n_));
+        }
+        return victims;
+    }
+
+    void prefetch_loop() {
+        while (true) {
+            NodeIndex index;
+            {
+                std::unique_lock<std::mutex> lock(prefetch_mutex_);
+                prefetch_cv_.wait(lock, [this] { return stop_ || !prefetch_queue_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                index = prefetch_queue_.front();
+                prefetch_queue_.pop_front();
+                prefetch_queued_.erase(index);
+            }
+            try {
+                restore(index, true);
+            } catch (...) {
+                // The datum stays spilled: the consumer reads it back itself, and its pool job stops the run with the
+                // error if that fails too
+            }
+        }
+    }
+
+    const MegaAG& mega_ag_;
+    const decltype(std::declval<TContext&>().get_parameter()) param_;
+    std::unordered_map<NodeIndex, std::any>& available_data_;
+    const std::set<NodeIndex>& queued_computes_;
+    std::mutex& mutex_;
+    LiveDataCounter& live_data_;
+    const uint64_t threshold_bytes_;
+    SpillFile file_;
+    SpillCounters own_counters_;
+    SpillCounters* counters_;
+    const uint64_t n_;
+
+    // Under the scheduler lock
+    std::unordered_set<NodeIndex> done_;
+    std::unordered_set<NodeIndex> restored_;
+    std::unordered_map<NodeIndex, std::shared_future<std::any>> restoring_;
+
+    std::atomic<bool> spilling_{false};
+
+    std::mutex prefetch_mutex_;
+    std::condition_variable prefetch_cv_;
+    std::deque<NodeIndex> prefetch_queue_;
+    std::unordered_set<NodeIndex> prefetch_queued_;
+    bool stop_ = false;
+    std::thread prefetcher_;
+};
+
+/**
+ * @brief Consistent state of a run, taken between two scheduler updates: the compute nodes completed so far and the
+ * intermediate data they left, which is all a later run needs to go on without them.
+ */
+struct RunSnapshot {
+    std::vector<NodeIndex> completed;  // Compute nodes completed by the pool jobs of the run
+    // Intermediate data not purged yet (neither task inputs, their ABI copies, nor outputs). Spilled data hold their
+    // serialized Bytes, and the data the checkpoint already holds (see RunTasksOptions::checkpoint_has_datum) no value.
+    std::unordered_map<NodeIndex, std::any> data;
+};
+
+/**
+ * @brief Optional behaviour of run_tasks() beyond plain graph execution.
+ */
+struct RunTasksOptions {
+    // Maximum number of ready CPU nodes of the same cheap op and output level (see can_coalesce()) that are run back
+    // to back in one pool job; 1 disables coalescing
+    size_t max_coalesce = 1;
+
+    // Run each ready CPU node together with the chain of sole consumers linked by ComputeNode::chain_next, as far as
+    // their other inputs are already available, in one pool job without publishing the intermediates
+    bool fuse_chains = false;
+
+    // Counter of the intermediate data produced by CPU tasks and not yet purged
+    LiveDataCounter* live_data = nullptr;
+
+    // Compute nodes that are not run, e.g. constant computes whose results the caller preloaded into available_data.
+    // They are left out of the task count and the progress total.
+    const std::unordered_set<NodeIndex>* skip_computes = nullptr;
+
+    // Called with the output datum and its value after each compute node stores its result, under the scheduler lock
+    std::function<void(const DatumNode&, const std::any&)> on_datum_stored;
+
+    // Run the ready compute nodes that produce task outputs (see produces_output()) ahead of all other nodes
+    bool prioritize_outputs = false;
+
+    // Called with each task output datum once its value is stored, from the worker thread that produced it and outside
+    // the scheduler lock. run_tasks() returns only after every call has returned. An exception thrown by the callback
+    // stops the run and is rethrown by run_tasks().
+    std::function<void(const DatumNode&)> on_output_ready;
+
+    // Set by the caller, possibly from another thread, to cancel the run
+    const std::atomic<bool>* cancelled = nullptr;
+
+    // Time after which the run is cancelled
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // The pool is shared with other runs (see CpuRuntime): wait for this run's own pool jobs only, not the whole pool
+    bool shared_pool = false;
+
+    // Pool priority of all CPU jobs of this run in place of their node priority, e.g. the priority of the run's tenant
+    // in a shared pool, where the node priorities of different graphs do not compare. Ready nodes still leave the
+    // run's own queue in node priority order.
+    std::optional<BS::priority_t> pool_priority;
+
+    // Asked before each dispatch with the number of this run's pool jobs queued or running; returning false holds the
+    // dispatch back until one of them finishes. Must return true when none is in flight.
+    std::function<bool(size_t)> may_dispatch;
+
+    // Called with the wall time of each pool job of this run, from the worker thread that ran it
+    std::function<void(std::chrono::nanoseconds)> on_job_finished;
+
+    // Spill idle intermediate ciphertexts to a scratch file while the live intermediate bytes exceed this threshold
+    // (see SpillTier); needs live_data. UINT64_MAX disables spilling.
+    uint64_t spill_threshold_bytes = UINT64_MAX;
+
+    // Directory of the scratch file, empty for /tmp
+    std::string spill_dir;
+
+    // Counters of the bytes spilled and read back, nullptr for none
+    SpillCounters* spill_counters = nullptr;
+
+    // Pass a snapshot of the run to on_checkpoint every checkpoint_interval, from the dispatcher thread, and once more
+    // before the intermediates are released if the run stops early; zero disables snapshots
+    std::chrono::milliseconds checkpoint_interval{0};
+    std::function<void(RunSnapshot&&)> on_checkpoint;
+
+    // Whether the checkpoint already holds a datum, nullptr for none; such data are listed in snapshots without value
+    std::function<bool(NodeIndex)> checkpoint_has_datum;
+
+    // Polled by the dispatcher thread for data produced elsewhere, e.g. by the other ranks of a distributed run (see
+    // RemoteExchange), whose producers are in skip_computes. Each datum returned is stored like a compute output. An
+    // exception thrown by it stops the run like an executor error.
+    std::function<std::vector<std::pair<NodeIndex, std::any>>()> take_remote_data;
+};
+
 /**
  * @brief Run tasks with CPU thread pool and optional backend task submission
  *
@@ -371,11 +961,22 @@ struct TaskInfo {
  *                                      data_ref_counts
  *                             If provided, total_tasks = all tasks; otherwise total_tasks = CPU tasks only
  *
+ * @param cleanup Optional callback invoked after all tasks complete
+ * @param progress_callback Optional progress callback
+ * @param options Coalescing, live data accounting, skipped computes, output priority, result hooks, cancellation,
+ *                pool sharing, spilling, snapshots and remote data (see RunTasksOptions)
+ * @return Number of compute nodes run
+ * @throws The first exception thrown by an executor
+ * @throws RunCancelledError if the run is cancelled or passes its deadline
+ *
+ * When an executor fails or the run is cancelled, no further compute nodes are dispatched. The nodes already running
+ * finish and the intermediate data are released before the exception is thrown.
+ *
  * @note If submit_backend_task is provided, this function handles GPU heterogeneous mode.
  *       Otherwise, it handles pure CPU or FPGA mode (only CPU tasks executed).
  */
 template <typename TContext>
-void run_tasks(const MegaAG& mega_ag,
+size_t run_tasks(const MegaAG& mega_ag,
                BS::priority_thread_pool& pool,
                const std::unique_ptr<TContext>& base_context,
                std::unordered_map<NodeIndex, std::any>& available_data,
@@ -390,18 +991,53 @@ void run_tasks(const MegaAG& mega_ag,
                                   std::mutex&,
                                   std::unordered_map<NodeIndex, std::atomic<int>>&)> submit_backend_task = nullptr,
                std::function<void()> cleanup = nullptr,
-               ProgressCallback progress_callback = nullptr) {
+               ProgressCallback progress_callback = nullptr,
+               const RunTasksOptions& options = RunTasksOptions()) {
     // Create thread-local contexts for CPU pool
     std::vector<std::unique_ptr<TContext>> context_ptrs = create_thread_contexts(pool, base_context);
 
     // Initialize reference counts for memory management
     std::unordered_map<NodeIndex, std::atomic<int>> data_ref_counts = get_data_ref_counts(mega_ag);
 
-    size_t task_count(mega_ag.computes.size());
+    // Skipped computes never consume their inputs, so release those references up front
+    const std::unordered_set<NodeIndex> no_skip;
+    const std::unordered_set<NodeIndex>& skip_computes = options.skip_computes ? *options.skip_computes : no_skip;
+    for (NodeIndex skipped : skip_computes) {
+        for (const auto* input_node : mega_ag.computes.at(skipped).input_nodes) {
+            data_ref_counts[input_node->index].fetch_sub(1);
+        }
+    }
+    auto is_skipped = [&skip_computes](NodeIndex index) { return skip_computes.count(index) != 0; };
+
+    LiveDataCounter* live_data = options.live_data;
+    const size_t max_coalesce = options.max_coalesce;
+
+    size_t task_count(mega_ag.computes.size() - skip_computes.size());
+
+    // Output-producing computes are lifted above the priority of every other compute when requested
+    std::unordered_set<NodeIndex> boosted_computes;
+    int output_boost = 0;
+    if (options.prioritize_outputs && !mega_ag.computes.empty()) {
+        auto [lowest, highest] = std::minmax_element(
+            mega_ag.computes.begin(), mega_ag.computes.end(),
+            [](const auto& a, const auto& b) { return a.second.priority < b.second.priority; });
+        output_boost = highest->second.priority - lowest->second.priority + 1;
+        for (const auto& [index, node] : mega_ag.computes) {
+            if (produces_output(node)) {
+                boosted_computes.insert(index);
+            }
+        }
+    }
+    auto priority_of = [&mega_ag, &boosted_computes, output_boost](NodeIndex index) {
+        int priority = mega_ag.computes.at(index).priority;
+        return boosted_computes.count(index) ? priority + output_boost : priority;
+    };
 
     // Progress bar for task completion tracking
     TaskProgressBar progress_bar(task_count);
 
+    const uint64_t n = mega_ag.parameter.value("n", uint64_t(0));
+
     // Task scheduling structures
     std::mutex m_mutex;
     std::atomic<size_t> total_tasks(task_count);
@@ -410,82 +1046,205 @@ void run_tasks(const MegaAG& mega_ag,
     std::mutex completion_mutex;
     std::priority_queue<TaskInfo> task_queue;
     std::set<NodeIndex> queued_computes;
+    std::vector<NodeIndex> completed_computes;  // Computes completed by pool jobs, for snapshots
+
+    // Set when an executor fails or the run is cancelled: pool jobs that have not started yet do nothing
+    std::atomic<bool> stop(false);
+    std::mutex error_mutex;
+    std::exception_ptr first_error;
+
+    // Keep the first error and stop the run, waking the dispatcher if it is waiting for the remaining tasks
+    auto record_error = [&stop, &error_mutex, &first_error, &completion_mutex,
+                         &completion_cv](std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!first_error) {
+                first_error = error;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(completion_mutex);
+            stop.store(true);
+        }
+        completion_cv.notify_all();
+    };
+
+    PoolJobCounter pool_jobs;
+
+    // Spill tier; joins its prefetch thread before the state above goes away
+    std::unique_ptr<SpillTier<TContext>> spill;
+    if (options.spill_threshold_bytes != UINT64_MAX && live_data) {
+        spill = std::make_unique<SpillTier<TContext>>(mega_ag, *base_context, available_data, queued_computes, m_mutex,
+                                                      *live_data, options.spill_threshold_bytes, options.spill_dir,
+                                                      options.spill_counters);
+    }
 
     // Progress callback throttle state (best-effort, no mutex)
     using SteadyClock = std::chrono::steady_clock;
     std::atomic<SteadyClock::rep> last_progress_time{0};
     constexpr auto progress_interval = std::chrono::milliseconds(100);
 
-    // Define CPU task submission function
-    std::function<void(NodeIndex, const std::vector<std::any>&)> submit_task =
-        [&](NodeIndex task_index, const std::vector<std::any>& other_args) {
-            const BS::priority_t pool_priority = mega_ag.computes.at(task_index).priority;
-            pool.detach_task(
-                [task_index, &mega_ag, &completed_tasks, &total_tasks, &m_mutex, &completion_mutex, &completion_cv,
-                 &available_data, &context_ptrs, &task_queue, &queued_computes, &data_ref_counts, other_args,
-                 &progress_callback, &last_progress_time, progress_interval]() {
+    // Define CPU task submission function. A group is a single compute node, or several coalesced nodes that run
+    // back to back in one pool job on the same thread context, each possibly followed by its fused chain. A node
+    // continues the chain of the node before it if it is that node's chain_next.
+    std::function<void(const std::vector<NodeIndex>&, const std::vector<std::vector<std::any>>&)> submit_task =
+        [&](const std::vector<NodeIndex>& group, const std::vector<std::vector<std::any>>& group_other_args) {
+            const BS::priority_t pool_priority = options.pool_priority.value_or(priority_of(group.front()));
+            auto job =
+                [group, &mega_ag, &completed_tasks, &total_tasks, &m_mutex, &completion_mutex, &completion_cv,
+                 &available_data, &context_ptrs, &task_queue, &queued_computes, &data_ref_counts, group_other_args,
+                 &progress_callback, &last_progress_time, progress_interval, live_data, n, &options, is_skipped,
+                 priority_of, &stop, &record_error, &spill, &completed_computes]() {
+                    if (stop.load()) {
+                        return;
+                    }
                     auto thread_id = BS::this_thread::get_index().value();
 
-                    const ComputeNode& compute_node = mega_ag.computes.at(task_index);
-                    const std::vector<DatumNode*>& compute_input_nodes = compute_node.input_nodes;
-                    const DatumNode* compute_output_node = compute_node.output_nodes[0];
+                    // Intermediate passed from group[k - 1] to group[k] within a fused chain, if any
+                    std::vector<const DatumNode*> chained_input(group.size(), nullptr);
+                    for (size_t k = 1; k < group.size(); k++) {
+                        const ComputeNode& prev = mega_ag.computes.at(group[k - 1]);
+                        if (prev.chain_next == &mega_ag.computes.at(group[k])) {
+                            chained_input[k] = prev.output_nodes[0];
+                        }
+                    }
 
                     // Cache input data for this thread
-                    std::unordered_map<NodeIndex, std::any> thread_input_cache;
+                    std::vector<std::unordered_map<NodeIndex, std::any>> thread_input_caches(group.size());
                     {
                         std::lock_guard<std::mutex> lock(m_mutex);
 
-                        for (const auto* input_node : compute_input_nodes) {
-                            thread_input_cache[input_node->index] = available_data.at(input_node->index);
+                        for (size_t k = 0; k < group.size(); k++) {
+                            for (const auto* input_node : mega_ag.computes.at(group[k]).input_nodes) {
+                                if (input_node != chained_input[k]) {
+                                    thread_input_caches[k][input_node->index] = available_data.at(input_node->index);
+                                }
+                            }
+                        }
+                    }
+
+                    // Read back the inputs that are still spilled
+                    if (spill) {
+                        for (auto& cache : thread_input_caches) {
+                            for (auto& [index, value] : cache) {
+                                if (SpillTier<TContext>::is_spilled(value)) {
+                                    value = spill->restore(index, false);
+                                }
+                            }
                         }
                     }
 
                     // Prepare execution context
                     ExecutionContext exec_ctx;
                     exec_ctx.context = context_ptrs[thread_id].get();
-                    exec_ctx.other_args = other_args;
 
-                    // Execute the compute node using its bound executor
-                    std::any output;
-                    try {
-                        compute_node.executor(exec_ctx, thread_input_cache, output, compute_node);
-                    } catch (const std::exception& e) {
-                        // Still increment completed_tasks to avoid deadlock
-                        if (completed_tasks.fetch_add(1) + 1 >= total_tasks) {
-                            std::lock_guard<std::mutex> lock(completion_mutex);
-                            completion_cv.notify_all();
+                    // Execute the compute nodes using their bound executors
+                    std::vector<std::any> outputs(group.size());
+                    std::vector<bool> succeeded(group.size(), false);
+                    for (size_t k = 0; k < group.size(); k++) {
+                        const ComputeNode& compute_node = mega_ag.computes.at(group[k]);
+                        if (chained_input[k]) {
+                            if (!succeeded[k - 1]) {
+                                continue;
+                            }
+                            thread_input_caches[k][chained_input[k]->index] = outputs[k - 1];
+                        }
+                        exec_ctx.other_args = group_other_args[k];
+                        try {
+                            compute_node.executor(exec_ctx, thread_input_caches[k], outputs[k], compute_node);
+                            succeeded[k] = true;
+                        } catch (...) {
+                            // The rest of the group is not run
+                            record_error(std::current_exception());
+                            break;
                         }
-                        return;
                     }
 
-                    // Determine where to store the output
-                    NodeIndex output_index = compute_output_node->index;
-
                     // Update results and find newly available tasks
                     {
                         std::lock_guard<std::mutex> lock(m_mutex);
 
-                        // Store the output
-                        available_data[output_index] = output;
+                        for (size_t k = 0; k < group.size(); k++) {
+                            if (!succeeded[k]) {
+                                continue;
+                            }
+                            const ComputeNode& compute_node = mega_ag.computes.at(group[k]);
+                            const DatumNode* compute_output_node = compute_node.output_nodes[0];
+                            bool passed_on = k + 1 < group.size() && chained_input[k + 1] == compute_output_node;
+                            completed_computes.push_back(group[k]);
+
+                            // Store the output, unless it was only passed on to the next node of a fused chain
+                            if (!passed_on) {
+                                available_data[compute_output_node->index] = outputs[k];
+                                if (live_data && !compute_output_node->is_input && !compute_output_node->is_output &&
+                                    !is_input_alias(*compute_output_node)) {
+                                    live_data->add(estimate_datum_bytes(*compute_output_node, n));
+                                }
+                            }
+                            if (options.on_datum_stored) {
+                                options.on_datum_stored(*compute_output_node, outputs[k]);
+                            }
+
+                            // A datum that no compute of this run reads is released once the hook has seen it
+                            if (!passed_on && data_ref_counts[compute_output_node->index].load() <= 0 &&
+                                !compute_output_node->is_input && !compute_output_node->is_output) {
+                                available_data.erase(compute_output_node->index);
+                                if (live_data && !is_input_alias(*compute_output_node)) {
+                                    live_data->sub(estimate_datum_bytes(*compute_output_node, n));
+                                }
+                            }
+                            if (spill) {
+                                spill->note_done(group[k]);
+                                if (!passed_on) {
+                                    spill->prefetch_consumer_inputs(*compute_output_node);
+                                }
+                            }
+
+                            // Clean up unreferenced data
+                            mega_ag.purge_unused_data(compute_node, data_ref_counts, available_data);
+                            if (live_data) {
+                                for (const auto* input_node : compute_node.input_nodes) {
+                                    if (input_node != chained_input[k] && !input_node->is_input &&
+                                        !input_node->is_output && !is_input_alias(*input_node) &&
+                                        available_data.find(input_node->index) == available_data.end()) {
+                                        live_data->sub(estimate_datum_bytes(*input_node, n));
+                                    }
+                                }
+                            }
+                            if (passed_on) {
+                                continue;
+                            }
 
-                        // Clean up unreferenced data
-                        mega_ag.purge_unused_data(compute_node, data_ref_counts, available_data);
+                            // Find newly available computes
+                            std::unordered_set<NodeIndex> newly_available_computes =
+                                mega_ag.step_available_computes(*compute_output_node, available_data);
 
-                        // Find newly available computes
-                        std::unordered_set<NodeIndex> newly_available_computes =
-                            mega_ag.step_available_computes(*compute_output_node, available_data);
+                            for (const auto& new_task_index : newly_available_computes) {
+                                if (!is_skipped(new_task_index) &&
+                                    queued_computes.find(new_task_index) == queued_computes.end()) {
+                                    task_queue.push({priority_of(new_task_index), new_task_index});
+                                    queued_computes.insert(new_task_index);
+                                }
+                            }
+                        }
+                    }
+
+                    if (spill) {
+                        spill->relieve_pressure();
+                    }
 
-                        for (const auto& new_task_index : newly_available_computes) {
-                            if (queued_computes.find(new_task_index) == queued_computes.end()) {
-                                int pri = mega_ag.computes.at(new_task_index).priority;
-                                task_queue.push({pri, new_task_index});
-                                queued_computes.insert(new_task_index);
+                    // Report the task outputs stored above. Output data are never passed along a fused chain.
+                    if (options.on_output_ready) {
+                        for (size_t k = 0; k < group.size(); k++) {
+                            const DatumNode* output_node = mega_ag.computes.at(group[k]).output_nodes[0];
+                            if (succeeded[k] && output_node->is_output) {
+                                options.on_output_ready(*output_node);
                             }
                         }
                     }
 
                     // Check if all tasks are completed
-                    size_t prev = completed_tasks.fetch_add(1);
+                    size_t prev = completed_tasks.fetch_add(group.size()) + group.size() - 1;
                     if (progress_callback) {
                         auto now = SteadyClock::now().time_since_epoch().count();
                         auto last = last_progress_time.load(std::memory_order_relaxed);
@@ -501,22 +1260,129 @@ void run_tasks(const MegaAG& mega_ag,
                         std::lock_guard<std::mutex> lock(completion_mutex);
                         completion_cv.notify_all();
                     }
+                };
+            pool_jobs.add();
+            pool.detach_task(
+                [job = std::move(job), &pool_jobs, &options, &record_error]() {
+                    PoolJobCounter::Scope in_flight{pool_jobs};
+                    auto job_start = SteadyClock::now();
+                    // Not only executors throw: spill read backs, the result hooks and the scheduler bookkeeping may
+                    // too, and the pool would swallow the exception and leave the run waiting for the job
+                    try {
+                        job();
+                    } catch (...) {
+                        record_error(std::current_exception());
+                    }
+                    if (options.on_job_finished) {
+                        try {
+                            options.on_job_finished(SteadyClock::now() - job_start);
+                        } catch (...) {
+                            record_error(std::current_exception());
+                        }
+                    }
                 },
                 pool_priority);
         };
 
+    auto can_fuse_next = [&](const ComputeNode& node) {
+        const ComputeNode* next = node.chain_next;
+        if (!next || is_skipped(next->index) || queued_computes.count(next->index)) {
+            return false;
+        }
+        return std::all_of(next->input_nodes.begin(), next->input_nodes.end(), [&](const DatumNode* input) {
+            return input == node.output_nodes[0] || available_data.count(input->index);
+        });
+    };
+
     // Get initial available computes and initialize task queue
     std::unordered_set<NodeIndex> available_computes = mega_ag.get_available_computes(available_data);
     for (const auto& task_index : available_computes) {
-        int pri = mega_ag.computes.at(task_index).priority;
-        task_queue.push({pri, task_index});
+        if (is_skipped(task_index)) {
+            continue;
+        }
+        task_queue.push({priority_of(task_index), task_index});
         queued_computes.insert(task_index);
     }
 
+    auto check_cancelled = [&options]() {
+        return (options.cancelled && options.cancelled->load()) ||
+               (options.deadline != SteadyClock::time_point::max() && SteadyClock::now() >= options.deadline);
+    };
+
+    // Snapshot of the run for checkpoints
+    const bool take_snapshots = options.checkpoint_interval.count() > 0 && options.on_checkpoint;
+    auto take_snapshot = [&]() {
+        RunSnapshot snapshot;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        snapshot.completed = completed_computes;
+        for (const auto& [index, value] : available_data) {
+            const DatumNode& datum = mega_ag.data.at(index);
+            if (datum.is_input || datum.is_output || is_input_alias(datum)) {
+                continue;
+            }
+            std::any& entry = snapshot.data[index];
+            if (options.checkpoint_has_datum && options.checkpoint_has_datum(index)) {
+                continue;
+            }
+            entry = spill && SpillTier<TContext>::is_spilled(value) ? std::any(spill->read_spilled(index)) : value;
+        }
+        return snapshot;
+    };
+    auto next_snapshot = SteadyClock::now() + options.checkpoint_interval;
+
     // Main task dispatcher loop
     while (true) {
+        if (stop.load() || (completed_tasks.load() < total_tasks && check_cancelled())) {
+            stop.store(true);
+            break;
+        }
+
+        // Store the data produced elsewhere and queue the computes they make ready
+        if (options.take_remote_data) {
+            std::vector<std::pair<NodeIndex, std::any>> arrived;
+            try {
+                arrived = options.take_remote_data();
+            } catch (...) {
+                record_error(std::current_exception());
+                break;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& [index, value] : arrived) {
+                const DatumNode& datum = mega_ag.data.at(index);
+                available_data[index] = std::move(value);
+                if (live_data && !datum.is_input && !datum.is_output && !is_input_alias(datum)) {
+                    live_data->add(estimate_datum_bytes(datum, n));
+                }
+                for (NodeIndex ready : mega_ag.step_available_computes(datum, available_data)) {
+                    if (!is_skipped(ready) && queued_computes.insert(ready).second) {
+                        task_queue.push({priority_of(ready), ready});
+                    }
+                }
+            }
+        }
+
+        if (take_snapshots && SteadyClock::now() >= next_snapshot) {
+            try {
+                options.on_checkpoint(take_snapshot());
+            } catch (...) {
+                record_error(std::current_exception());
+                break;
+            }
+            next_snapshot = SteadyClock::now() + options.checkpoint_interval;
+        }
+
+        // Hold back while the run has its share of the pool in flight
+        if (options.may_dispatch) {
+            size_t in_flight = pool_jobs.count();
+            if (!options.may_dispatch(in_flight)) {
+                pool_jobs.wait_below(in_flight, std::chrono::milliseconds(1));
+                continue;
+            }
+        }
+
         NodeIndex next_task;
         bool has_task = false;
+        std::vector<NodeIndex> group;
 
         {
             std::lock_guard<std::mutex> lock(m_mutex);
@@ -524,6 +1390,35 @@ void run_tasks(const MegaAG& mega_ag,
                 next_task = task_queue.top().index;
                 task_queue.pop();
                 has_task = true;
+
+                // Coalesce the following ready nodes of the same cheap op and level into one pool job
+                group.push_back(next_task);
+                const ComputeNode& head = mega_ag.computes.at(next_task);
+                if (max_coalesce > 1 && head.on_cpu && is_coalescable(head)) {
+                    while (group.size() < max_coalesce && !task_queue.empty()) {
+                        const ComputeNode& candidate = mega_ag.computes.at(task_queue.top().index);
+                        if (!candidate.on_cpu || !can_coalesce(head, candidate)) {
+                            break;
+                        }
+                        group.push_back(task_queue.top().index);
+                        task_queue.pop();
+                    }
+                }
+
+                // Append to each node the chain of sole consumers whose other inputs are already available
+                if (options.fuse_chains && head.on_cpu) {
+                    std::vector<NodeIndex> fused;
+                    for (NodeIndex index : group) {
+                        fused.push_back(index);
+                        const ComputeNode* node = &mega_ag.computes.at(index);
+                        while (can_fuse_next(*node)) {
+                            node = node->chain_next;
+                            fused.push_back(node->index);
+                            queued_computes.insert(node->index);
+                        }
+                    }
+                    group = std::move(fused);
+                }
             }
         }
 
@@ -533,11 +1428,13 @@ void run_tasks(const MegaAG& mega_ag,
             const ComputeNode& compute_node = mega_ag.computes.at(next_task);
             if (compute_node.on_cpu) {
                 // Submit to CPU thread pool
-                std::vector<std::any> other_args_vec;
+                std::vector<std::vector<std::any>> group_other_args(group.size());
                 if (get_other_args) {
-                    other_args_vec = get_other_args(compute_node);
+                    for (size_t k = 0; k < group.size(); k++) {
+                        group_other_args[k] = get_other_args(mega_ag.computes.at(group[k]));
+                    }
                 }
-                submit_task(next_task, other_args_vec);
+                submit_task(group, group_other_args);
             } else if (submit_backend_task) {
                 // Submit to backend handler (GPU/FPGA) with shared state references
                 submit_backend_task(next_task, m_mutex, task_queue, queued_computes, completed_tasks, total_tasks,
@@ -552,13 +1449,22 @@ void run_tasks(const MegaAG& mega_ag,
         }
     }
 
-    // Wait for all tasks to complete
-    {
+    // Wait for all tasks to complete, or only for the running ones if the run stopped
+    if (!stop.load()) {
         std::unique_lock<std::mutex> lock(completion_mutex);
-        completion_cv.wait(lock, [&] { return completed_tasks.load() >= total_tasks; });
+        completion_cv.wait(lock, [&] { return completed_tasks.load() >= total_tasks || stop.load(); });
+    }
+
+    // A pool of the run's own may also hold backend jobs (FPGA) besides the CPU jobs counted here
+    pool_jobs.wait_idle();
+    if (!options.shared_pool) {
+        pool.wait();
     }
 
-    pool.wait();
+    // No read back may store a datum once the run is over, nor after the intermediates are released below
+    if (spill) {
+        spill->stop_prefetch();
+    }
 
     progress_bar.finalize();
 
@@ -566,4 +1472,26 @@ void run_tasks(const MegaAG& mega_ag,
     if (cleanup) {
         cleanup();
     }
+
+    if (stop.load()) {
+        if (take_snapshots) {
+            try {
+                options.on_checkpoint(take_snapshot());
+            } catch (...) {
+                record_error(std::current_exception());
+            }
+        }
+
+        // Release the intermediates of the abandoned run; inputs and outputs belong to the caller
+        for (auto it = available_data.begin(); it != available_data.end();) {
+            const DatumNode& datum = mega_ag.data.at(it->first);
+            it = datum.is_input || datum.is_output ? std::next(it) : available_data.erase(it);
+        }
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+        throw RunCancelledError("Task run was cancelled");
+    }
+
+    return task_count;
 }
@@ -0,0 +1,339 @@
+// Copyright (c) 2025-2026 CipherFlow (Shenzhen) Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Message between the processes (ranks) of a distributed run: a serialized datum of one run, or the notice
+ * that the sender abandoned the run.
+ */
+struct TransportMessage {
+    static constexpr uint64_t abort_index = UINT64_MAX;
+
+    uint32_t from = 0;             // Rank of the sender
+    uint64_t run = 0;              // Sequence number of the run, the same on every rank
+    uint64_t index = 0;            // Node index of the datum, or abort_index
+    std::vector<uint8_t> payload;  // Serialized datum
+};
+
+/**
+ * @brief Message passing between the ranks of a distributed run (see RemoteExchange). Implementations must deliver
+ * the messages from one rank to another in the order they were sent, and be callable from several threads.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // Rank of this process, in [0, size())
+    virtual uint32_t rank() const = 0;
+
+    // Number of ranks
+    virtual uint32_t size() const = 0;
+
+    // Send a message to rank `to`
+    // @throws std::runtime_error if the rank cannot be reached
+    virtual void send(uint32_t to, const TransportMessage& message) = 0;
+
+    // Wait at most `timeout` for the next message of run `run`. Messages of later runs are kept until those runs ask
+    // for them, and those of earlier runs are dropped.
+    virtual std::optional<TransportMessage> receive(uint64_t run, std::chrono::milliseconds timeout) = 0;
+
+    // Whether rank `peer` was connected and has disconnected; the messages it sent before are still delivered
+    virtual bool peer_lost(uint32_t peer) const = 0;
+};
+
+// ---------------------------------------------------------------------------
+// UnixSocketTransport: Transport between the processes of one host over Unix
+// domain stream sockets. Rank r listens on <dir>/lattisense_rank_<r>.sock and
+// sends to each peer over a connection of its own, opened on the first send
+// and retried until the peer listens. A background thread reads the incoming
+// connections into an inbox.
+//
+// Frame: rank of the sender (u32, once per connection), then for each
+// message its run (u64), index (u64), payload size (u64) and payload.
+// ---------------------------------------------------------------------------
+class UnixSocketTransport : public Transport {
+public:
+    // @throws std::runtime_error if the socket of this rank cannot be created in `dir` (created if missing)
+    UnixSocketTransport(const std::string& dir,
+                        uint32_t rank,
+                        uint32_t size,
+                        std::chrono::milliseconds connect_timeout = std::chrono::seconds(30))
+        : dir_(dir.empty() ? "/tmp" : dir), rank_(rank), size_(size), connect_timeout_(connect_timeout),
+          send_fds_(size, -1), send_mutexes_(size), lost_(size, false) {
+        if (rank >= size) {
+            throw std::invalid_argument("Rank " + std::to_string(rank) + " is out of range");
+        }
+        mkdir(dir_.c_str(), 0700);
+        sockaddr_un addr = address_of(rank_);
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error("Failed to create socket");
+        }
+        unlink(addr.sun_path);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 64) != 0) {
+            close(listen_fd_);
+            throw std::runtime_error(std::string("Failed to listen on ") + addr.sun_path);
+        }
+        if (pipe(wake_fds_) != 0) {
+            close(listen_fd_);
+            unlink(addr.sun_path);
+            throw std::runtime_error("Failed to create pipe");
+        }
+        receiver_ = std::thread([this]() { receive_loop(); });
+    }
+
+    UnixSocketTransport(const UnixSocketTransport&) = delete;
+    UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+
+    ~UnixSocketTransport() override {
+        char byte = 0;
+        (void)!write(wake_fds_[1], &byte, 1);
+        receiver_.join();
+        for (int fd : send_fds_) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        close(listen_fd_);
+        close(wake_fds_[0]);
+        close(wake_fds_[1]);
+        unlink(address_of(rank_).sun_path);
+    }
+
+    uint32_t rank() const override {
+        return rank_;
+    }
+
+    uint32_t size() const override {
+        return size_;
+    }
+
+    void send(uint32_t to, const TransportMessage& message) override {
+        std::lock_guard<std::mutex> lock(send_mutexes_[to]);
+        if (send_fds_[to] < 0) {
+            send_fds_[to] = connect_to(to);
+        }
+        uint64_t header[3] = {message.run, message.index, message.payload.size()};
+        if (!write_all(send_fds_[to], header, sizeof(header)) ||
+            !write_all(send_fds_[to], message.payload.data(), message.payload.size())) {
+            close(send_fds_[to]);
+            send_fds_[to] = -1;
+            throw std::runtime_error("Failed to send to rank " + std::to_string(to));
+        }
+    }
+
+    std::optional<TransportMessage> receive(uint64_t run, std::chrono::milliseconds timeout) override {
+        std::unique_lock<std::mutex> lock(inbox_mutex_);
+        std::optional<TransportMessage> message;
+        inbox_cv_.wait_for(lock, timeout, [&] {
+            for (auto it = inbox_.begin(); it != inbox_.end();) {
+                if (it->run < run) {
+                    it = inbox_.erase(it);
+                } else if (it->run == run) {
+                    message = std::move(*it);
+                    inbox_.erase(it);
+                    return true;
+                } else {
+                    ++it;
+                }
+            }
+            return false;
+        });
+        return message;
+    }
+
+    bool peer_lost(uint32_t peer) const override {
+        std::lock_guard<std::mutex> lock(inbox_mutex_);
+        return lost_[peer];
+    }
+
+private:
+    sockaddr_un address_of(uint32_t rank) const {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::string path = dir_ + "/lattisense_rank_" + std::to_string(rank) + ".sock";
+        if (path.size() >= sizeof(addr.sun_path)) {
+            throw std::invalid_argument("Socket path is too long: " + path);
+        }
+        std::strcpy(addr.sun_path, path.c_str());
+        return addr;
+    }
+
+    int connect_to(uint32_t peer) const {
+        sockaddr_un addr = address_of(peer);
+        auto deadline = std::chrono::steady_clock::now() + connect_timeout_;
+        while (true) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) {
+                throw std::runtime_error("Failed to create socket");
+            }
+            if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+                if (write_all(fd, &rank_, sizeof(rank_))) {
+                    return fd;
+                }
+            }
+            close(fd);
+            if (std::chrono::steady_clock::now() >= deadline) {
+                throw std::runtime_error("Failed to connect to rank " + std::to_string(peer) + " at " + addr.sun_path);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    static bool write_all(int fd, const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        while (size > 0) {
+            ssize_t written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                return false;
+            }
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    static bool read_all(int fd, void* data, size_t size) {
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+        while (size > 0) {
+            ssize_t n_read = read(fd, bytes, size);
+            if (n_read < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n_read <= 0) {
+                return false;
+            }
+            bytes += n_read;
+            size -= n_read;
+        }
+        return true;
+    }
+
+    // Accept connections and read one whole message from each readable one, until woken through the pipe
+    void receive_loop() {
+        std::vector<int> fds;                        // Accepted connections
+        std::unordered_map<int, uint32_t> peer_of;  // Rank of each connection that has identified itself
+        while (true) {
+            std::vector<pollfd> polled = {{wake_fds_[0], POLLIN, 0}, {listen_fd_, POLLIN, 0}};
+            for (int fd : fds) {
+                polled.push_back({fd, POLLIN, 0});
+            }
+            if (poll(polled.data(), polled.size(), -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (polled[0].revents) {
+                break;
+            }
+            if (polled[1].revents & POLLIN) {
+                int fd = accept(listen_fd_, nullptr, nullptr);
+                if (fd >= 0) {
+                    fds.push_back(fd);
+                }
+            }
+            for (size_t i = 2; i < polled.size(); i++) {
+                if (!polled[i].revents) {
+                    continue;
+                }
+                int fd = polled[i].fd;
+                bool ok;
+                auto peer = peer_of.find(fd);
+                if (peer == peer_of.end()) {
+                    uint32_t from;
+                    ok = read_all(fd, &from, sizeof(from)) && from < size_;
+                    if (ok) {
+                        peer_of[fd] = from;
+                        std::lock_guard<std::mutex> lock(inbox_mutex_);
+                        lost_[from] = false;
+                    }
+                } else {
+                    uint64_t header[3];
+                    TransportMessage message;
+                    message.from = peer->second;
+                    ok = read_all(fd, header, sizeof(header));
+                    if (ok) {
+                        message.run = header[0];
+                        message.index = header[1];
+                        message.payload.resize(header[2]);
+                        ok = read_all(fd, message.payload.data(), header[2]);
+                    }
+                    if (ok) {
+                        std::lock_guard<std::mutex> lock(inbox_mutex_);
+                        inbox_.push_back(std::move(message));
+                        inbox_cv_.notify_all();
+                    }
+                }
+                if (!ok) {
+                    std::lock_guard<std::mutex> lock(inbox_mutex_);
+                    if (peer != peer_of.end()) {
+                        lost_[peer->second] = true;
+                        peer_of.erase(peer);
+                    }
+                    inbox_cv_.notify_all();
+                    close(fd);
+                    fds.erase(std::find(fds.begin(), fds.end(), fd));
+                }
+            }
+        }
+        for (int fd : fds) {
+            close(fd);
+        }
+    }
+
+    const std::string dir_;
+    const uint32_t rank_;
+    const uint32_t size_;
+    const std::chrono::milliseconds connect_timeout_;
+    int listen_fd_ = -1;
+    int wake_fds_[2] = {-1, -1};
+
+    std::vector<int> send_fds_;  // Connection to each peer, -1 until the first send
+    std::vector<std::mutex> send_mutexes_;
+
+    mutable std::mutex inbox_mutex_;
+    std::condition_variable inbox_cv_;
+    std::deque<TransportMessage> inbox_;
+    std::vector<bool> lost_;
+
+    std::thread receiver_;
+};
@@ -257,11 +257,15 @@ void _run_mega_ag_impl(gsl::span<CArgument> input_args,
                         int level = c_struct_node->fhe_prop->level;
 
                         auto* c_ct = (CCiphertext*)malloc(sizeof(CCiphertext));
-                        alloc_ciphertext(c_ct, degree, level, n);
+                        alloc_ciphertext_contiguous(c_ct, degree, level, n);
+                        if (!c_ct->polys) {
+                            free(c_ct);
+                            throw std::bad_alloc();
+                        }
                         export_ct_pointers(c_ct, proj->pvo, offset, false);
 
                         available_data[c_struct_node->index] = std::shared_ptr<CCiphertext>(c_ct, [](CCiphertext* p) {
-                            free_ciphertext(p);
+                            free_ciphertext_contiguous(p);
                             free(p);
                         });
 
@@ -60,6 +60,11 @@ inline void CHECK(cudaError_t err) {
 template <heongpu::Scheme SchemeType>
 void export_plaintext(const CPlaintext& src, heongpu::Plaintext<SchemeType>& dest) {
     int N = src.poly.components->n;
+    if (const uint64_t* data = plaintext_contiguous_data(&src)) {
+        CHECK(cudaMemcpyAsync(dest.data(), data, src.poly.n_component * N * sizeof(uint64_t), cudaMemcpyHostToDevice,
+                              dest.stream()));
+        return;
+    }
     for (int i = 0; i < src.poly.n_component; i++) {
         CHECK(cudaMemcpyAsync(&(dest.data()[i * N]), src.poly.components[i].data, N * sizeof(uint64_t),
                               cudaMemcpyHostToDevice, dest.stream()));
@@ -73,6 +78,12 @@ template <heongpu::Scheme SchemeType>
 void export_ciphertext(const CCiphertext& src, heongpu::Ciphertext<SchemeType>& dest) {
     int N = src.polys->components->n;
     int n_component = src.polys->n_component;
+    // The contiguous layout matches the device layout, polynomial by polynomial
+    if (const uint64_t* data = ciphertext_contiguous_data(&src)) {
+        CHECK(cudaMemcpyAsync(dest.data(), data, (src.degree + 1) * n_component * N * sizeof(uint64_t),
+                              cudaMemcpyHostToDevice, dest.stream()));
+        return;
+    }
     for (int i = 0; i < src.degree + 1; i++) {
         for (int j = 0; j < n_component; j++) {
             CHECK(cudaMemcpyAsync(&(dest.data()[i * n_component * N + j * N]), src.polys[i].components[j].data,
@@ -82,31 +93,64 @@ void export_ciphertext(const CCiphertext& src, heongpu::Ciphertext<SchemeType>&
 }
 
 /**
- * @brief Export relinearization key from C struct to GPU device memory
+ * @brief Export one key switch key from C struct to GPU device memory at dest
+ *
+ * On the device each polynomial of a public key spans first_Qprime_size components, the Q part of the key from 0 and
+ * its P part from first_Q_size. A contiguous key at the top level has that layout and takes one memcpy; a contiguous
+ * key at a lower level takes one per Q part and one per P part of each polynomial.
  */
-template <heongpu::Scheme SchemeType>
-void export_relin_key(const CRelinKey& src,
-                      heongpu::Relinkey<SchemeType>& dest,
-                      int first_Q_size,
-                      int first_Qprime_size) {
+template <typename Word>
+void export_key_switch_key(const ::CKeySwitchKey& src,
+                           Word* dest,
+                           cudaStream_t stream,
+                           int first_Q_size,
+                           int first_Qprime_size) {
     int N = src.public_keys->polys->components->n;
     int n_public_key = src.n_public_key;
     int level = src.public_keys->level;
     int n_component = src.public_keys->polys->n_component;
+    size_t dest_poly_size = (size_t)first_Qprime_size * N;
 
+    if (const uint64_t* data = key_switch_key_contiguous_data(&src)) {
+        if (level + 1 == first_Q_size && n_component == first_Qprime_size) {
+            CHECK(cudaMemcpyAsync(dest, data, 2 * n_public_key * dest_poly_size * sizeof(uint64_t),
+                                  cudaMemcpyHostToDevice, stream));
+            return;
+        }
+        for (int i = 0; i < 2 * n_public_key; i++) {
+            const uint64_t* poly = data + (size_t)i * n_component * N;
+            Word* dest_poly = dest + i * dest_poly_size;
+            CHECK(cudaMemcpyAsync(dest_poly, poly, (size_t)(level + 1) * N * sizeof(uint64_t), cudaMemcpyHostToDevice,
+                                  stream));
+            CHECK(cudaMemcpyAsync(dest_poly + (size_t)first_Q_size * N, poly + (size_t)(level + 1) * N,
+                                  (size_t)(n_component - level - 1) * N * sizeof(uint64_t), cudaMemcpyHostToDevice,
+                                  stream));
+        }
+        return;
+    }
     for (int i = 0; i < n_public_key; i++) {
         for (int j = 0; j < 2; j++) {
             for (int k = 0; k < n_component; k++) {
                 int k_ = (k < level + 1) ? k : k - (level + 1) + first_Q_size;
-                CHECK(
-                    cudaMemcpyAsync(&(dest.data()[i * 2 * first_Qprime_size * N + j * first_Qprime_size * N + k_ * N]),
-                                    src.public_keys[i].polys[j].components[k].data, N * sizeof(uint64_t),
-                                    cudaMemcpyHostToDevice, dest.stream()));
+                CHECK(cudaMemcpyAsync(&(dest[i * 2 * dest_poly_size + j * dest_poly_size + k_ * N]),
+                                      src.public_keys[i].polys[j].components[k].data, N * sizeof(uint64_t),
+                                      cudaMemcpyHostToDevice, stream));
             }
         }
     }
 }
 
+/**
+ * @brief Export relinearization key from C struct to GPU device memory
+ */
+template <heongpu::Scheme SchemeType>
+void export_relin_key(const CRelinKey& src,
+                      heongpu::Relinkey<SchemeType>& dest,
+                      int first_Q_size,
+                      int first_Qprime_size) {
+    export_key_switch_key(src, dest.data(), dest.stream(), first_Q_size, first_Qprime_size);
+}
+
 /**
  * @brief Export Galois key from C struct to GPU device memory (specific galois element)
  */
@@ -117,35 +161,13 @@ void export_galois_key(const CGaloisKey& src,
                        int first_Q_size,
                        int first_Qprime_size) {
     int N = src.key_switch_keys->public_keys->polys->components->n;
-    int n_public_key = src.key_switch_keys->n_public_key;
-    int level = src.key_switch_keys->public_keys->level;
-    int n_component = src.key_switch_keys->public_keys->polys->n_component;
-    int n_key_switch_key = src.n_key_switch_key;
 
-    for (int i = 0; i < n_key_switch_key; i++) {
+    for (int i = 0; i < src.n_key_switch_key; i++) {
         if (src.galois_elements[i] != galois_element) {
             continue;
         }
-
-        for (int j = 0; j < n_public_key; j++) {
-            for (int k = 0; k < 2; k++) {
-                for (int l = 0; l < n_component; l++) {
-                    int l_ = (l < level + 1) ? l : l - (level + 1) + first_Q_size;
-                    if (galois_element != 2 * N - 1) {
-                        CHECK(cudaMemcpyAsync(
-                            &(dest.data(
-                                galois_element)[j * 2 * first_Qprime_size * N + k * first_Qprime_size * N + l_ * N]),
-                            src.key_switch_keys[i].public_keys[j].polys[k].components[l].data, N * sizeof(uint64_t),
-                            cudaMemcpyHostToDevice, dest.stream()));
-                    } else {
-                        CHECK(cudaMemcpyAsync(
-                            &(dest.c_data()[j * 2 * first_Qprime_size * N + k * first_Qprime_size * N + l_ * N]),
-                            src.key_switch_keys[i].public_keys[j].polys[k].components[l].data, N * sizeof(uint64_t),
-                            cudaMemcpyHostToDevice, dest.stream()));
-                    }
-                }
-            }
-        }
+        auto* dest_data = (galois_element != 2 * N - 1) ? dest.data(galois_element) : dest.c_data();
+        export_key_switch_key(src.key_switch_keys[i], dest_data, dest.stream(), first_Q_size, first_Qprime_size);
     }
 }
 
@@ -157,22 +179,7 @@ void export_switching_key(const ::CKeySwitchKey& src,
                           heongpu::Switchkey<SchemeType>& dest,
                           int first_Q_size,
                           int first_Qprime_size) {
-    int N = src.public_keys->polys->components->n;
-    int n_public_key = src.n_public_key;
-    int level = src.public_keys->level;
-    int n_component = src.public_keys->polys->n_component;
-
-    for (int i = 0; i < n_public_key; i++) {
-        for (int j = 0; j < 2; j++) {
-            for (int k = 0; k < n_component; k++) {
-                int k_ = (k < level + 1) ? k : k - (level + 1) + first_Q_size;
-                CHECK(
-                    cudaMemcpyAsync(&(dest.data()[i * 2 * first_Qprime_size * N + j * first_Qprime_size * N + k_ * N]),
-                                    src.public_keys[i].polys[j].components[k].data, N * sizeof(uint64_t),
-                                    cudaMemcpyHostToDevice, dest.stream()));
-            }
-        }
-    }
+    export_key_switch_key(src, dest.data(), dest.stream(), first_Q_size, first_Qprime_size);
 }
 
 /**
@@ -182,6 +189,11 @@ template <heongpu::Scheme SchemeType> void import_ciphertext(heongpu::Ciphertext
     int N = src.ring_size();
     int n_component = src.level() + 1;
 
+    if (uint64_t* data = ciphertext_contiguous_data(dest)) {
+        CHECK(cudaMemcpyAsync(data, src.data(), src.size() * n_component * N * sizeof(uint64_t),
+                              cudaMemcpyDeviceToHost, src.stream()));
+        return;
+    }
     for (int i = 0; i < src.size(); i++) {
         for (int j = 0; j < n_component; j++) {
             CHECK(cudaMemcpyAsync(dest->polys[i].components[j].data, &src.data()[i * n_component * N + j * N],
@@ -321,7 +333,7 @@ template <heongpu::Scheme SchemeType> ExecutorFunc create_load_to_gpu_executor()
  *
  * @note Input: std::shared_ptr<GPU type> from available_data
  * @note Output: std::shared_ptr<C struct> stored in std::any
- * @note C struct memory is allocated here and freed by shared_ptr deleter
+ * @note C struct memory is allocated here, in the contiguous layout, and freed by shared_ptr deleter
  */
 template <heongpu::Scheme SchemeType> ExecutorFunc create_store_from_gpu_executor() {
     return [](ExecutionContext& ctx, const std::unordered_map<NodeIndex, std::any>& inputs, std::any& output,
@@ -345,9 +357,13 @@ template <heongpu::Scheme SchemeType> ExecutorFunc create_store_from_gpu_executo
                 auto gpu_ct = std::any_cast<std::shared_ptr<heongpu::Ciphertext<SchemeType>>>(gpu_data);
 
                 auto* c_ct = (CCiphertext*)malloc(sizeof(CCiphertext));
-                alloc_ciphertext(c_ct, gpu_ct->size() - 1, gpu_ct->level(), gpu_ct->ring_size());
+                alloc_ciphertext_contiguous(c_ct, gpu_ct->size() - 1, gpu_ct->level(), gpu_ct->ring_size());
+                if (!c_ct->polys) {
+                    free(c_ct);
+                    throw std::bad_alloc();
+                }
                 c_struct = std::shared_ptr<CCiphertext>(c_ct, [](CCiphertext* ptr) {
-                    free_ciphertext(ptr);
+                    free_ciphertext_contiguous(ptr);
                     free(ptr);
                 });
 
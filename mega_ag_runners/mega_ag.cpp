@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <algorithm>
 #include <fstream>
 #include <queue>
 #include <string>
@@ -43,6 +44,8 @@ const std::unordered_map<std::string, OperationType> str_to_operation_type = {
     {"cmp_sum", OperationType::MAC_WO_PARTIAL_SUM},
     {"cmpac_sum", OperationType::MAC_W_PARTIAL_SUM},
     {"bootstrap", OperationType::BOOTSTRAP},
+    {"linear_transform", OperationType::LINEAR_TRANSFORM},
+    {"poly_eval", OperationType::POLY_EVAL},
     {"fpga_kernel", OperationType::FPGA_KERNEL},
 };
 
@@ -50,6 +53,43 @@ const std::unordered_map<std::string, OperationType> str_to_operation_type = {
 // Static utility functions
 // =============================================================================
 
+// Whether the processor runs CPU projects, whose graphs leave the keys to the context
+static bool is_cpu_processor(Processor processor) {
+    return processor == Processor::CPU || processor == Processor::CPU_NATIVE;
+}
+
+// Rough relative CPU cost of one compute node, in units of one ciphertext add. Key-switching ops dominate
+// everything but bootstrapping, which costs about as much as a few hundred key switches.
+static int estimate_compute_cost(const ComputeNode& node) {
+    if (!node.fhe_prop.has_value()) {
+        return 1;
+    }
+    constexpr int key_switch_cost = 20;
+    switch (node.fhe_prop->op_type) {
+        case OperationType::MULTIPLY:
+        case OperationType::RESCALE: return 4;
+        case OperationType::RELINEARIZE:
+        case OperationType::ROTATE_COL:
+        case OperationType::ROTATE_ROW: return key_switch_cost;
+        case OperationType::MAC_WO_PARTIAL_SUM:
+        case OperationType::MAC_W_PARTIAL_SUM:
+            return node.fhe_prop->p.has_value() ? std::max(1, node.fhe_prop->p->sum_cnt) * 2 : 2;
+        case OperationType::LINEAR_TRANSFORM: {
+            if (!node.fhe_prop->p.has_value()) {
+                return 1;
+            }
+            const auto& diags = node.fhe_prop->p->diag_indices;
+            int n1 = std::max(1, node.fhe_prop->p->bsgs_n1);
+            int n_rot = n1 + static_cast<int>(diags.size()) / n1;
+            return n_rot * key_switch_cost + static_cast<int>(diags.size()) * 2;
+        }
+        case OperationType::POLY_EVAL:
+            return node.fhe_prop->p.has_value() ? node.fhe_prop->p->poly_degree * (key_switch_cost + 4) : 1;
+        case OperationType::BOOTSTRAP: return 300 * key_switch_cost;
+        default: return 1;
+    }
+}
+
 // Creates a fresh data node cloned from `src`, assigned `new_idx` and `new_id`,
 // with successors/predecessors cleared and optional flag overrides.
 static DatumNode make_data_node(const DatumNode& src,
@@ -126,6 +166,8 @@ MegaAG MegaAG::load(const std::string& json_path, Processor processor, ScheduleM
     MegaAG mega_ag = from_json(json_path, processor);
     mega_ag.apply_processor_layout();
     mega_ag.compute_properties(mode);
+    mega_ag.mark_constant_computes();
+    mega_ag.link_linear_chains();
     return mega_ag;
 }
 
@@ -172,7 +214,7 @@ MegaAG MegaAG::from_json(const std::string& json_path, Processor processor) {
         } else {
             // FHE data node
             auto datum_type = str_to_datum_type.at(json_type);
-            if (processor == Processor::CPU) {
+            if (is_cpu_processor(processor)) {
                 if (datum_type == DataType::TYPE_RELIN_KEY || datum_type == DataType::TYPE_GALOIS_KEY ||
                     datum_type == DataType::TYPE_SWITCH_KEY) {
                     continue;
@@ -242,6 +284,24 @@ MegaAG MegaAG::from_json(const std::string& json_path, Processor processor) {
                 ComputeNode::FheProperty::ExtraProperty extra_prop;
                 extra_prop.sum_cnt = value["sum_cnt"].get<int32_t>();
                 fhe_prop.p = extra_prop;
+            } else if (fhe_prop.op_type == OperationType::LINEAR_TRANSFORM) {
+                ComputeNode::FheProperty::ExtraProperty extra_prop;
+                extra_prop.diag_indices = value["diag_indices"].get<std::vector<int32_t>>();
+                extra_prop.bsgs_n1 = value["bsgs_n1"].get<int32_t>();
+                fhe_prop.p = extra_prop;
+            } else if (fhe_prop.op_type == OperationType::POLY_EVAL) {
+                ComputeNode::FheProperty::ExtraProperty extra_prop;
+                if (value.contains("poly_func")) {
+                    extra_prop.poly_func = value["poly_func"].get<std::string>();
+                } else {
+                    extra_prop.poly_coeffs = value["poly_coeffs"].get<std::vector<double>>();
+                    extra_prop.poly_chebyshev = value["poly_basis"].get<std::string>() == "chebyshev";
+                }
+                auto interval = value["poly_interval"].get<std::vector<double>>();
+                extra_prop.poly_left = interval.at(0);
+                extra_prop.poly_right = interval.at(1);
+                extra_prop.poly_degree = value["poly_degree"].get<int32_t>();
+                fhe_prop.p = extra_prop;
             }
 
             node.fhe_prop = fhe_prop;
@@ -249,7 +309,7 @@ MegaAG MegaAG::from_json(const std::string& json_path, Processor processor) {
 
         // Add input/output nodes (common for both custom and FHE)
         for (NodeIndex i : input_indices) {
-            if (processor == Processor::CPU && mega_ag.data.find(i) == mega_ag.data.end()) {
+            if (is_cpu_processor(processor) && mega_ag.data.find(i) == mega_ag.data.end()) {
                 continue;
             }
             node.input_nodes.push_back(&mega_ag.data.at(i));
@@ -280,7 +340,7 @@ MegaAG MegaAG::from_json(const std::string& json_path, Processor processor) {
     }
 
     std::vector<NodeIndex> input_indices = mega_ag_json["inputs"].get<std::vector<NodeIndex>>();
-    if (processor == Processor::CPU) {
+    if (is_cpu_processor(processor)) {
         for (auto& index : input_indices) {
             if (mega_ag.data.find(index) != mega_ag.data.end()) {
                 mega_ag.inputs.push_back(index);
@@ -294,6 +354,15 @@ MegaAG MegaAG::from_json(const std::string& json_path, Processor processor) {
         }
     }
 
+    if (mega_ag_json.contains("offline_inputs")) {
+        for (NodeIndex index : mega_ag_json["offline_inputs"].get<std::vector<NodeIndex>>()) {
+            if (mega_ag.data.find(index) != mega_ag.data.end()) {
+                mega_ag.offline_inputs.push_back(index);
+                mega_ag.data.at(index).is_offline = true;
+            }
+        }
+    }
+
     mega_ag.outputs = mega_ag_json["outputs"].get<std::vector<NodeIndex>>();
     for (auto i : mega_ag.outputs) {
         mega_ag.data.at(i).is_output = true;
@@ -307,12 +376,12 @@ MegaAG MegaAG::from_json(const std::string& json_path, Processor processor) {
 void MegaAG::apply_processor_layout() {
     if (processor == Processor::GPU || processor == Processor::FPGA) {
         insert_backend_abi_bridge_nodes();
-    } else if (processor == Processor::CPU) {
+    } else if (is_cpu_processor(processor)) {
         insert_cpu_abi_bridge_nodes();
     }
 
     for (auto& [compute_index, compute_node] : computes) {
-        if (processor == Processor::CPU) {
+        if (is_cpu_processor(processor)) {
             compute_node.on_cpu = true;
         } else if (processor == Processor::FPGA) {
             if (compute_node.custom_prop.has_value()) {
@@ -334,6 +403,7 @@ void MegaAG::apply_processor_layout() {
 }
 
 void MegaAG::compute_properties(ScheduleMode mode) {
+    compute_costs();
     compute_top_levels();
     compute_bottom_levels();
 
@@ -349,6 +419,116 @@ void MegaAG::compute_properties(ScheduleMode mode) {
     }
 }
 
+static bool is_foldable(const ComputeNode& node) {
+    if (!node.fhe_prop.has_value() || node.input_nodes.empty()) {
+        return false;
+    }
+    switch (node.fhe_prop->op_type) {
+        case OperationType::ADD:
+        case OperationType::SUB:
+        case OperationType::NEGATE:
+        case OperationType::MULTIPLY:
+        case OperationType::RESCALE:
+        case OperationType::DROP_LEVEL:
+        case OperationType::MAC_WO_PARTIAL_SUM: return true;
+        default: return false;
+    }
+}
+
+void MegaAG::mark_constant_computes() {
+    constant_frontier.clear();
+    for (auto& [idx, node] : computes) {
+        node.is_constant = false;
+    }
+
+    auto is_constant_datum = [](const DatumNode* datum) {
+        return datum->is_offline || (!datum->predecessors.empty() && datum->predecessors[0]->is_constant);
+    };
+
+    // Propagate from the offline inputs until no more compute node becomes constant
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [idx, node] : computes) {
+            if (node.is_constant || !is_foldable(node)) {
+                continue;
+            }
+            if (std::all_of(node.input_nodes.begin(), node.input_nodes.end(), is_constant_datum)) {
+                node.is_constant = true;
+                changed = true;
+            }
+        }
+    }
+
+    for (const auto& [idx, node] : computes) {
+        if (!node.is_constant) {
+            continue;
+        }
+        for (const DatumNode* output : node.output_nodes) {
+            bool read_online = output->is_output ||
+                               std::any_of(output->successors.begin(), output->successors.end(),
+                                           [](const ComputeNode* successor) { return !successor->is_constant; });
+            if (read_online) {
+                constant_frontier.push_back(output->index);
+            }
+        }
+    }
+}
+
+void MegaAG::link_linear_chains() {
+    for (auto& [idx, node] : computes) {
+        node.chain_next = nullptr;
+        if (!node.on_cpu || node.output_nodes.size() != 1) {
+            continue;
+        }
+        const DatumNode* output = node.output_nodes[0];
+        if (output->is_output || output->successors.size() != 1) {
+            continue;
+        }
+        ComputeNode* consumer = output->successors[0];
+        if (consumer != &node && consumer->on_cpu &&
+            std::count(consumer->input_nodes.begin(), consumer->input_nodes.end(), output) == 1) {
+            node.chain_next = consumer;
+        }
+    }
+}
+
+std::unordered_set<NodeIndex> MegaAG::computes_downstream_of(const std::vector<NodeIndex>& data_indices) const {
+    std::unordered_set<NodeIndex> downstream;
+    std::vector<const DatumNode*> stack;
+    for (NodeIndex index : data_indices) {
+        stack.push_back(&data.at(index));
+    }
+    while (!stack.empty()) {
+        const DatumNode* datum = stack.back();
+        stack.pop_back();
+        for (const ComputeNode* successor : datum->successors) {
+            if (downstream.insert(successor->index).second) {
+                stack.insert(stack.end(), successor->output_nodes.begin(), successor->output_nodes.end());
+            }
+        }
+    }
+    return downstream;
+}
+
+std::unordered_set<NodeIndex> MegaAG::computes_upstream_of(const std::vector<NodeIndex>& data_indices) const {
+    std::unordered_set<NodeIndex> upstream;
+    std::vector<const DatumNode*> stack;
+    for (NodeIndex index : data_indices) {
+        stack.push_back(&data.at(index));
+    }
+    while (!stack.empty()) {
+        const DatumNode* datum = stack.back();
+        stack.pop_back();
+        for (const ComputeNode* predecessor : datum->predecessors) {
+            if (upstream.insert(predecessor->index).second) {
+                stack.insert(stack.end(), predecessor->input_nodes.begin(), predecessor->input_nodes.end());
+            }
+        }
+    }
+    return upstream;
+}
+
 // =============================================================================
 // MegaAG member functions — helpers
 // =============================================================================
@@ -584,6 +764,12 @@ void MegaAG::insert_cpu_abi_bridge_nodes() {
     rebuild_bridge_relationships({OperationType::EXPORT_TO_ABI, OperationType::IMPORT_FROM_ABI});
 }
 
+void MegaAG::compute_costs() {
+    for (auto& [idx, node] : computes) {
+        node.sched_meta.cost = estimate_compute_cost(node);
+    }
+}
+
 // Propagates top_level forward using topological order (Kahn's algorithm): O(V+E)
 void MegaAG::compute_top_levels() {
     std::unordered_map<NodeIndex, int> in_degree;
@@ -620,11 +806,11 @@ void MegaAG::compute_top_levels() {
     }
 }
 
-// Propagates bottom_level backward using reverse topological order (Kahn's algorithm): O(V+E)
+// Propagates cost-weighted bottom_level backward using reverse topological order (Kahn's algorithm): O(V+E)
 void MegaAG::compute_bottom_levels() {
     std::unordered_map<NodeIndex, int> out_degree;
     for (auto& [idx, node] : computes) {
-        node.sched_meta.bottom_level = 0;
+        node.sched_meta.bottom_level = node.sched_meta.cost;
         out_degree[idx] = 0;
     }
 
@@ -646,7 +832,7 @@ void MegaAG::compute_bottom_levels() {
         ComputeNode& v = computes.at(v_idx);
         for (auto* input_datum : v.input_nodes) {
             for (auto* upstream : input_datum->predecessors) {
-                int candidate = v.sched_meta.bottom_level + 1;
+                int candidate = v.sched_meta.bottom_level + upstream->sched_meta.cost;
                 if (upstream->sched_meta.bottom_level < candidate)
                     upstream->sched_meta.bottom_level = candidate;
                 if (--out_degree[upstream->index] == 0)
@@ -37,7 +37,8 @@ using NodeIndex = uint64_t;
 // Forward declarations
 struct ComputeNode;
 
-enum class Processor { CPU, FPGA, GPU };
+// CPU_NATIVE runs CPU projects with the native executors, on ABI structs exported by heterogeneous bridge executors
+enum class Processor { CPU, FPGA, GPU, CPU_NATIVE };
 
 // Unified execution context for both CPU and GPU
 struct ExecutionContext {
@@ -79,6 +80,8 @@ enum class OperationType {
     MAC_WO_PARTIAL_SUM,
     MAC_W_PARTIAL_SUM,
     BOOTSTRAP,
+    LINEAR_TRANSFORM,  // BSGS plaintext matrix-ciphertext vector product
+    POLY_EVAL,         // BSGS polynomial evaluation over an approximation interval
 
     FPGA_KERNEL,  // Composite FPGA sub-project operator (heterogeneous mode)
 
@@ -102,6 +105,7 @@ struct DatumNode {
     std::vector<ComputeNode*> successors;    // Consumer compute nodes (both FHE and custom)
     bool is_input = false;
     bool is_output = false;
+    bool is_offline = false;            // Offline input (or its ABI bridge copy): constant across runs
     DataType datum_type = TYPE_CUSTOM;  // Unified data type (TYPE_CUSTOM for custom nodes)
 
     // FHE-specific properties (use custom_prop.has_value() to check if custom node)
@@ -149,10 +153,19 @@ struct ComputeNode {
     // Scheduling priority: higher value runs first
     int priority = 0;
 
+    // True if all transitive inputs are offline inputs, so the result is the same on every run (see
+    // MegaAG::mark_constant_computes())
+    bool is_constant = false;
+
+    // Sole consumer of this node's only output, if both run on CPU, so that a runner can execute it right after this
+    // node on the same thread without publishing the intermediate (see MegaAG::link_linear_chains())
+    ComputeNode* chain_next = nullptr;
+
     // Graph structural properties for scheduling, computed by MegaAG::compute_graph_properties()
     struct ScheduleMeta {
         int top_level = 0;     // longest path from any source compute node to this node
-        int bottom_level = 0;  // longest path from this node to any sink compute node
+        int bottom_level = 0;  // cost-weighted longest path from this node (inclusive) to any sink compute node
+        int cost = 1;          // estimated relative execution cost, in units of one ciphertext add
     };
     ScheduleMeta sched_meta;
 
@@ -163,6 +176,14 @@ struct ComputeNode {
         struct ExtraProperty {
             int32_t rotation_step = 0;
             int32_t sum_cnt = 0;
+            std::vector<int32_t> diag_indices;  // LINEAR_TRANSFORM: diagonal index of each pt_mul input
+            int32_t bsgs_n1 = 0;                // LINEAR_TRANSFORM: baby-step size
+            std::string poly_func;              // POLY_EVAL: built-in function name, empty if poly_coeffs is set
+            std::vector<double> poly_coeffs;    // POLY_EVAL: coefficients, lowest order first
+            bool poly_chebyshev = false;        // POLY_EVAL: poly_coeffs are Chebyshev over the interval
+            double poly_left = -1.0;            // POLY_EVAL: approximation interval [poly_left, poly_right]
+            double poly_right = 1.0;
+            int32_t poly_degree = 0;            // POLY_EVAL: approximation degree
         };
         std::optional<ExtraProperty> p;
     };
@@ -179,7 +200,7 @@ struct ComputeNode {
 /**
  * @brief Scheduling mode for compute node priority computation.
  *
- * MAKESPAN_FIRST: bottom_level (longest path to sink) — minimizes makespan.
+ * MAKESPAN_FIRST: bottom_level (cost-weighted longest path to sink) — minimizes makespan.
  * MEMORY_FIRST:  -bottom_level (prefer nodes closer to sink) — reduces peak memory by completing in-flight paths first.
  */
 enum class ScheduleMode {
@@ -193,6 +214,7 @@ struct MegaAG {
     std::vector<NodeIndex> inputs;
     std::vector<NodeIndex> outputs;
     std::vector<NodeIndex> offline_inputs;
+    std::vector<NodeIndex> constant_frontier;  // Data produced by constant computes and read by non-constant ones
     nlohmann::json parameter;
     Processor processor = Processor::CPU;
     Algo algo = ALGO_BFV;
@@ -292,13 +314,45 @@ struct MegaAG {
     }
 
     /**
-     * @brief Compute top_level/bottom_level for each compute node, then set priority by ScheduleMode.
+     * @brief Compute cost/top_level/bottom_level for each compute node, then set priority by ScheduleMode.
+     *
+     * bottom_level weights each node by its estimated cost, so a chain that passes through a BOOTSTRAP outranks a
+     * longer chain of cheap ops, and expensive nodes are started early enough to overlap with unrelated work.
      *
      * MAKESPAN_FIRST: priority = bottom_level (longer remaining critical path runs first).
      * MEMORY_FIRST:  priority = -bottom_level (prefer nodes closer to sink, completing in-flight paths to free memory).
      */
     void compute_properties(ScheduleMode mode);
 
+    /**
+     * @brief Mark compute nodes whose transitive inputs are all offline inputs as constant, and collect the
+     * constant_frontier: the data a run needs from the constant part of the graph.
+     *
+     * Only keyless FHE ops (add, sub, negate, multiply, rescale, drop_level, ct-pt multiply-accumulate) are folded,
+     * so a constant result depends on nothing but the offline input values. ABI bridge and custom nodes always run.
+     * A runner may execute the constant computes once, cache the frontier data and skip them on later runs.
+     */
+    void mark_constant_computes();
+
+    /**
+     * @brief Compute nodes that read, directly or transitively, any of the given data nodes.
+     */
+    std::unordered_set<NodeIndex> computes_downstream_of(const std::vector<NodeIndex>& data_indices) const;
+
+    /**
+     * @brief Link single-producer/single-consumer chains of CPU compute nodes through ComputeNode::chain_next.
+     *
+     * A node links to the consumer of its output if the output is not a task output and has no other consumer. A
+     * runner may fuse a linked chain into one job that keeps the intermediates local; a chain head's priority (its
+     * bottom level) already covers the whole chain.
+     */
+    void link_linear_chains();
+
+    /**
+     * @brief Compute nodes that the given data nodes depend on, directly or transitively.
+     */
+    std::unordered_set<NodeIndex> computes_upstream_of(const std::vector<NodeIndex>& data_indices) const;
+
 private:
     static MegaAG from_json(const std::string& json_path, Processor processor);
 
@@ -310,6 +364,7 @@ private:
     void insert_backend_abi_bridge_nodes();
     void insert_cpu_abi_bridge_nodes();
 
+    void compute_costs();
     void compute_top_levels();
     void compute_bottom_levels();
 };
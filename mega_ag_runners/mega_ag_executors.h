@@ -44,6 +44,15 @@ extern void bind_cpu_executor(ComputeNode& node, Algo algorithm) __attribute__((
 void bind_cpu_executor(ComputeNode& node, Algo algorithm);
 #endif
 
+/**
+ * @brief Native CPU executor binding function, provided by cpu_mega_ag_runner like bind_cpu_executor
+ */
+#ifdef LATTISENSE_ENABLE_GPU
+extern void bind_cpu_native_executor(ComputeNode& node, Algo algorithm) __attribute__((weak));
+#else
+void bind_cpu_native_executor(ComputeNode& node, Algo algorithm);
+#endif
+
 /**
  * @brief GPU executor binding function
  *
@@ -70,6 +79,7 @@ inline void bind_gpu_executor(ComputeNode& /*node*/, Algo /*algorithm*/) {
  *
  * Supported backends:
  * - CPU: Uses Lattigo-based operations (always available in standard builds)
+ * - CPU_NATIVE: Uses the vectorized native kernels on ABI structs (element-wise operations and CKKS rescale only)
  * - GPU: Uses HEonGPU library (requires LATTISENSE_ENABLE_GPU=ON)
  * - FPGA: Not yet implemented
  */
@@ -104,6 +114,19 @@ public:
 #endif
                 break;
 
+            case Processor::CPU_NATIVE:
+#ifdef LATTISENSE_ENABLE_GPU
+                if (bind_cpu_native_executor) {
+                    bind_cpu_native_executor(node, algorithm);
+                } else {
+                    throw std::runtime_error("Native CPU executor is not available in this GPU-only build. "
+                                             "Link with cpu_mega_ag_runner library to enable CPU support.");
+                }
+#else
+                bind_cpu_native_executor(node, algorithm);
+#endif
+                break;
+
             case Processor::GPU: bind_gpu_executor(node, algorithm); break;
 
             default: throw std::runtime_error("Unsupported processor type");
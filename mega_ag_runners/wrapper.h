@@ -41,10 +41,72 @@ typedef struct fhe_task_handle_st* fhe_task_handle;
  */
 typedef void (*progress_callback_t)(int completed, int total, void* user_data);
 
+/**
+ * @brief Callback invoked when one item of an output argument has been written.
+ * @param output_id Id of the output argument.
+ * @param item_index Position of the item among the flattened items of the argument.
+ * @param user_data Opaque pointer passed through from the caller.
+ *
+ * @note Called from worker threads, possibly concurrently. The run returns only after every call has returned.
+ */
+typedef void (*output_ready_callback_t)(const char* output_id, uint64_t item_index, void* user_data);
+
+/**
+ * @brief Statistics of the last run of a CPU task.
+ *
+ * peak_rss_kb is the maximum over the memory monitor samples (see set_cpu_task_mem_monitor) and is 0 if the monitor
+ * was off. peak_live_bytes is tracked exactly by the runner.
+ */
+typedef struct {
+    uint64_t duration_ns;               // Wall time of the run
+    uint64_t peak_live_bytes;           // Peak estimated bytes of intermediate data held by the runner
+    uint64_t peak_rss_kb;               // Peak sampled process RSS
+    uint64_t n_samples;                 // Number of memory monitor samples
+    uint64_t n_computes_run;            // Compute nodes executed
+    uint64_t n_computes_skipped;        // Compute nodes skipped because their cached results were reused
+    uint64_t cached_bytes;              // Estimated bytes of intermediate results kept for incremental runs
+    uint64_t admission_wait_ns;         // Time waited for admission by the shared runtime, not part of duration_ns
+    uint64_t estimated_peak_bytes;      // Peak intermediate bytes reserved at admission by the shared runtime
+    uint64_t spilled_bytes;             // Serialized intermediate bytes written to the spill file
+    uint64_t prefetched_bytes;          // Spilled bytes read back ahead of their consumers
+    uint64_t demand_loaded_bytes;       // Spilled bytes read back by a consumer that found its input still spilled
+    uint64_t peak_spill_file_bytes;     // Peak size of the spill file
+    uint64_t n_computes_resumed;        // Compute nodes skipped because a checkpoint of an interrupted run held them
+    uint64_t checkpoints_written;       // Checkpoints written during the run
+    uint64_t checkpoint_bytes_written;  // Bytes written to the checkpoint directory
+    uint64_t n_computes_remote;         // Compute nodes left to the other ranks of a distributed run
+    uint64_t remote_bytes_sent;         // Serialized bytes sent to the other ranks
+    uint64_t remote_bytes_received;     // Serialized bytes received from the other ranks
+} cpu_task_stats_t;
+
+// Worker pool shared by the runs of several CPU tasks, in place of a pool per run.
+typedef struct cpu_runtime_st* cpu_runtime;
+
+// Connection of one process (rank) of distributed CPU runs to the others.
+typedef struct cpu_transport_st* cpu_transport;
+
+/**
+ * @brief Metrics of one tenant of a CPU runtime, accumulated since the tenant was first used.
+ */
+typedef struct {
+    uint64_t runs_completed;  // Runs that finished successfully
+    uint64_t runs_failed;     // Runs that failed or were cancelled, including while waiting for admission
+    uint64_t active_runs;     // Runs admitted and not finished
+    uint64_t waiting_runs;    // Runs waiting for admission
+    uint64_t jobs;            // Pool jobs run
+    uint64_t busy_ns;         // Wall time of the pool jobs run
+    uint64_t wait_ns;         // Time runs spent waiting for admission
+} cpu_tenant_stats_t;
+
 // ========== CPU Task Functions ==========
 
 fhe_task_handle create_fhe_cpu_task(const char* project_path);
 
+// Create a CPU task whose compute nodes run on the native vectorized kernels instead of Lattigo, on the ABI structs
+// exported by heterogeneous bridge executors. Only element-wise operations and the CKKS rescale are supported; binding
+// fails for other operations. Native tasks cannot run distributed.
+fhe_task_handle create_fhe_cpu_native_task(const char* project_path);
+
 void release_fhe_cpu_task(fhe_task_handle handle);
 
 void bind_cpu_task_custom_executors(fhe_task_handle handle,
@@ -54,6 +116,95 @@ void bind_cpu_task_custom_executors(fhe_task_handle handle,
 
 void bind_cpu_task_abi_bridge_executors(fhe_task_handle handle, void* abi_export_executor, void* abi_import_executor);
 
+// Run up to max_coalesce ready nodes of the same cheap op and level in one pool job (1 = off, the default).
+void set_cpu_task_max_coalesce(fhe_task_handle handle, uint64_t max_coalesce);
+
+// Run each chain of single-consumer nodes in one pool job, keeping the intermediates local (on by default).
+void set_cpu_task_chain_fusion(fhe_task_handle handle, bool enable);
+
+// Compute only the output arguments with the given ids and the compute nodes they depend on (n_ids = 0: all outputs,
+// the default). The other output arguments are left untouched.
+void set_cpu_task_requested_outputs(fhe_task_handle handle, const char** output_ids, uint64_t n_ids);
+
+// Run the compute nodes that produce output arguments ahead of all other ready nodes (off by default).
+void set_cpu_task_output_priority(fhe_task_handle handle, bool enable);
+
+// Call callback with user_data as soon as each item of an output argument is written during a run (NULL = none, the
+// default).
+void set_cpu_task_output_ready_callback(fhe_task_handle handle, output_ready_callback_t callback, void* user_data);
+
+// Sample RSS and live intermediate bytes every interval_ms during each run (0 = off, the default).
+// Samples are written to csv_path unless it is NULL or empty; tools/plot_mem.py plots the CSV.
+void set_cpu_task_mem_monitor(fhe_task_handle handle, uint32_t interval_ms, const char* csv_path);
+
+// Move idle intermediate ciphertexts to a scratch file in dir (NULL or "" for /tmp) while the live intermediate bytes
+// exceed threshold_bytes, and read them back ahead of their consumers. UINT64_MAX (the default) disables spilling.
+void set_cpu_task_spill(fhe_task_handle handle, uint64_t threshold_bytes, const char* dir);
+
+// Checkpoint each run in dir every interval_ms milliseconds, and resume a run from the checkpoint left in dir by an
+// interrupted run of the same graph and input ciphertexts. The checkpoint is removed when a run finishes. NULL or ""
+// disables checkpoints (the default); an interval of 0 only resumes.
+void set_cpu_task_checkpoint(fhe_task_handle handle, const char* dir, uint32_t interval_ms);
+
+// Create a CPU runtime with num_threads workers (0 = min(32, hardware threads)). Releasing it while tasks are attached
+// is allowed; the pool lives until the last of them is released or detached.
+cpu_runtime create_cpu_runtime(uint32_t num_threads);
+
+void release_cpu_runtime(cpu_runtime runtime);
+
+// Configure a tenant of the runtime. While the pool is saturated, the workers are divided among the tenants with
+// active runs in proportion to weight (at least 1); jobs waiting in the pool run in priority order, higher first; at
+// most max_concurrent_runs runs of the tenant are admitted at once (0 = no limit) and further runs wait.
+void set_cpu_runtime_tenant(cpu_runtime runtime,
+                            const char* tenant,
+                            uint32_t weight,
+                            int32_t priority,
+                            uint32_t max_concurrent_runs);
+
+void get_cpu_runtime_tenant_stats(cpu_runtime runtime, const char* tenant, cpu_tenant_stats_t* stats);
+
+// Admit runs only while the intermediate bytes reserved by the admitted runs stay within budget_bytes (UINT64_MAX =
+// no budget, the default); further runs wait in arrival order, and a run larger than the budget is admitted alone.
+// Each run reserves the peak estimated from its graph, corrected by the peaks of its past runs, or its actual peak so
+// far if larger.
+void set_cpu_runtime_memory_budget(cpu_runtime runtime, uint64_t budget_bytes);
+
+// Intermediate bytes currently reserved by the admitted runs.
+uint64_t get_cpu_runtime_reserved_bytes(cpu_runtime runtime);
+
+// Run the task on the shared pool of runtime as the given tenant, or on a pool of its own if runtime is NULL (the
+// default). A run cancelled while waiting for admission returns CPU_RUN_CANCELLED.
+void set_cpu_task_runtime(fhe_task_handle handle, cpu_runtime runtime, const char* tenant);
+
+// Create the transport of rank `rank` of n_ranks processes on this host, over Unix domain sockets in dir (NULL or ""
+// for /tmp, created if missing). Peers are connected on first use, waiting up to 30 s for them to start.
+cpu_transport create_unix_socket_transport(const char* dir, uint32_t rank, uint32_t n_ranks);
+
+// Releasing a transport while tasks are attached is allowed; it lives until the last of them is released or detached.
+void release_cpu_transport(cpu_transport transport);
+
+// Run the task as one rank of a distributed run over transport (NULL = alone, the default). The compute nodes are
+// partitioned among the ranks, balancing their work and keeping the ciphertext bytes sent between ranks small; each
+// rank runs its part and sends the ciphertexts the others read. Every rank must run the same task with the same
+// input arguments, in the same sequence of runs; the output arguments are written on rank 0 only. Distributed runs do
+// not use constant folding, incremental mode or checkpoints. A run fails on every rank if one rank fails.
+void set_cpu_task_transport(fhe_task_handle handle, cpu_transport transport);
+
+// Run the compute nodes that depend only on offline inputs once, and reuse their results in later runs while the
+// offline input handles are unchanged (on by default). Disabling it or calling invalidate_cpu_task_constant_cache
+// drops the cached results.
+void set_cpu_task_constant_folding(fhe_task_handle handle, bool enable);
+
+// Keep the intermediate results of each run, up to memory_budget_bytes, and re-execute only the compute nodes
+// downstream of the input arguments that changed since the previous run (off by default). Enabling it or changing the
+// budget drops the kept results.
+void set_cpu_task_incremental(fhe_task_handle handle, bool enable, uint64_t memory_budget_bytes);
+
+// Drop the cached constant and incremental results.
+void invalidate_cpu_task_constant_cache(fhe_task_handle handle);
+
+void get_cpu_task_stats(fhe_task_handle handle, cpu_task_stats_t* stats);
+
 int run_fhe_cpu_task(fhe_task_handle handle,
                      CArgument* input_args,
                      uint64_t n_in_args,
@@ -62,6 +213,33 @@ int run_fhe_cpu_task(fhe_task_handle handle,
                      progress_callback_t progress_cb,
                      void* user_data);
 
+// Cancellation request and deadline of one run of a CPU task.
+typedef struct cpu_run_control_st* cpu_run_control;
+
+// Return value of run_fhe_cpu_task_controlled when the run was cancelled or passed its deadline.
+#define CPU_RUN_CANCELLED 1
+
+// Create a run control. The run is cancelled once timeout_ms have passed since this call (0 = no deadline).
+cpu_run_control create_cpu_run_control(uint64_t timeout_ms);
+
+void release_cpu_run_control(cpu_run_control control);
+
+// Request cancellation of the run using control. Can be called from any thread.
+void cancel_cpu_run(cpu_run_control control);
+
+// Same as run_fhe_cpu_task, and stops when control is cancelled or passes its deadline (control may be NULL). A
+// stopped run dispatches no further compute nodes, waits for the running ones, releases its intermediate data and
+// returns CPU_RUN_CANCELLED; the output arguments are then partially written. An error thrown by a compute node stops
+// the run in the same way and is rethrown.
+int run_fhe_cpu_task_controlled(fhe_task_handle handle,
+                                CArgument* input_args,
+                                uint64_t n_in_args,
+                                CArgument* output_args,
+                                uint64_t n_out_args,
+                                progress_callback_t progress_cb,
+                                void* user_data,
+                                cpu_run_control control);
+
 // ========== GPU Task Functions ==========
 
 fhe_task_handle create_fhe_gpu_task(const char* project_path);
@@ -116,7 +116,7 @@ inline ExecutorFunc create_seal_abi_export_executor(int mf_nbits) {
                 auto* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
                 _export_relin_key(param_id, scheme, ntt_tables, src, c_rlk, level, mf_nbits);
                 output = std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
-                    free_relin_key(p);
+                    free_key_switch_key_contiguous(p);
                     free(p);
                 });
                 break;
@@ -127,7 +127,7 @@ inline ExecutorFunc create_seal_abi_export_executor(int mf_nbits) {
                 set_galois_key_steps(c_glk, &galois_element, 1);
                 _export_galois_key(param_id, scheme, ntt_tables, src, c_glk, level, mf_nbits);
                 output = std::shared_ptr<CGaloisKey>(c_glk, [](CGaloisKey* p) {
-                    free_galois_key(p);
+                    free_galois_key_contiguous(p);
                     free(p);
                 });
                 break;
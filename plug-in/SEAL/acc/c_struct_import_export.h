@@ -8,6 +8,7 @@ extern "C" {
 }
 #include <algorithm>
 #include <cstring>
+#include <new>
 #include <stdexcept>
 #include <vector>
 #include <seal/seal.h>
@@ -101,23 +102,16 @@ inline void _export_key_switch_key(uint64_t param_id,
     int N = src[0].data().poly_modulus_degree();
     int n_component = src[0].data().coeff_modulus_size();
 
-    dest->n_public_key = n_public_key;
-    dest->public_keys = (CPublicKey*)malloc(sizeof(CPublicKey) * n_public_key);
+    alloc_key_switch_key_contiguous(dest, n_public_key, level, n_component, N);
+    if (!dest->public_keys) {
+        throw std::bad_alloc();
+    }
 
     for (int k = 0; k < n_public_key; k++) {
-        dest->public_keys[k].level = level;
-        dest->public_keys[k].degree = 1;
-        dest->public_keys[k].polys = (CPolynomial*)malloc(sizeof(CPolynomial) * 2);
-
         for (int i = 0; i < 2; i++) {
-            dest->public_keys[k].polys[i].n_component = n_component;
-            dest->public_keys[k].polys[i].components = (CComponent*)malloc(sizeof(CComponent) * n_component);
-
             for (int j = 0; j < n_component; j++) {
-                dest->public_keys[k].polys[i].components[j].n = N;
-
                 // Copy first, then do in-place transforms on the copy.
-                uint64_t* copy = (uint64_t*)malloc(sizeof(uint64_t) * N);
+                uint64_t* copy = dest->public_keys[k].polys[i].components[j].data;
                 memcpy(copy, &src[k].data().data(i)[j * N], N * sizeof(uint64_t));
 
                 CoeffIter copy_coeff(copy);
@@ -134,8 +128,6 @@ inline void _export_key_switch_key(uint64_t param_id,
                         ckks_component_mul_by_pow2(param_id, copy, j, mf_nbits);
                     }
                 }
-
-                dest->public_keys[k].polys[i].components[j].data = copy;
             }
         }
     }
@@ -130,7 +130,7 @@ extern "C" void* create_lattigo_abi_export_executor(int algo, int mf_nbits, int
                 auto* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
                 ExportLattigoRelinKey(params_handle, input_handle, level, key_mf_nbits, c_rlk);
                 output = std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
-                    free_relin_key(p);
+                    free_key_switch_key_contiguous(p);
                     free(p);
                 });
                 break;
@@ -140,7 +140,7 @@ extern "C" void* create_lattigo_abi_export_executor(int algo, int mf_nbits, int
                 ExportLattigoGaloisKey(params_handle, input_handle, galois_element, level, key_mf_nbits, c_glk);
 
                 output = std::shared_ptr<CGaloisKey>(c_glk, [](CGaloisKey* p) {
-                    free_galois_key(p);
+                    free_galois_key_contiguous(p);
                     free(p);
                 });
                 break;
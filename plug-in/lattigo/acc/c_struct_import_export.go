@@ -38,23 +38,17 @@ func export_polynomial(src *ring.Poly, dest *C.CPolynomial) {
 	}
 }
 
-func export_polynomial_qp(src *ringqp.Poly, dest *C.CPolynomial, level int) {
-	var n_q_component int
-	if level == -1 {
-		n_q_component = src.LevelQ() + 1
-	} else {
-		n_q_component = level + 1
-	}
-	n_p_component := src.LevelP() + 1
-	n_component := n_q_component + n_p_component
-	dest.n_component = C.int(n_component)
-	dest.components = (*C.CComponent)(C.malloc(C.size_t(unsafe.Sizeof(C.CComponent{})) * C.ulong(n_component)))
-	component_slice := unsafe.Slice(dest.components, n_component)
-	for i := 0; i < n_q_component; i++ {
-		export_component(&src.Q.Coeffs[i], &component_slice[i])
-	}
-	for i := 0; i < n_p_component; i++ {
-		export_component(&src.P.Coeffs[i], &component_slice[n_q_component+i])
+// fill_polynomial_qp copies the first n_q_component Q components and all P
+// components of src into dest, whose components are already allocated.
+func fill_polynomial_qp(src *ringqp.Poly, dest *C.CPolynomial, n_q_component int) {
+	component_slice := unsafe.Slice(dest.components, int(dest.n_component))
+	for i := range component_slice {
+		dest_slice := unsafe.Slice((*uint64)(unsafe.Pointer(component_slice[i].data)), int(component_slice[i].n))
+		if i < n_q_component {
+			copy(dest_slice, src.Q.Coeffs[i])
+		} else {
+			copy(dest_slice, src.P.Coeffs[i-n_q_component])
+		}
 	}
 }
 
@@ -70,16 +64,6 @@ func wrap_c_components_as_ring_poly(comps []C.CComponent) *ring.Poly {
 	return poly
 }
 
-func export_public_key(src *rlwe.CiphertextQP, dest *C.CPublicKey, level int) {
-	dest.level = C.int(level)
-	dest.degree = C.int(1)
-	dest.polys = (*C.CPolynomial)(C.malloc(C.size_t(unsafe.Sizeof(C.CPolynomial{})) * C.ulong(2)))
-	poly_slice := unsafe.Slice(dest.polys, 2)
-	for i := 0; i < 2; i++ {
-		export_polynomial_qp(&src.Value[i], &poly_slice[i], level)
-	}
-}
-
 func export_key_switch_key(params rlwe.Parameters, src *rlwe.SwitchingKey, dest *C.CKeySwitchKey, level int, mf_nbits int) {
 	var n_public_key int
 	if level == -1 {
@@ -88,12 +72,26 @@ func export_key_switch_key(params rlwe.Parameters, src *rlwe.SwitchingKey, dest
 		n_public_key = (level + 1 + src.LevelP()) / (src.LevelP() + 1)
 	}
 
-	// Export directly from src (single copy: Go → C)
-	dest.n_public_key = C.int(n_public_key)
-	dest.public_keys = (*C.CPublicKey)(C.malloc(C.size_t(unsafe.Sizeof(C.CPublicKey{})) * C.ulong(n_public_key)))
+	var n_q_component int
+	if level == -1 {
+		n_q_component = src.Value[0][0].Value[0].LevelQ() + 1
+	} else {
+		n_q_component = level + 1
+	}
+	n_component := n_q_component + src.LevelP() + 1
+
+	// Export directly from src (single copy: Go → C) into one contiguous block,
+	// which the GPU runner uploads with one copy per key
+	C.alloc_key_switch_key_contiguous(dest, C.int(n_public_key), C.int(level), C.int(n_component), C.int(params.N()))
+	if dest.public_keys == nil {
+		panic("failed to allocate key switch key")
+	}
 	public_key_slice := unsafe.Slice(dest.public_keys, n_public_key)
 	for i := 0; i < n_public_key; i++ {
-		export_public_key(&src.Value[i][0], &public_key_slice[i], level)
+		pk_poly_slice := unsafe.Slice(public_key_slice[i].polys, 2)
+		for j := 0; j < 2; j++ {
+			fill_polynomial_qp(&src.Value[i][0].Value[j], &pk_poly_slice[j], n_q_component)
+		}
 	}
 
 	// Transform C memory in-place (avoids CopyNew double-copy)
@@ -102,14 +100,6 @@ func export_key_switch_key(params rlwe.Parameters, src *rlwe.SwitchingKey, dest
 		ringq := params.RingQ()
 		ringp := params.RingP()
 
-		// Determine Q/P component counts
-		var n_q_component int
-		if level == -1 {
-			n_q_component = src.Value[0][0].Value[0].LevelQ() + 1
-		} else {
-			n_q_component = level + 1
-		}
-
 		for i := 0; i < n_public_key; i++ {
 			pk_poly_slice := unsafe.Slice(public_key_slice[i].polys, 2)
 			for j := 0; j < 2; j++ {
@@ -18,6 +18,7 @@
 """Plot memory usage from CSV files generated by MemoryMonitor / GpuMemoryMonitor.
 
 CPU CSV columns : elapsed_ms, rss_kb, rss_gb
+                  [, live_gb]  (live intermediate data held by the task runner)
 GPU CSV columns : elapsed_ms, used_gb, pool_gb
 
 Mode is auto-detected from the CSV header unless --mode is specified.
@@ -37,13 +38,25 @@ def detect_mode(fieldnames):
     sys.exit(1)
 
 
+# Optional CPU series: CSV column -> (label, color)
+CPU_EXTRA_SERIES = {
+    'live_gb': ('Live intermediates', '#009688'),
+}
+
+
 def load_cpu(path):
     elapsed, rss_gb = [], []
+    extra = {}
     with open(path) as f:
-        for row in csv.DictReader(f):
+        reader = csv.DictReader(f)
+        columns = [c for c in CPU_EXTRA_SERIES if c in (reader.fieldnames or [])]
+        extra = {c: [] for c in columns}
+        for row in reader:
             elapsed.append(float(row['elapsed_ms']) / 1000.0)
             rss_gb.append(float(row['rss_gb']))
-    return elapsed, rss_gb
+            for c in columns:
+                extra[c].append(float(row[c]))
+    return elapsed, rss_gb, extra
 
 
 def load_gpu(path):
@@ -73,7 +86,7 @@ def ascii_chart(elapsed, values, label):
     print(f'  0 s {"":<{width - 6}} {elapsed[-1]:.1f} s')
 
 
-def plot_cpu(elapsed, rss_gb, out):
+def plot_cpu(elapsed, rss_gb, extra, out):
     peak_rss = max(rss_gb)
     avg_rss = sum(rss_gb) / len(rss_gb)
     rss_at_start = rss_gb[0]
@@ -93,6 +106,9 @@ def plot_cpu(elapsed, rss_gb, out):
             rss_at_start, color='#4CAF50', linestyle='-.', linewidth=1, label=f'RSS at start {rss_at_start:.2f} GB'
         )
         ax.fill_between(elapsed, rss_gb, alpha=0.15, color='#2196F3')
+        for column, values in extra.items():
+            label, color = CPU_EXTRA_SERIES[column]
+            ax.plot(elapsed, values, linewidth=1.0, color=color, label=f'{label} (GB)')
         ax.set_xlabel('Time (s)')
         ax.set_ylabel('Memory (GB)')
         ax.set_title('CPU Inference Memory Usage')
@@ -104,6 +120,9 @@ def plot_cpu(elapsed, rss_gb, out):
     except ImportError:
         print('matplotlib not available, printing ASCII chart.\n')
         ascii_chart(elapsed, rss_gb, 'RSS Memory (GB)')
+        for column, values in extra.items():
+            print()
+            ascii_chart(elapsed, values, f'{CPU_EXTRA_SERIES[column][0]} (GB)')
         print(f'\n  Peak RSS: {peak_rss:.2f} GB   Avg: {avg_rss:.2f} GB   Duration: {elapsed[-1]:.1f} s')
 
     print(f'\nSummary:')
@@ -114,6 +133,9 @@ def plot_cpu(elapsed, rss_gb, out):
     print(f'  Peak Delta   : {peak_delta:.2f} GB  [peak - rss_at_start]')
     print(f'  Avg  RSS     : {avg_rss:.2f} GB')
     print(f'  Final RSS    : {rss_gb[-1]:.2f} GB')
+    for column, values in extra.items():
+        label = CPU_EXTRA_SERIES[column][0]
+        print(f'  Peak {label}: {max(values):.2f} GB')
 
 
 def plot_gpu(elapsed, used_gb, pool_gb, out):
@@ -180,11 +202,11 @@ def main():
     out = args.out or args.csv.rsplit('.', 1)[0] + '.png'
 
     if mode == 'cpu':
-        elapsed, rss_gb = load_cpu(args.csv)
+        elapsed, rss_gb, extra = load_cpu(args.csv)
         if not elapsed:
             print('No data found in CSV.')
             sys.exit(1)
-        plot_cpu(elapsed, rss_gb, out)
+        plot_cpu(elapsed, rss_gb, extra, out)
     else:
         elapsed, used_gb, pool_gb = load_gpu(args.csv)
         if not elapsed:
@@ -17,8 +17,15 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <random>
+#include <thread>
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 #include "fixture.hpp"
@@ -133,6 +140,660 @@ TEMPLATE_TEST_CASE_METHOD(CkksFixture,
     }
 }
 
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS cac coalesced",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // Same task as "CKKS cac", with all n_op independent adds allowed to run in one pool job.
+    for (int level = this->min_level; level <= this->max_level; level++) {
+        SECTION("lv=" + to_string(level)) {
+            auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+            auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+            vector<CkksCiphertext> z_list;
+            z_list.reserve(this->n_op);
+            for (int _i = 0; _i < this->n_op; _i++)
+                z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+            string path =
+                cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_cac/level_" + to_string(level);
+            FheTaskCpu proj(path);
+            proj.set_max_coalesce(this->n_op);
+            vector<CxxVectorArgument> args = {
+                {"in_x_list", &xv.ciphertexts},
+                {"in_y_list", &yv.ciphertexts},
+                {"out_z_list", &z_list},
+            };
+            proj.run(&this->ctx, args);
+            for (int i = 0; i < this->n_op; i++)
+                verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), z_list[i]);
+        }
+    }
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS cac memory stats",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // Same task as "CKKS cac", run with the memory monitor on.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> z_list;
+    z_list.reserve(this->n_op);
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    string path = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_cac/level_" + to_string(level);
+    FheTaskCpu proj(path);
+    proj.set_mem_monitor(1);
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_y_list", &yv.ciphertexts},
+        {"out_z_list", &z_list},
+    };
+    proj.run(&this->ctx, args);
+    for (int i = 0; i < this->n_op; i++)
+        verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), z_list[i]);
+
+    // Intermediates are the imported operands and results, at most three ciphertexts per op.
+    cpu_task_stats_t stats = proj.get_stats();
+    uint64_t ct_bytes = 2 * uint64_t(level + 1) * this->param.get_n() * sizeof(uint64_t);
+    REQUIRE(stats.duration_ns > 0);
+    REQUIRE(stats.peak_live_bytes > 0);
+    REQUIRE(stats.peak_live_bytes <= 3 * this->n_op * ct_bytes);
+    REQUIRE(stats.n_samples >= 1);
+    REQUIRE(stats.peak_rss_kb > 0);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS constant fold",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // z = x + (-(w + v)) with offline w and v: the add and negate of w and v are computed once and reused.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto wv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto vv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> z_list;
+    z_list.reserve(this->n_op);
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_constant_fold/level_" + to_string(level);
+    FheTaskCpu proj(path);
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_w_list", &wv.ciphertexts},
+        {"in_v_list", &vv.ciphertexts},
+        {"out_z_list", &z_list},
+    };
+    auto verify = [&]() {
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_sub(xv.values[i], vec_add(wv.values[i], vv.values[i])), z_list[i]);
+    };
+
+    proj.run(&this->ctx, args);
+    verify();
+    REQUIRE(proj.get_stats().n_computes_skipped == 0);
+
+    // Same offline inputs, new online input: the constant part is skipped
+    xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    proj.run(&this->ctx, args);
+    verify();
+    REQUIRE(proj.get_stats().n_computes_skipped == 2 * this->n_op);
+
+    // New offline input values: the cache is invalidated and the constant part recomputed
+    wv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    proj.run(&this->ctx, args);
+    verify();
+    REQUIRE(proj.get_stats().n_computes_skipped == 0);
+
+    proj.set_constant_folding(false);
+    proj.run(&this->ctx, args);
+    verify();
+    REQUIRE(proj.get_stats().n_computes_skipped == 0);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS incremental",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // Same task as "CKKS constant fold". Per op: 3 input exports, add, negate, add, output import.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto wv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto vv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> z_list;
+    z_list.reserve(this->n_op);
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_constant_fold/level_" + to_string(level);
+    FheTaskCpu proj(path);
+    proj.set_incremental(true);
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_w_list", &wv.ciphertexts},
+        {"in_v_list", &vv.ciphertexts},
+        {"out_z_list", &z_list},
+    };
+    auto verify = [&]() {
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_sub(xv.values[i], vec_add(wv.values[i], vv.values[i])), z_list[i]);
+    };
+    const uint64_t n_computes = 7 * this->n_op;
+
+    proj.run(&this->ctx, args);
+    verify();
+    cpu_task_stats_t stats = proj.get_stats();
+    REQUIRE(stats.n_computes_run == n_computes);
+    REQUIRE(stats.cached_bytes > 0);
+
+    // Only x changed: the exports of w and v, their add and the negate are reused
+    xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    proj.run(&this->ctx, args);
+    verify();
+    stats = proj.get_stats();
+    REQUIRE(stats.n_computes_skipped == 4 * this->n_op);
+    REQUIRE(stats.n_computes_run + stats.n_computes_skipped == n_computes);
+
+    // Only w changed: the exports of x and v are reused
+    wv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    proj.run(&this->ctx, args);
+    verify();
+    REQUIRE(proj.get_stats().n_computes_skipped == 2 * this->n_op);
+
+    // Nothing fits in the budget: everything is recomputed
+    proj.set_incremental(true, 0);
+    proj.run(&this->ctx, args);
+    xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    proj.run(&this->ctx, args);
+    verify();
+    stats = proj.get_stats();
+    REQUIRE(stats.n_computes_skipped == 0);
+    REQUIRE(stats.cached_bytes == 0);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS output subset",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // s = x + y and d = x - y; only d is requested. Per op: 2 input exports, add, sub, 2 output imports.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> s_list, d_list;
+    for (int _i = 0; _i < this->n_op; _i++) {
+        s_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+        d_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    }
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_output_subset/level_" + to_string(level);
+    FheTaskCpu proj(path);
+    proj.set_requested_outputs({"out_d_list"});
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_y_list", &yv.ciphertexts},
+        {"out_s_list", &s_list},
+        {"out_d_list", &d_list},
+    };
+    int progress_total = 0;
+    proj.run(&this->ctx, args, [&](int completed, int total) { progress_total = total; });
+    for (int i = 0; i < this->n_op; i++)
+        verify_ckks_precision(this->ctx, vec_sub(xv.values[i], yv.values[i]), d_list[i]);
+
+    cpu_task_stats_t stats = proj.get_stats();
+    REQUIRE(stats.n_computes_run == 4 * this->n_op);
+    REQUIRE(stats.n_computes_skipped == 2 * this->n_op);
+    REQUIRE(progress_total == 4 * this->n_op);
+
+    proj.set_requested_outputs({"out_s_list", "out_d_list"});
+    proj.run(&this->ctx, args);
+    for (int i = 0; i < this->n_op; i++)
+        verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), s_list[i]);
+    REQUIRE(proj.get_stats().n_computes_run == 6 * this->n_op);
+
+    proj.set_requested_outputs({"out_z_list"});
+    REQUIRE_THROWS_AS(proj.run(&this->ctx, args), std::invalid_argument);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS output ready",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // s = x + y and d = x - y; every item of each computed output is reported exactly once.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> s_list, d_list;
+    for (int _i = 0; _i < this->n_op; _i++) {
+        s_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+        d_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    }
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_output_subset/level_" + to_string(level);
+    FheTaskCpu proj(path);
+    std::mutex reported_mutex;
+    std::map<string, vector<uint64_t>> reported;
+    proj.set_output_ready_callback([&](const string& output_id, uint64_t item_index) {
+        std::lock_guard<std::mutex> lock(reported_mutex);
+        reported[output_id].push_back(item_index);
+    });
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_y_list", &yv.ciphertexts},
+        {"out_s_list", &s_list},
+        {"out_d_list", &d_list},
+    };
+    vector<uint64_t> all_items(this->n_op);
+    for (int i = 0; i < this->n_op; i++)
+        all_items[i] = i;
+
+    for (bool prioritize : {false, true}) {
+        proj.set_output_priority(prioritize);
+        reported.clear();
+        proj.run(&this->ctx, args);
+        REQUIRE(reported.size() == 2);
+        for (auto& [output_id, items] : reported) {
+            std::sort(items.begin(), items.end());
+            REQUIRE(items == all_items);
+        }
+        for (int i = 0; i < this->n_op; i++) {
+            verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), s_list[i]);
+            verify_ckks_precision(this->ctx, vec_sub(xv.values[i], yv.values[i]), d_list[i]);
+        }
+    }
+
+    proj.set_requested_outputs({"out_d_list"});
+    reported.clear();
+    proj.run(&this->ctx, args);
+    REQUIRE(reported.size() == 1);
+    REQUIRE(reported["out_d_list"].size() == this->n_op);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS chain fusion",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // z = -(-(-(-x))) + y: the exports, the negates and the add form chains.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_chain/level_" + to_string(level);
+    FheTaskCpu proj(path);
+    for (bool fuse : {true, false}) {
+        proj.set_chain_fusion(fuse);
+        vector<CkksCiphertext> z_list;
+        z_list.reserve(this->n_op);
+        for (int _i = 0; _i < this->n_op; _i++)
+            z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+        vector<CxxVectorArgument> args = {
+            {"in_x_list", &xv.ciphertexts},
+            {"in_y_list", &yv.ciphertexts},
+            {"out_z_list", &z_list},
+        };
+        int progress_completed = 0, progress_total = 0;
+        proj.run(&this->ctx, args, [&](int completed, int total) {
+            progress_completed = completed;
+            progress_total = total;
+        });
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), z_list[i]);
+
+        // Per op: 2 input exports, 4 negates, add, output import
+        REQUIRE(proj.get_stats().n_computes_run == 8 * this->n_op);
+        REQUIRE(progress_completed == progress_total);
+        REQUIRE(progress_total == 8 * this->n_op);
+    }
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS shared runtime", "", CkksTestDefaultParams) {
+    // Three tasks of the chain project run at once on one shared pool, two of them as a tenant limited to one run;
+    // with a memory budget below any run's estimate, the runs are admitted one at a time.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_chain/level_" + to_string(level);
+
+    CpuRuntime runtime(4);
+    runtime.set_tenant("weighted", {2, 1, 0});
+    runtime.set_tenant("limited", {1, 0, 1});
+    vector<string> tenants = {"weighted", "limited", "limited"};
+    vector<std::unique_ptr<FheTaskCpu>> projs;
+    vector<vector<CkksCiphertext>> z_lists(tenants.size());
+    vector<vector<CxxVectorArgument>> args;
+    for (size_t t = 0; t < tenants.size(); t++) {
+        projs.push_back(std::make_unique<FheTaskCpu>(path));
+        projs[t]->set_runtime(&runtime, tenants[t]);
+        for (int _i = 0; _i < this->n_op; _i++)
+            z_lists[t].push_back(this->ctx.new_ciphertext(level, this->default_scale));
+        args.push_back({{"in_x_list", &xv.ciphertexts}, {"in_y_list", &yv.ciphertexts}, {"out_z_list", &z_lists[t]}});
+    }
+
+    uint64_t budget = UINT64_MAX;
+    SECTION("no memory budget") {}
+    SECTION("memory budget") {
+        budget = 1;
+    }
+    runtime.set_memory_budget(budget);
+
+    vector<FheTaskRun> runs;
+    for (size_t t = 0; t < tenants.size(); t++)
+        runs.push_back(projs[t]->run_async(&this->ctx, args[t]));
+    for (auto& run : runs)
+        run.get();
+
+    for (size_t t = 0; t < tenants.size(); t++) {
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), z_lists[t][i]);
+        REQUIRE(projs[t]->get_stats().n_computes_run == 8 * this->n_op);
+        REQUIRE(projs[t]->get_stats().estimated_peak_bytes > 0);
+    }
+    REQUIRE(runtime.reserved_bytes() == 0);
+    cpu_tenant_stats_t weighted = runtime.get_tenant_stats("weighted");
+    cpu_tenant_stats_t limited = runtime.get_tenant_stats("limited");
+    REQUIRE(weighted.runs_completed == 1);
+    REQUIRE(limited.runs_completed == 2);
+    REQUIRE(weighted.runs_failed + limited.runs_failed == 0);
+    REQUIRE(weighted.active_runs + limited.active_runs + limited.waiting_runs == 0);
+    REQUIRE(weighted.jobs > 0);
+    REQUIRE(limited.jobs > 0);
+    REQUIRE(limited.busy_ns > 0);
+    REQUIRE(runtime.get_tenant_stats("unused").jobs == 0);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS spill", "", CkksTestDefaultParams) {
+    // z_i = -x_i + -x_{n-1-i} on a single worker: the first half of the negations wait for their partners, so with a
+    // zero threshold they are spilled and read back before the additions.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> z_list;
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_spill/level_" + to_string(level);
+    CpuRuntime runtime(1);
+    FheTaskCpu proj(path);
+    proj.set_runtime(&runtime);
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"out_z_list", &z_list},
+    };
+
+    SECTION("spill off") {
+        proj.run(&this->ctx, args);
+        REQUIRE(proj.get_stats().spilled_bytes == 0);
+    }
+    SECTION("spill everything") {
+        proj.set_spill(0);
+        proj.run(&this->ctx, args);
+        cpu_task_stats_t stats = proj.get_stats();
+        REQUIRE(stats.spilled_bytes > 0);
+        REQUIRE(stats.prefetched_bytes + stats.demand_loaded_bytes == stats.spilled_bytes);
+        REQUIRE(stats.peak_spill_file_bytes > 0);
+    }
+    for (int i = 0; i < this->n_op; i++)
+        verify_ckks_precision(this->ctx, vec_neg(vec_add(xv.values[i], xv.values[this->n_op - 1 - i])), z_list[i]);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS checkpoint and resume", "", CkksTestDefaultParams) {
+    // z_i = -x_i + -x_{n-1-i} on a single worker. The first run is held once its first output is ready and cancelled;
+    // the next run resumes from the checkpoint it left, and the one after that starts over.
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> z_list;
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_spill/level_" + to_string(level);
+    CpuRuntime runtime(1);
+    FheTaskCpu proj(path);
+    proj.set_runtime(&runtime);
+    proj.set_checkpoint("/tmp/lattisense_test_checkpoint_" + this->tag, 1);
+    std::atomic<bool> released{false};
+    proj.set_output_ready_callback([&released](const string&, uint64_t) {
+        while (!released)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"out_z_list", &z_list},
+    };
+
+    FheTaskRun run = proj.run_async(&this->ctx, args);
+    REQUIRE_FALSE(run.wait_for(std::chrono::milliseconds(50)));
+    run.cancel();
+    released = true;
+    REQUIRE_THROWS_AS(run.get(), TaskCancelledError);
+
+    proj.run(&this->ctx, args);
+    cpu_task_stats_t stats = proj.get_stats();
+    REQUIRE(stats.n_computes_resumed > 0);
+    REQUIRE(stats.n_computes_run + stats.n_computes_resumed == 4 * this->n_op);
+    for (int i = 0; i < this->n_op; i++)
+        verify_ckks_precision(this->ctx, vec_neg(vec_add(xv.values[i], xv.values[this->n_op - 1 - i])), z_list[i]);
+
+    proj.run(&this->ctx, args);
+    REQUIRE(proj.get_stats().n_computes_resumed == 0);
+    REQUIRE(proj.get_stats().n_computes_run == 4 * this->n_op);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS distributed", "", CkksTestDefaultParams) {
+    // z_i = -x_i + -x_{n-1-i} on two ranks, run as two tasks of this process connected over Unix domain sockets
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_spill/level_" + to_string(level);
+    string socket_dir = "/tmp/lattisense_test_distributed_" + this->tag;
+    const uint32_t n_ranks = 2;
+
+    vector<std::unique_ptr<UnixSocketTransport>> transports;
+    vector<std::unique_ptr<FheTaskCpu>> projs;
+    vector<vector<CkksCiphertext>> z_lists(n_ranks);
+    vector<vector<CxxVectorArgument>> args;
+    for (uint32_t rank = 0; rank < n_ranks; rank++) {
+        transports.push_back(std::make_unique<UnixSocketTransport>(socket_dir, rank, n_ranks));
+        projs.push_back(std::make_unique<FheTaskCpu>(path));
+        projs[rank]->set_transport(transports[rank].get());
+        for (int _i = 0; _i < this->n_op; _i++)
+            z_lists[rank].push_back(this->ctx.new_ciphertext(level, this->default_scale));
+        args.push_back({{"in_x_list", &xv.ciphertexts}, {"out_z_list", &z_lists[rank]}});
+    }
+
+    // Runs are matched by their sequence number, so a second run exchanges its own data
+    for (int round = 0; round < 2; round++) {
+        vector<FheTaskRun> runs;
+        for (uint32_t rank = 0; rank < n_ranks; rank++)
+            runs.push_back(projs[rank]->run_async(&this->ctx, args[rank]));
+        for (auto& run : runs)
+            run.get();
+
+        cpu_task_stats_t stats0 = projs[0]->get_stats();
+        cpu_task_stats_t stats1 = projs[1]->get_stats();
+        // The input exports are run by both ranks, every other node by one of them
+        REQUIRE(stats0.n_computes_run + stats1.n_computes_run == 4 * this->n_op + this->n_op);
+        REQUIRE(stats0.n_computes_remote == stats1.n_computes_run - this->n_op);
+        REQUIRE(stats1.n_computes_run > this->n_op);
+        REQUIRE(stats0.remote_bytes_received > 0);
+        REQUIRE(stats0.remote_bytes_received == stats1.remote_bytes_sent);
+        REQUIRE(stats1.remote_bytes_received == stats0.remote_bytes_sent);
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_neg(vec_add(xv.values[i], xv.values[this->n_op - 1 - i])),
+                                  z_lists[0][i]);
+    }
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS shared public keys", "", CkksTestDefaultParams) {
+    // Two tasks of the same project share one entry of the key store until the context keys change
+    int level = this->max_level;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<CkksCiphertext> z_list;
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale * this->default_scale));
+    string path =
+        cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_cmc_relin/level_" + to_string(level);
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_y_list", &yv.ciphertexts},
+        {"out_z_list", &z_list},
+    };
+    auto verify = [&]() {
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_mul(xv.values[i], yv.values[i]), z_list[i]);
+    };
+
+    size_t n_entries = PublicKeyStore::size();
+    FheTaskCpu proj1(path);
+    FheTaskCpu proj2(path);
+    proj1.run(&this->ctx, args);
+    proj2.run(&this->ctx, args);
+    proj1.run(&this->ctx, args);
+    verify();
+    REQUIRE(PublicKeyStore::size() == n_entries + 1);
+
+    this->ctx.set_context_relin_key(this->ctx.extract_relin_key());
+    proj1.run(&this->ctx, args);
+    verify();
+    REQUIRE(PublicKeyStore::size() == n_entries + 2);
+    proj2.run(&this->ctx, args);
+    REQUIRE(PublicKeyStore::size() == n_entries + 1);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS exported key cache", "", CkksTestDefaultParams) {
+    // The ABI export of a key is made once and reused until the context keys change and the old keys are released
+    int level = this->max_level;
+    nlohmann::json key_signature = {{"rlk", level}, {"glk", nlohmann::json::object()}};
+    int n_exports = 0;
+    auto export_rlk = [&](const PublicKeyStorage& keys) {
+        uint64_t rlk = keys.rlk_handle->get();
+        return ExportedKeyCache::get<CRelinKey>({rlk, ExportedKeyCache::Kind::RELIN_KEY, level, -1, 64, 0}, [&]() {
+            n_exports++;
+            CRelinKey* c_rlk = (CRelinKey*)malloc(sizeof(CRelinKey));
+            export_ckks_relin_key(this->param.get(), rlk, level, 64, c_rlk);
+            return std::shared_ptr<CRelinKey>(c_rlk, [](CRelinKey* p) {
+                free_relin_key(p);
+                free(p);
+            });
+        });
+    };
+
+    size_t n_cached = ExportedKeyCache::size();
+    {
+        auto keys = PublicKeyStore::acquire(&this->ctx, key_signature);
+        auto exported = export_rlk(*keys);
+        REQUIRE(export_rlk(*PublicKeyStore::acquire(&this->ctx, key_signature)) == exported);
+        REQUIRE(n_exports == 1);
+        REQUIRE(ExportedKeyCache::size() == n_cached + 1);
+
+        this->ctx.set_context_relin_key(this->ctx.extract_relin_key());
+        auto new_keys = PublicKeyStore::acquire(&this->ctx, key_signature);
+        REQUIRE(export_rlk(*new_keys) != exported);
+        REQUIRE(n_exports == 2);
+        REQUIRE(ExportedKeyCache::size() == n_cached + 2);
+    }
+    REQUIRE(ExportedKeyCache::size() == n_cached);
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS native backend", "", CkksTestDefaultParams) {
+    // The native kernels produce the same ciphertext words as Lattigo
+    int level = this->max_level;
+    double scale2 = this->default_scale * this->default_scale;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    auto pv = new_ckks_test_pt(this->n_op, this->ctx, level, this->default_scale);
+    auto mv = new_ckks_test_pt_mul(this->n_op, this->ctx, level, this->default_scale);
+    string prefix = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op);
+    string lv = "/level_" + to_string(level);
+
+    auto run_both = [&](const string& path, vector<CxxVectorArgument> args, const string& out_name, int out_level,
+                        double out_scale, int n_out) {
+        vector<CkksCiphertext> lattigo_z, native_z;
+        for (int _i = 0; _i < n_out; _i++) {
+            lattigo_z.push_back(this->ctx.new_ciphertext(out_level, out_scale));
+            native_z.push_back(this->ctx.new_ciphertext(out_level, out_scale));
+        }
+        vector<CxxVectorArgument> native_args = args;
+        args.push_back({out_name, &lattigo_z});
+        native_args.push_back({out_name, &native_z});
+        FheTaskCpu lattigo_proj(path);
+        FheTaskCpu native_proj(path, CpuBackend::NATIVE);
+        lattigo_proj.run(&this->ctx, args);
+        native_proj.run(&this->ctx, native_args);
+        for (int i = 0; i < n_out; i++)
+            REQUIRE(native_z[i].serialize(this->param) == lattigo_z[i].serialize(this->param));
+    };
+
+    SECTION("cac") {
+        run_both(prefix + "_cac" + lv, {{"in_x_list", &xv.ciphertexts}, {"in_y_list", &yv.ciphertexts}},
+                 "out_z_list", level, this->default_scale, this->n_op);
+    }
+    SECTION("csp") {
+        run_both(prefix + "_csp" + lv, {{"in_x_list", &xv.ciphertexts}, {"in_y_list", &pv.plaintexts}},
+                 "out_z_list", level, this->default_scale, this->n_op);
+    }
+    SECTION("cneg") {
+        run_both(prefix + "_cneg" + lv, {{"in_x_list", &xv.ciphertexts}}, "out_z_list", level, this->default_scale,
+                 this->n_op);
+    }
+    SECTION("cmp_mul") {
+        run_both(prefix + "_cmp_mul" + lv, {{"in_x_list", &xv.ciphertexts}, {"in_y_list", &mv.plaintexts}},
+                 "out_z_list", level, scale2, this->n_op);
+    }
+    SECTION("rescale") {
+        auto rv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale * this->param.get_q(level));
+        run_both(prefix + "_rescale" + lv, {{"in_x_list", &rv.ciphertexts}}, "out_y_list", level - 1,
+                 this->default_scale, this->n_op);
+    }
+    SECTION("drop_level") {
+        run_both(prefix + "_drop_level" + lv + "/drop_2", {{"in_x_list", &xv.ciphertexts}}, "out_y_list", level - 2,
+                 this->default_scale, this->n_op);
+    }
+    SECTION("cmpac") {
+        int m = 4;
+        auto cv = new_ckks_test_ct(m, this->ctx, 5, this->default_scale);
+        auto qv = new_ckks_test_pt(m, this->ctx, 5, this->default_scale);
+        run_both(cpu_base_path + "/" + this->tag + "/CKKS_cmpac/level_5_m_" + to_string(m),
+                 {{"in_c_list", &cv.ciphertexts}, {"in_p_list", &qv.plaintexts}}, "out_z_list", 5, scale2, 1);
+    }
+    SECTION("cmc") {
+        vector<CkksCiphertext3> lattigo_z, native_z;
+        for (int _i = 0; _i < this->n_op; _i++) {
+            lattigo_z.push_back(this->ctx.new_ciphertext3(level, scale2));
+            native_z.push_back(this->ctx.new_ciphertext3(level, scale2));
+        }
+        FheTaskCpu lattigo_proj(prefix + "_cmc" + lv);
+        FheTaskCpu native_proj(prefix + "_cmc" + lv, CpuBackend::NATIVE);
+        lattigo_proj.run(&this->ctx, {{"in_x_list", &xv.ciphertexts},
+                                      {"in_y_list", &yv.ciphertexts},
+                                      {"out_z_list", &lattigo_z}});
+        native_proj.run(&this->ctx, {{"in_x_list", &xv.ciphertexts},
+                                     {"in_y_list", &yv.ciphertexts},
+                                     {"out_z_list", &native_z}});
+        for (int i = 0; i < this->n_op; i++)
+            REQUIRE(this->ctx.relinearize(native_z[i]).serialize(this->param) ==
+                    this->ctx.relinearize(lattigo_z[i]).serialize(this->param));
+    }
+    SECTION("unsupported") {
+        // Relinearization needs key switching, which the native kernels do not implement
+        REQUIRE_THROWS_AS(FheTaskCpu(prefix + "_cmc_relin" + lv, CpuBackend::NATIVE), std::runtime_error);
+    }
+}
+
 TEMPLATE_TEST_CASE_METHOD(CkksFixture,
                           "CKKS casc",
                           "",
@@ -661,6 +1322,136 @@ TEMPLATE_TEST_CASE_METHOD(CkksFixture,
     }
 }
 
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS linear_transform",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    const int n_diag = 16;
+    const int n1 = 4;
+    vector<int32_t> steps;
+    for (int i = 1; i < n1; i++)
+        steps.push_back(i);
+    for (int g = n1; g < n_diag; g += n1)
+        steps.push_back(g);
+
+    this->ctx.gen_rotation_keys_for_rotations(steps);
+
+    for (int level = 1; level <= this->max_level; level++) {
+        SECTION("lv=" + to_string(level)) {
+            auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+            vector<vector<CkksPlaintextMul>> d_list(this->n_op);
+            vector<vector<double>> expected(this->n_op, vector<double>(this->n_slot, 0.0));
+            for (int i = 0; i < this->n_op; i++) {
+                for (int k = 0; k < n_diag; k++) {
+                    // Diagonal k is encoded pre-rotated by its giant step, as linear_transform expects
+                    vector<double> diag = rand_double_values(this->n_slot);
+                    int giant = k - k % n1;
+                    d_list[i].push_back(this->ctx.encode_mul(vec_rotate(diag, -giant), level, this->default_scale));
+                    expected[i] = vec_add(expected[i], vec_mul(diag, vec_rotate(xv.values[i], k)));
+                }
+            }
+            vector<CkksCiphertext> y_list;
+            y_list.reserve(this->n_op);
+            for (int _i = 0; _i < this->n_op; _i++)
+                y_list.push_back(this->ctx.new_ciphertext(level, this->default_scale * this->default_scale));
+            string path = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) +
+                          "_linear_transform/level_" + to_string(level) + "/diag_" + to_string(n_diag) + "_n1_" +
+                          to_string(n1);
+            FheTaskCpu proj(path);
+            vector<CxxVectorArgument> args = {
+                {"arg_x", &xv.ciphertexts},
+                {"arg_d", &d_list},
+                {"arg_y", &y_list},
+            };
+            proj.run(&this->ctx, args);
+
+            for (int i = 0; i < this->n_op; i++)
+                verify_ckks_precision(this->ctx, expected[i], y_list[i]);
+        }
+    }
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS poly_eval",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // (task name, plaintext reference, output level = input level - 1 - ceil(log2(degree + 1)))
+    auto cubic = [](double x) { return 0.1 + 0.5 * x - 0.25 * x * x * x; };
+    auto sigmoid = [](double x) { return 1.0 / (1.0 + std::exp(-x)); };
+    vector<tuple<string, function<double(double)>, int>> cases = {{"coeffs", cubic, 3}, {"sigmoid", sigmoid, 4}};
+
+    for (int level = 4; level <= this->max_level; level++) {
+        for (const auto& [name, reference, depth] : cases) {
+            SECTION("lv=" + to_string(level) + " " + name) {
+                auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+                vector<CkksCiphertext> y_list;
+                y_list.reserve(this->n_op);
+                for (int _i = 0; _i < this->n_op; _i++)
+                    y_list.push_back(this->ctx.new_ciphertext(level - depth, this->default_scale));
+                string path = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) +
+                              "_poly_eval/level_" + to_string(level) + "/" + name;
+                FheTaskCpu proj(path);
+                vector<CxxVectorArgument> args = {
+                    {"arg_x", &xv.ciphertexts},
+                    {"arg_y", &y_list},
+                };
+                proj.run(&this->ctx, args);
+
+                for (int i = 0; i < this->n_op; i++) {
+                    vector<double> expected(xv.values[i].size());
+                    std::transform(xv.values[i].begin(), xv.values[i].end(), expected.begin(), reference);
+                    REQUIRE(y_list[i].get_level() == level - depth);
+                    verify_ckks_precision(this->ctx, expected, y_list[i]);
+                }
+            }
+        }
+    }
+}
+
+TEMPLATE_TEST_CASE_METHOD(CkksFixture,
+                          "CKKS lazy_rescale",
+                          "",
+                          CkksTestDefaultParams,
+                          CkksTestCustomParams,
+                          CkksTestSparseDefaultParams) {
+    // z = rescale(x * y) - rescale(x * x) is rewritten to rescale(x * y - x * x), and
+    // w = drop_level(x + y) to drop_level(x) + drop_level(y).
+    for (int level = 1; level <= this->max_level; level++) {
+        SECTION("lv=" + to_string(level)) {
+            auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+            auto yv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+            double out_scale = this->default_scale * this->default_scale / this->param.get_q(level);
+            vector<CkksCiphertext> z_list;
+            vector<CkksCiphertext> w_list;
+            z_list.reserve(this->n_op);
+            w_list.reserve(this->n_op);
+            for (int _i = 0; _i < this->n_op; _i++) {
+                z_list.push_back(this->ctx.new_ciphertext(level - 1, out_scale));
+                w_list.push_back(this->ctx.new_ciphertext(level - 1, this->default_scale));
+            }
+            string path = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_lazy_rescale/level_" +
+                          to_string(level);
+            FheTaskCpu proj(path);
+            vector<CxxVectorArgument> args = {
+                {"in_x_list", &xv.ciphertexts},
+                {"in_y_list", &yv.ciphertexts},
+                {"out_z_list", &z_list},
+                {"out_w_list", &w_list},
+            };
+            proj.run(&this->ctx, args);
+            for (int i = 0; i < this->n_op; i++) {
+                auto expected = vec_sub(vec_mul(xv.values[i], yv.values[i]), vec_mul(xv.values[i], xv.values[i]));
+                verify_ckks_precision(this->ctx, expected, z_list[i]);
+                verify_ckks_precision(this->ctx, vec_add(xv.values[i], yv.values[i]), w_list[i]);
+            }
+        }
+    }
+}
+
 TEMPLATE_TEST_CASE_METHOD(CkksFixture,
                           "CKKS rotate_row",
                           "",
@@ -840,6 +1631,87 @@ TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS custom encode and cap", "", CkksTes
     }
 }
 
+TEMPLATE_TEST_CASE_METHOD(CkksFixture, "CKKS async run", "", CkksTestDefaultParams) {
+    // z = x + encode(y), with a custom encode that can be made to fail or to block until released.
+    int level = 1;
+    auto xv = new_ckks_test_ct(this->n_op, this->ctx, level, this->default_scale);
+    vector<vector<double>> y_vals;
+    vector<CustomData> y_list;
+    for (int i = 0; i < this->n_op; i++) {
+        y_vals.push_back(rand_double_values(this->n_slot));
+        y_list.push_back(CustomData(y_vals[i]));
+    }
+    vector<CkksCiphertext> z_list;
+    for (int _i = 0; _i < this->n_op; _i++)
+        z_list.push_back(this->ctx.new_ciphertext(level, this->default_scale));
+
+    string path = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) +
+                  "_custom_encode_and_cap/level_" + to_string(level);
+    FheTaskCpu proj(path);
+
+    enum { ENCODE, FAIL, BLOCK };
+    std::atomic<int> mode{ENCODE};
+    std::atomic<bool> released{false};
+    std::unordered_map<std::string, ExecutorFunc> custom_executors;
+    custom_executors["encode"] = [&mode, &released](ExecutionContext& exec_ctx,
+                                                    const std::unordered_map<NodeIndex, std::any>& inputs,
+                                                    std::any& output, const ComputeNode& self) -> void {
+        if (mode == FAIL)
+            throw std::runtime_error("encode failed");
+        while (mode == BLOCK && !released)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        auto* ckks_ctx = exec_ctx.get_arithmetic_context<CkksContext>();
+        int encode_level = self.custom_prop->attributes["level"].get<int>();
+        double encode_scale = self.custom_prop->attributes["scale"].get<double>();
+        auto input_handle_ptr = std::any_cast<std::shared_ptr<CustomData>>(inputs.at(self.input_nodes[0]->index));
+        auto* msg_vec = input_handle_ptr->get_typed_data<std::vector<double>>();
+        output = std::make_shared<CkksPlaintext>(ckks_ctx->encode(*msg_vec, encode_level, encode_scale));
+    };
+    proj.bind_custom_executors(custom_executors);
+
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"in_y_list", &y_list},
+        {"out_z_list", &z_list},
+    };
+
+    SECTION("result") {
+        FheTaskRun run = proj.run_async(&this->ctx, args);
+        run.get();
+        for (int i = 0; i < this->n_op; i++)
+            verify_ckks_precision(this->ctx, vec_add(xv.values[i], y_vals[i]), z_list[i]);
+    }
+    SECTION("executor error") {
+        mode = FAIL;
+        REQUIRE_THROWS_WITH(proj.run(&this->ctx, args), "encode failed");
+        REQUIRE_THROWS_WITH(proj.run_async(&this->ctx, args).get(), "encode failed");
+    }
+    SECTION("cancel") {
+        mode = BLOCK;
+        FheTaskRun run = proj.run_async(&this->ctx, args);
+        REQUIRE_FALSE(run.wait_for(std::chrono::milliseconds(50)));
+        run.cancel();
+        released = true;
+        REQUIRE_THROWS_AS(run.get(), TaskCancelledError);
+    }
+    SECTION("deadline") {
+        mode = BLOCK;
+        FheTaskRun run = proj.run_async(&this->ctx, args, nullptr, std::chrono::milliseconds(50));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        released = true;
+        REQUIRE_THROWS_AS(run.get(), TaskCancelledError);
+    }
+    SECTION("output callback error") {
+        // The error must end the run instead of leaving it waiting for the failed job
+        proj.set_output_ready_callback(
+            [](const string&, uint64_t) { throw std::runtime_error("output callback failed"); });
+        REQUIRE_THROWS_WITH(proj.run(&this->ctx, args), "output callback failed");
+        FheTaskRun run = proj.run_async(&this->ctx, args, nullptr, std::chrono::seconds(60));
+        REQUIRE(run.wait_for(std::chrono::seconds(30)));
+        REQUIRE_THROWS_WITH(run.get(), "output callback failed");
+    }
+}
+
 // ---------------------------------------------------------------------------
 // Bootstrap tests — default param only; use CkksBtpContext
 // ---------------------------------------------------------------------------
@@ -864,6 +1736,59 @@ TEMPLATE_TEST_CASE_METHOD(CkksBtpFixture, "CKKS toy_bootstrap", "", CkksToyBtpPa
     }
 }
 
+TEMPLATE_TEST_CASE_METHOD(CkksBtpFixture, "CKKS toy_bootstrap_mixed", "", CkksToyBtpParams) {
+    // Bootstraps next to unrelated mult_relin/rescale chains. The scheduler should start the bootstraps first and
+    // overlap the chains with them, so every bootstrap must outrank every node of the cheap chains.
+    const int chain_len = 4;
+    const int chain_level = 9;
+    string path = cpu_base_path + "/" + this->tag + "/CKKS_" + to_string(this->n_op) + "_toy_bootstrap_mixed/level_0";
+
+    MegaAG mega_ag = MegaAG::load(path + "/mega_ag.json", Processor::CPU);
+    int n_bootstrap = 0;
+    int n_chain_node = 0;
+    int min_bootstrap_priority = std::numeric_limits<int>::max();
+    int max_chain_priority = std::numeric_limits<int>::min();
+    for (const auto& [index, node] : mega_ag.computes) {
+        if (!node.fhe_prop.has_value()) {
+            continue;
+        }
+        if (node.fhe_prop->op_type == OperationType::BOOTSTRAP) {
+            n_bootstrap++;
+            min_bootstrap_priority = std::min(min_bootstrap_priority, node.priority);
+        } else {
+            n_chain_node++;
+            max_chain_priority = std::max(max_chain_priority, node.priority);
+        }
+    }
+    REQUIRE(n_bootstrap == this->n_op);
+    REQUIRE(n_chain_node > 0);
+    REQUIRE(min_bootstrap_priority > max_chain_priority);
+
+    auto xv = new_ckks_test_ct(this->n_op, this->btp_ctx, 0, this->btp_scale);
+    auto av = new_ckks_test_ct(this->n_op, this->btp_ctx, chain_level, this->btp_scale);
+    vector<CkksCiphertext> y_list, b_list;
+    for (int _i = 0; _i < this->n_op; _i++) {
+        y_list.push_back(this->btp_ctx.new_ciphertext(9, this->btp_scale));
+        b_list.push_back(this->btp_ctx.new_ciphertext(chain_level - chain_len, this->btp_scale));
+    }
+    FheTaskCpu proj(path);
+    vector<CxxVectorArgument> args = {
+        {"in_x_list", &xv.ciphertexts},
+        {"out_y_list", &y_list},
+        {"in_a_list", &av.ciphertexts},
+        {"out_b_list", &b_list},
+    };
+    proj.run(&this->btp_ctx, args);
+
+    for (int i = 0; i < this->n_op; i++) {
+        verify_ckks_precision(this->btp_ctx, xv.values[i], y_list[i]);
+        vector<double> expected = av.values[i];
+        for (int k = 0; k < chain_len; k++)
+            expected = vec_mul(expected, expected);
+        verify_ckks_precision(this->btp_ctx, expected, b_list[i]);
+    }
+}
+
 TEMPLATE_TEST_CASE_METHOD(CkksBtpFixture, "CKKS bootstrap", "[.]", CkksBtpParams, CkksSparseBtpParams) {
     SECTION("lv=0") {
         auto xv = new_ckks_test_ct(this->n_op, this->btp_ctx, 0, this->btp_scale);
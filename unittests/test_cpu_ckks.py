@@ -118,6 +118,78 @@ class TestTask:
             fpga_acc=False,
         )
 
+    @pytest.mark.min_level(0)
+    def test_constant_fold(self, param, lv):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_constant_fold', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        w_list = [CkksCiphertextNode(f'w_{i}', level=lv) for i in range(N_OP)]
+        v_list = [CkksCiphertextNode(f'v_{i}', level=lv) for i in range(N_OP)]
+        c_list = [neg(add(w_list[i], v_list[i], f'wv_{i}'), f'c_{i}') for i in range(N_OP)]
+        z_list = [add(x_list[i], c_list[i], f'z_{i}') for i in range(N_OP)]
+        process_custom_task(
+            input_args=[Argument('in_x_list', x_list)],
+            offline_input_args=[Argument('in_w_list', w_list), Argument('in_v_list', v_list)],
+            output_args=[Argument('out_z_list', z_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
+    @pytest.mark.min_level(0)
+    def test_output_subset(self, param, lv):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_output_subset', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        y_list = [CkksCiphertextNode(f'y_{i}', level=lv) for i in range(N_OP)]
+        s_list = [add(x_list[i], y_list[i], f's_{i}') for i in range(N_OP)]
+        d_list = [sub(x_list[i], y_list[i], f'd_{i}') for i in range(N_OP)]
+        process_custom_task(
+            input_args=[Argument('in_x_list', x_list), Argument('in_y_list', y_list)],
+            offline_input_args=[],
+            output_args=[Argument('out_s_list', s_list), Argument('out_d_list', d_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
+    @pytest.mark.min_level(0)
+    def test_chain(self, param, lv):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_chain', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        y_list = [CkksCiphertextNode(f'y_{i}', level=lv) for i in range(N_OP)]
+        z_list = []
+        for i in range(N_OP):
+            c = x_list[i]
+            for k in range(4):
+                c = neg(c, f'c_{i}_{k}')
+            z_list.append(add(c, y_list[i], f'z_{i}'))
+        process_custom_task(
+            input_args=[Argument('in_x_list', x_list), Argument('in_y_list', y_list)],
+            offline_input_args=[],
+            output_args=[Argument('out_z_list', z_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
+    @pytest.mark.min_level(0)
+    def test_spill(self, param, lv):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_spill', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        a_list = [neg(x_list[i], f'a_{i}') for i in range(N_OP)]
+        z_list = [add(a_list[i], a_list[N_OP - 1 - i], f'z_{i}') for i in range(N_OP)]
+        process_custom_task(
+            input_args=[Argument('in_x_list', x_list)],
+            offline_input_args=[],
+            output_args=[Argument('out_z_list', z_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
     @pytest.mark.min_level(0)
     def test_casc(self, param, lv):
         set_fhe_param(param)
@@ -443,6 +515,74 @@ class TestTask:
             fpga_acc=False,
         )
 
+    @pytest.mark.min_level(1)
+    def test_linear_transform(self, param, lv, n_diag=16, n1=4):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        task_dir = os.path.join(
+            CPU_OUTPUT_BASE_DIR,
+            param_tag,
+            f'CKKS_{N_OP}_linear_transform',
+            f'level_{lv}',
+            f'diag_{n_diag}_n1_{n1}',
+        )
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        d_list = [[CkksPlaintextMulNode(f'd_{i}_{k}', level=lv) for k in range(n_diag)] for i in range(N_OP)]
+        y_list = [
+            linear_transform(x_list[i], {k: d_list[i][k] for k in range(n_diag)}, n1, f'y_{i}') for i in range(N_OP)
+        ]
+        process_custom_task(
+            input_args=[Argument('arg_x', x_list), Argument('arg_d', d_list)],
+            offline_input_args=[],
+            output_args=[Argument('arg_y', y_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
+    @pytest.mark.min_level(4)
+    def test_poly_eval(self, param, lv):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        for name, function, interval, degree in [
+            ('coeffs', [0.1, 0.5, 0.0, -0.25], (-1.0, 1.0), None),
+            ('sigmoid', 'sigmoid', (-2.0, 2.0), 7),
+        ]:
+            task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_poly_eval', f'level_{lv}', name)
+            x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+            y_list = [poly_eval(x_list[i], function, interval, degree, f'y_{i}') for i in range(N_OP)]
+            process_custom_task(
+                input_args=[Argument('arg_x', x_list)],
+                offline_input_args=[],
+                output_args=[Argument('arg_y', y_list)],
+                output_instruction_path=task_dir,
+                fpga_acc=False,
+            )
+
+    @pytest.mark.min_level(1)
+    def test_lazy_rescale(self, param, lv):
+        set_fhe_param(param)
+        param_tag = _param_tag(param)
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_lazy_rescale', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        y_list = [CkksCiphertextNode(f'y_{i}', level=lv) for i in range(N_OP)]
+        z_list, w_list = [], []
+        for i in range(N_OP):
+            xy = rescale(mult_relin(x_list[i], y_list[i]))
+            xx = rescale(mult_relin(x_list[i], x_list[i]))
+            z_list.append(sub(xy, xx, f'z_{i}'))
+            w_list.append(drop_level(add(x_list[i], y_list[i]), 1, f'w_{i}'))
+        report = lazy_rescale([Argument('out_z_list', z_list), Argument('out_w_list', w_list)])
+        assert report['rescales_sunk'] == N_OP
+        assert report['drop_levels_hoisted'] == N_OP
+        assert report['saved_ntts'] == N_OP * 2 * (lv + 1)
+        process_custom_task(
+            input_args=[Argument('in_x_list', x_list), Argument('in_y_list', y_list)],
+            offline_input_args=[],
+            output_args=[Argument('out_z_list', z_list), Argument('out_w_list', w_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
     @pytest.mark.min_level(1)
     def test_rotate_row(self, param, lv):
         set_fhe_param(param)
@@ -650,6 +790,30 @@ class TestBootstrap:
             fpga_acc=False,
         )
 
+    @pytest.mark.parametrize('lv', [0], ids=['lv0'])
+    def test_toy_bootstrap_mixed(self, lv, chain_len=4):
+        # Bootstraps next to unrelated mult_relin/rescale chains
+        set_fhe_param(_p_toy_btp)
+        param_tag = f'ckks_param_btp_n{_p_toy_btp.n}'
+        btp_level = _p_toy_btp.btp_output_level
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, param_tag, f'CKKS_{N_OP}_toy_bootstrap_mixed', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        y_list = [bootstrap(x_list[i], f'y_{i}') for i in range(N_OP)]
+        a_list = [CkksCiphertextNode(f'a_{i}', level=btp_level) for i in range(N_OP)]
+        b_list = []
+        for i in range(N_OP):
+            b = a_list[i]
+            for _ in range(chain_len):
+                b = rescale(mult_relin(b, b))
+            b_list.append(b)
+        process_custom_task(
+            input_args=[Argument('in_x_list', x_list), Argument('in_a_list', a_list)],
+            offline_input_args=[],
+            output_args=[Argument('out_y_list', y_list), Argument('out_b_list', b_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+
     @pytest.mark.parametrize('lv', [0], ids=['lv0'])
     def test_bootstrap(self, lv):
         set_fhe_param(_p_btp)
@@ -740,3 +904,23 @@ class TestBootstrap:
             output_instruction_path=task_dir,
             fpga_acc=False,
         )
+
+
+class TestAutoParam:
+    @pytest.mark.parametrize('lv', [3], ids=['lv3'])
+    def test_auto_cmc_relin_rescale(self, lv):
+        set_fhe_param(CkksParam.create_auto_param())
+        task_dir = os.path.join(CPU_OUTPUT_BASE_DIR, 'ckks_param_auto', f'CKKS_{N_OP}_cmc_relin_rescale', f'level_{lv}')
+        x_list = [CkksCiphertextNode(f'x_{i}', level=lv) for i in range(N_OP)]
+        y_list = [CkksCiphertextNode(f'y_{i}', level=lv) for i in range(N_OP)]
+        z_list = [rescale(mult_relin(x_list[i], y_list[i]), f'z_{i}') for i in range(N_OP)]
+        mag = process_custom_task(
+            input_args=[Argument('in_x_list', x_list), Argument('in_y_list', y_list)],
+            offline_input_args=[],
+            output_args=[Argument('out_z_list', z_list)],
+            output_instruction_path=task_dir,
+            fpga_acc=False,
+        )
+        # n=4096 has too few levels; n=8192 fits with its chain cut to lv + 1 primes
+        assert mag['parameter']['n'] == 8192
+        assert len(mag['parameter']['q']) == lv + 1
@@ -112,3 +112,44 @@ TEST_CASE("create_fhe_parameter returns BfvParameter for BFV cmc_relin task") {
         REQUIRE(decrypt_and_decode(ctx, z_list) == expected);
     }
 }
+
+TEST_CASE("create_fhe_parameter returns the auto-selected CkksParameter") {
+    const int n_op = 4;
+    const int level = 3;
+
+    string path =
+        test_config::cpu_base_path + "/ckks_param_auto/CKKS_" + to_string(n_op) + "_cmc_relin_rescale/level_" +
+        to_string(level);
+    FheTaskCpu task(path);
+
+    auto param_var = create_fhe_parameter(task);
+    REQUIRE(holds_alternative<CkksParameter>(param_var));
+    CkksParameter& p = get<CkksParameter>(param_var);
+    REQUIRE(p.get_n() == 8192);
+    REQUIRE(p.get_max_level() == level);
+
+    SECTION("context created from task parameter runs cmc_relin_rescale correctly") {
+        CkksContext ctx = CkksContext::create_random_context(p);
+        double scale = p.get_default_scale();
+        int n_slot = 1 << p.get_log_slots();
+
+        auto xv = new_ckks_test_ct(n_op, ctx, level, scale);
+        auto yv = new_ckks_test_ct(n_op, ctx, level, scale);
+        vector<CkksCiphertext> z_list;
+        z_list.reserve(n_op);
+        for (int i = 0; i < n_op; i++)
+            z_list.push_back(ctx.new_ciphertext(level - 1, scale));
+
+        vector<CxxVectorArgument> args = {
+            {"in_x_list", &xv.ciphertexts},
+            {"in_y_list", &yv.ciphertexts},
+            {"out_z_list", &z_list},
+        };
+        task.run(&ctx, args);
+
+        for (int i = 0; i < n_op; i++) {
+            vector<double> z = decrypt_and_decode_ckks(ctx, z_list[i]);
+            REQUIRE(compare_double_vectors(z, vec_mul(xv.values[i], yv.values[i]), n_slot, 0.01) == false);
+        }
+    }
+}
@@ -111,6 +111,30 @@ TEST_CASE_METHOD(LattigoBfvFixture, "BFV encrypt-decrypt") {
     REQUIRE(y_mg == x_mg);
 }
 
+TEST_CASE_METHOD(LattigoBfvFixture, "BFV batch encode-encrypt-decrypt-decode") {
+    const int n_item = 16;
+    vector<vector<uint64_t>> x_mgs(n_item);
+    for (int k = 0; k < n_item; k++) {
+        for (int i = 0; i < N; i++) {
+            x_mgs[k].push_back(uint64_t(i + k) % t);
+        }
+    }
+
+    for (int n_threads : {1, 4}) {
+        SECTION("threads " + to_string(n_threads)) {
+            vector<BfvPlaintext> x_pts = context.encode_batch(x_mgs, level, n_threads);
+            vector<BfvCiphertext> x_cts = context.encrypt_asymmetric_batch(x_pts, n_threads);
+            vector<BfvCiphertext> x_sym_cts = context.encrypt_symmetric_batch(x_pts, n_threads);
+            vector<vector<uint64_t>> y_mgs = context.decode_batch(context.decrypt_batch(x_cts, n_threads), n_threads);
+            vector<vector<uint64_t>> y_sym_mgs =
+                context.decode_batch(context.decrypt_batch(x_sym_cts, n_threads), n_threads);
+
+            REQUIRE(y_mgs == x_mgs);
+            REQUIRE(y_sym_mgs == x_mgs);
+        }
+    }
+}
+
 TEST_CASE_METHOD(LattigoBfvFixture, "BFV encode_coeffs-encrypt-decrypt-decode_coeffs") {
     vector<uint64_t> x_vector;
     for (int i = 0; i < N; i++) {
@@ -1198,6 +1222,34 @@ TEST_CASE_METHOD(LattigoCkksFixture, "CKKS encrypt-decrypt") {
     }
 }
 
+TEST_CASE_METHOD(LattigoCkksFixture, "CKKS batch encode-encrypt-decrypt-decode") {
+    const int n_item = 16;
+    vector<vector<double>> x_mgs(n_item);
+    for (int k = 0; k < n_item; k++) {
+        for (int i = 0; i < n_slot; i++) {
+            x_mgs[k].push_back(double(i % 64) / 64.0 + k);
+        }
+    }
+
+    for (int n_threads : {1, 4}) {
+        SECTION("threads " + to_string(n_threads)) {
+            vector<CkksPlaintext> x_pts = context.encode_batch(x_mgs, level, default_scale, n_threads);
+            vector<CkksCiphertext> x_cts = context.encrypt_asymmetric_batch(x_pts, n_threads);
+            vector<CkksCiphertext> x_sym_cts = context.encrypt_symmetric_batch(x_pts, n_threads);
+            vector<vector<double>> y_mgs = context.decode_batch(context.decrypt_batch(x_cts, n_threads), n_threads);
+            vector<vector<double>> y_sym_mgs =
+                context.decode_batch(context.decrypt_batch(x_sym_cts, n_threads), n_threads);
+
+            REQUIRE(y_mgs.size() == n_item);
+            for (int k = 0; k < n_item; k++) {
+                REQUIRE(x_cts[k].get_level() == level);
+                REQUIRE(compare_double_vectors(y_mgs[k], x_mgs[k], n_slot, 0.01) == false);
+                REQUIRE(compare_double_vectors(y_sym_mgs[k], x_mgs[k], n_slot, 0.01) == false);
+            }
+        }
+    }
+}
+
 TEST_CASE_METHOD(LattigoCkksFixture, "CKKS CompressedCiphertext encrypt-decrypt") {
     vector<double> x_mg;
     for (int i = 0; i < n_slot; i++) {